@@ -0,0 +1,332 @@
+// 性能测试, 用法: bench [gemm|lu|cholesky] [最大矩阵阶数] [最大线程数]
+//                  bench fft|polymul|polyeval [最大长度]
+//                  bench roots [批量的多项式个数]
+//                  bench vec3|transform [点数]
+//                  bench spmv|cg [网格边长]
+//                  bench eigh|svd [矩阵阶数]
+//                  bench transpose [矩阵阶数]
+//                  bench trsm [矩阵阶数]
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include <zmath.h>
+
+using namespace zmath;
+
+template <typename F>
+double timeit(F&& f) {
+    auto t0 = std::chrono::steady_clock::now();
+    f();
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(t1 - t0).count();
+}
+
+Matrix random_matrix(size_t n, unsigned seed) {
+    Matrix m(n, n);
+    unsigned s = seed;
+    for (size_t i = 0; i < n * n; i++) {
+        s = s * 1664525u + 1013904223u;
+        m.data()[i] = double(s >> 8) / double(1u << 24) - 0.5;
+    }
+    // 对角占优, 不选主元的 LU 也能稳定运行
+    for (size_t i = 0; i < n; i++) {
+        m(i, i) += double(n);
+    }
+    return m;
+}
+
+std::vector<size_t> thread_counts(size_t max_threads) {
+    std::vector<size_t> ts;
+    for (size_t t = 1; t < max_threads; t *= 2) ts.push_back(t);
+    ts.push_back(max_threads);
+    return ts;
+}
+
+// 从 1 个线程到 max_threads 个线程的加速比
+void bench_scaling(const std::string& what, size_t max_n, size_t max_threads) {
+    fmt::print("{:>6} {:>6} {:>6} {:>10} {:>10} {:>8}\n", what, "n", "thread", "seconds", "GFLOPS", "speedup");
+    for (size_t n = 512; n <= max_n; n *= 2) {
+        auto a = random_matrix(n, 1), b = random_matrix(n, 2);
+        double flops = what == "gemm" ? 2.0 * n * n * n : 2.0 / 3.0 * n * n * n;
+        if (what == "cholesky") {
+            // 对角占优的对称矩阵是正定的
+            a = a + a.T();
+            flops = 1.0 / 3.0 * n * n * n;
+        }
+        double base = 0.0;
+        for (size_t t : thread_counts(max_threads)) {
+            set_num_threads(t);
+            double sec = timeit([&] {
+                if (what == "gemm") {
+                    auto c = a * b;
+                } else if (what == "lu") {
+                    LUFactorization lu(a);
+                } else {
+                    CholeskyFactorization c(a);
+                }
+            });
+            if (t == 1) base = sec;
+            fmt::print("{:>6} {:>6} {:>6} {:>10.4f} {:>10.2f} {:>8.2f}\n", what, n, t, sec, flops / sec * 1e-9, base / sec);
+        }
+    }
+}
+
+// 每次变换的耗时, 计划只构造一次
+void bench_fft(size_t max_n) {
+    fmt::print("{:>6} {:>10} {:>12}\n", "fft", "n", "us/transform");
+    for (size_t n = 1024; n <= max_n; n *= 4) {
+        std::vector<complex> x(n, complex(1.0, 0.5));
+        auto plan = fft_plan(n);
+        const size_t reps = std::max<size_t>(1, (1 << 24) / n);
+        double sec = timeit([&] {
+            for (size_t r = 0; r < reps; r++) plan->forward(x.data());
+        });
+        fmt::print("{:>6} {:>10} {:>12.2f}\n", "fft", n, sec / reps * 1e6);
+    }
+}
+
+// 比较三种多项式乘法在等长因子下的耗时, 给出 PolyMulThresholds 的建议值
+void bench_polymul(size_t max_n) {
+    fmt::print("{:>8} {:>6} {:>12} {:>12} {:>12}\n", "polymul", "n", "naive us", "karatsuba us", "fft us");
+    size_t karatsuba_at = 0, fft_at = 0;
+    for (size_t n = 8; n <= max_n; n += n / 4) {
+        std::vector<double> a(n), b(n), out(2 * n - 1);
+        for (size_t i = 0; i < n; i++) a[i] = b[n - 1 - i] = std::sin(double(i));
+        const size_t reps = std::max<size_t>(1, (1 << 22) / (n * n));
+        double t[3];
+        PolyMulAlgo algos[3] = { PolyMulAlgo::Naive, PolyMulAlgo::Karatsuba, PolyMulAlgo::FFT };
+        for (int k = 0; k < 3; k++) {
+            t[k] = timeit([&] {
+                for (size_t r = 0; r < reps; r++) poly_mul(a.data(), n, b.data(), n, out.data(), algos[k]);
+            }) / reps * 1e6;
+        }
+        if (karatsuba_at == 0 && t[1] < t[0]) karatsuba_at = n;
+        if (fft_at == 0 && t[2] < std::min(t[0], t[1])) fft_at = n;
+        fmt::print("{:>8} {:>6} {:>12.3f} {:>12.3f} {:>12.3f}\n", "polymul", n, t[0], t[1], t[2]);
+    }
+    fmt::print("suggested thresholds: karatsuba {} fft {}\n", karatsuba_at, fft_at);
+}
+
+void bench_polyeval(size_t max_n) {
+    // 系数个数与点数相同, 点在 [-1, 1] 内
+    fmt::print("{:>8} {:>6} {:>12} {:>12} {:>12} {:>10}\n", "polyeval", "n", "scalar us", "horner us", "tree us", "tree err");
+    for (size_t n = 64; n <= max_n; n *= 2) {
+        std::vector<double> c(n), x(n), y0(n), y1(n), y2(n);
+        for (size_t i = 0; i < n; i++) {
+            c[i] = std::sin(double(i));
+            x[i] = std::cos(double(3 * i));
+        }
+        Polynomial p(c);
+        const double t0 = timeit([&] {
+            for (size_t i = 0; i < n; i++) y0[i] = p(x[i]);
+        }) * 1e6;
+        const double t1 = timeit([&] { poly_eval(c.data(), n, x.data(), n, y1.data(), PolyEvalMode::Horner); }) * 1e6;
+        const double t2 = timeit([&] { poly_eval(c.data(), n, x.data(), n, y2.data(), PolyEvalMode::SubproductTree); }) * 1e6;
+        double err = 0.0;
+        for (size_t i = 0; i < n; i++) {
+            const double d = std::abs(y2[i] - y1[i]);
+            if (!(d <= err)) err = d; // 保留 nan
+        }
+        fmt::print("{:>8} {:>6} {:>12.1f} {:>12.1f} {:>12.1f} {:>10.2e}\n", "polyeval", n, t0, t1, t2, err);
+    }
+}
+
+void bench_roots(size_t count) {
+    // 批量求同次多项式的根, 以及单个高次多项式的根
+    for (size_t deg : { 4, 8, 16 }) {
+        const size_t nc = deg + 1;
+        std::vector<double> coefs(count * nc);
+        for (size_t i = 0; i < coefs.size(); i++) coefs[i] = std::sin(double(i)) + (i % nc == 0 ? 2 : 0);
+        std::vector<complex> out(count * deg);
+        const double sec = timeit([&] { poly_roots_batch(coefs.data(), count, nc, out.data()); });
+        fmt::print("roots batch {} x deg {:>2}: {:.3f} s, {:.2f} us/poly\n", count, deg, sec, sec / count * 1e6);
+    }
+    for (size_t deg : { 500, 2000 }) {
+        std::vector<double> c(deg + 1);
+        for (size_t i = 0; i <= deg; i++) c[i] = std::cos(i * 1.3) + (i == 0 ? 2 : 0);
+        std::vector<complex> out(deg);
+        const double sec = timeit([&] { poly_roots(c.data(), c.size(), out.data()); });
+        fmt::print("roots single deg {:>4}: {:.3f} s\n", deg, sec);
+    }
+}
+
+void bench_vec3(size_t n) {
+    // 逐点的范数和夹角: AoS 的 Vec3 循环 vs SoA 的 Vec3Batch
+    std::vector<Vec3> a(n), b(n);
+    for (size_t i = 0; i < n; i++) {
+        a[i] = Vec3(std::sin(i * 0.1), std::cos(i * 0.3), std::sin(i * 0.7));
+        b[i] = Vec3(std::cos(i * 0.2), std::sin(i * 0.5), 1.0);
+    }
+    const Vec3Batch ba(a), bb(b);
+    // 输出都预先分配好, 只比较计算
+    std::vector<double> r0(n);
+    aligned_vector<double> r1(n), r2(n);
+    const double t0 = timeit([&] {
+        for (size_t i = 0; i < n; i++) r0[i] = std::hypot(a[i].x, a[i].y, a[i].z);
+    });
+    const double t1 = timeit([&] { ba.norm(r1.data(), NormMode::Safe); });
+    const double t2 = timeit([&] { ba.norm(r2.data(), NormMode::Fast); });
+    double err = 0.0;
+    for (size_t i = 0; i < n; i++) err = std::max({ err, std::abs(r1[i] - r0[i]), std::abs(r2[i] - r0[i]) });
+    fmt::print("norm n {}: hypot loop {:.3f} s, batch safe {:.3f} s, batch fast {:.3f} s, max diff {:.3e}\n",
+               n, t0, t1, t2, err);
+
+    const double t3 = timeit([&] {
+        for (size_t i = 0; i < n; i++) r0[i] = a[i].angle(b[i]);
+    });
+    const double t4 = timeit([&] { ba.angle(bb, r1.data(), NormMode::Fast); });
+    fmt::print("angle n {}: Vec3 loop {:.3f} s, batch fast {:.3f} s\n", n, t3, t4);
+}
+
+void bench_transform(size_t n) {
+    // 旋转 + 平移: 逐点 Quat::rotate, 成批 AoS, 成批 SoA
+    std::vector<Vec3> pts(n), out(n);
+    for (size_t i = 0; i < n; i++) pts[i] = Vec3(std::sin(i * 0.1), std::cos(i * 0.3), i * 1e-6);
+    const Quat q = Quat::from_axis_angle(Vec3(1, 2, 3), 0.7);
+    const Vec3 t(1, -2, 0.5);
+    const double t0 = timeit([&] {
+        for (size_t i = 0; i < n; i++) out[i] = q.rotate(pts[i]) + t;
+    });
+    const Mat4 M = affine(q, t);
+    const double t1 = timeit([&] { transform_points(M, pts.data(), n, out.data()); });
+    Vec3Batch soa(pts), soa_out(n);
+    const double t2 = timeit([&] { transform_points(M, soa, soa_out); });
+    fmt::print("transform n {}: Quat::rotate loop {:.3f} s, batch AoS {:.3f} s, batch SoA {:.3f} s\n", n, t0, t1, t2);
+}
+
+// 二维网格上 5 点差分的 Laplace 矩阵, m * m 阶
+CsrMatrix laplacian_2d(size_t m) {
+    CooMatrix coo(m * m, m * m);
+    coo.reserve(5 * m * m);
+    for (size_t i = 0; i < m; i++) {
+        for (size_t j = 0; j < m; j++) {
+            const size_t r = i * m + j;
+            coo.add(r, r, 4.0);
+            if (i > 0) coo.add(r, r - m, -1.0);
+            if (i + 1 < m) coo.add(r, r + m, -1.0);
+            if (j > 0) coo.add(r, r - 1, -1.0);
+            if (j + 1 < m) coo.add(r, r + 1, -1.0);
+        }
+    }
+    return coo.to_csr();
+}
+
+void bench_spmv(size_t m) {
+    CsrMatrix A;
+    const double ta = timeit([&] { A = laplacian_2d(m); });
+    std::vector<double> x(A.cols(), 1.0), y(A.rows());
+    const int reps = 10;
+    const double t0 = timeit([&] {
+        for (int r = 0; r < reps; r++) A.multiply(x.data(), y.data());
+    }) / reps;
+    const double t1 = timeit([&] {
+        for (int r = 0; r < reps; r++) A.multiply_transpose(x.data(), y.data());
+    }) / reps;
+    fmt::print("laplacian {}^2 nnz {}: assemble {:.3f} s, spmv {:.2f} ms ({:.2f} GFLOP/s), spmv^T {:.2f} ms\n",
+               m, A.nnz(), ta, t0 * 1e3, 2.0 * A.nnz() / t0 * 1e-9, t1 * 1e3);
+}
+
+void bench_cg(size_t m) {
+    const CsrMatrix A = laplacian_2d(m);
+    const Vector b(std::vector<double>(A.rows(), 1.0));
+    ConjugateGradient cg(IterativeOptions { 1e-8, 100000 });
+    auto run = [&](const char* name, const auto& M) {
+        IterativeResult r;
+        const double t = timeit([&] { cg.solve(A, b, M, &r); });
+        fmt::print("cg {:<8} {:.3f} s, {}\n", name, t, r.to_string());
+    };
+    fmt::print("laplacian {}^2 nnz {}\n", m, A.nnz());
+    run("none", IdentityPreconditioner());
+    run("jacobi", JacobiPreconditioner(A));
+    run("ilu0", Ilu0Preconditioner(A));
+}
+
+void bench_decomp(const std::string& what, size_t n) {
+    // 协方差形式的对称矩阵 X^T X / n
+    const Matrix X = random_matrix(n, 7);
+    Matrix C = gram(X);
+    for (size_t i = 0; i < n * n; i++) C.data()[i] /= double(n);
+    if (what == "eigh") {
+        EighResult r;
+        Vector w;
+        const double t0 = timeit([&] { r = C.eigh(); });
+        const double t1 = timeit([&] { w = C.eigvalsh(); });
+        fmt::print("eigh {}: {:.3f} s, eigvalsh {:.3f} s, max eigenvalue {:.3f}\n", n, t0, t1, r.values(n - 1));
+    } else {
+        SVDResult r;
+        Vector sv;
+        const double t0 = timeit([&] { r = X.svd(); });
+        const double t1 = timeit([&] { sv = X.singular_values(); });
+        const double t2 = timeit([&] { r = randomized_svd(C, 20); });
+        fmt::print("svd {}: {:.3f} s, singular_values {:.3f} s, randomized top-20 of covariance {:.3f} s\n",
+                   n, t0, t1, t2);
+    }
+}
+
+// 逐元素转置 (按列写目标) 与分块转置, 原地转置; A^T B 先转置再乘与直接用转置的步长
+void bench_transpose(size_t n) {
+    const Matrix A = random_matrix(n, 8), B = random_matrix(n, 9);
+    Matrix T(n, n), S = A;
+    const double t0 = timeit([&] {
+        for (size_t i = 0; i < n; i++)
+            for (size_t j = 0; j < n; j++) T(j, i) = A(i, j);
+    });
+    const double t1 = timeit([&] { T = A.T(); });
+    const double t2 = timeit([&] { S.transpose_in_place(); });
+    const double t3 = timeit([&] { Matrix At = A.T(); T = At * B; });
+    const double t4 = timeit([&] { T = A.T() * B; });
+    fmt::print("transpose {}: naive {:.4f} s, tiled {:.4f} s, in place {:.4f} s\n", n, t0, t1, t2);
+    fmt::print("A^T B: materialized {:.4f} s, lazy {:.4f} s\n", t3, t4);
+}
+
+// 三角求解: 单个右端项, n 个右端项 (左乘和右乘), 以及 LU 分解后求逆
+void bench_trsm(size_t n) {
+    Matrix L = random_matrix(n, 10);
+    for (size_t i = 0; i < n; i++) L(i, i) += double(n);
+    const Matrix B = random_matrix(n, 11);
+    Vector x(n);
+    Matrix X;
+    for (size_t i = 0; i < n; i++) x(i) = B(i, 0);
+    const double t0 = timeit([&] { trsv(Uplo::Lower, Trans::No, Diag::NonUnit, L, x); });
+    const double t1 = timeit([&] { X = B; trsm(Side::Left, Uplo::Lower, Trans::No, Diag::NonUnit, 1.0, L, X); });
+    const double t2 = timeit([&] { X = B; trsm(Side::Right, Uplo::Upper, Trans::Yes, Diag::NonUnit, 1.0, L, X); });
+    const double t3 = timeit([&] { X = L.inv(); });
+    const double flops = double(n) * double(n) * double(n);
+    fmt::print("trsm {}: trsv {:.4f} s, left {:.3f} s ({:.2f} GFLOPS), right {:.3f} s, inv {:.3f} s\n", n, t0, t1,
+               flops / t1 * 1e-9, t2, t3);
+}
+
+int main(int argc, char** argv) {
+    std::string what = argc > 1 ? argv[1] : "gemm";
+    size_t max_n = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 8192;
+    size_t max_threads = argc > 3 ? std::strtoul(argv[3], nullptr, 10)
+                                  : std::max(1u, std::thread::hardware_concurrency());
+
+    if (what == "gemm" || what == "lu" || what == "cholesky") {
+        bench_scaling(what, max_n, max_threads);
+    } else if (what == "polymul") {
+        bench_polymul(argc > 2 ? max_n : 4096);
+    } else if (what == "polyeval") {
+        bench_polyeval(argc > 2 ? max_n : 65536);
+    } else if (what == "roots") {
+        bench_roots(argc > 2 ? max_n : 100000);
+    } else if (what == "vec3") {
+        bench_vec3(argc > 2 ? max_n : size_t(1) << 24);
+    } else if (what == "transform") {
+        bench_transform(argc > 2 ? max_n : size_t(1) << 24);
+    } else if (what == "spmv") {
+        bench_spmv(argc > 2 ? max_n : 1414);
+    } else if (what == "cg") {
+        bench_cg(argc > 2 ? max_n : 300);
+    } else if (what == "eigh" || what == "svd") {
+        bench_decomp(what, argc > 2 ? max_n : 1000);
+    } else if (what == "transpose") {
+        bench_transpose(argc > 2 ? max_n : 4096);
+    } else if (what == "trsm") {
+        bench_trsm(argc > 2 ? max_n : 2048);
+    } else if (what == "fft") {
+        bench_fft(argc > 2 ? max_n : size_t(1) << 20);
+    }
+}
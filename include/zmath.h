@@ -1,5 +1,5 @@
 #pragma once
 
 #include <zmath/utils.h>
-#include <zmath/Polynomial.h>
-#include <zmath/Linalg.h>
+#include <zmath/polynomial.h>
+#include <zmath/linalg.h>
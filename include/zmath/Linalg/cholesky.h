@@ -0,0 +1,502 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+#include <zmath/utils/memory.h>
+#include "linalg.h"
+#include "gemm.h"
+#include "lu.h"
+#include "triangular.h"
+
+// 对称矩阵的分解: 正定时用 Cholesky A = R^T R, 对称拟定 (主元不为 0 但可能为负) 时用 A = U^T D U.
+// 两者都只读取上三角, 计算量和存储都是 LU 的一半
+
+namespace zmath {
+
+namespace detail {
+
+// 对称的秩 kb 更新只需要算上三角: 按 128 行一块, 每块从对角线开始向右调用一次 GEMM
+constexpr size_t syrk_row_block = 128;
+
+// A(k1:, k1:) 的上三角 -= X^T Y, X 和 Y 都是 kb x (n - k1), 第 p 行第 j 列分别在 x[p * ldx + j], y[p * ldy + j].
+// 每块的对角子块会连同下三角一起算出来, 调用者不应读取严格下三角
+inline void syrk_upper_update(MatrixView A, size_t k1, size_t kb,
+                              const double* x, size_t ldx, const double* y, size_t ldy) {
+    const size_t n = A.rows();
+    for (size_t i0 = k1; i0 < n; i0 += syrk_row_block) {
+        const size_t ib = std::min(syrk_row_block, n - i0);
+        const size_t off = i0 - k1;
+        gemm_strided(ib, n - i0, kb, -1.0, x + off, 1, ldx, y + off, ldy, 1,
+                     1.0, &A(i0, i0), A.ld());
+    }
+}
+
+// 清零严格下三角
+inline void zero_lower(Matrix& A) {
+    for (size_t i = 1; i < A.rows(); i++) {
+        std::fill(A.row_ptr(i), A.row_ptr(i) + i, 0.0);
+    }
+}
+
+}
+
+/**
+ * @brief 对称正定矩阵的 Cholesky 分解 A = R^T R, R 是对角线为正的上三角
+ *
+ * 只读取 A 的上三角. 分块的右视算法: 对角块不分块分解, 右侧的行块用 trsm 求出, 剩余部分做只算上三角的对称更新.
+ * A 不正定时 is_positive_definite() 为 false, 此时其它结果没有意义
+ */
+class CholeskyFactorization {
+public:
+    CholeskyFactorization() = default;
+
+    explicit CholeskyFactorization(const Matrix& A, size_t block = 64) {
+        factorize(A, block);
+    }
+
+    /**
+     * @brief 分解 A, 会复用已有的存储. 返回 A 是否正定
+     */
+    bool factorize(const Matrix& A, size_t block = 64) {
+        assert(A.rows() == A.cols());
+        r_ = A;
+        factorize_in_place(std::max<size_t>(block, 1));
+        detail::zero_lower(r_);
+        return positive_definite_;
+    }
+
+    size_t size() const {
+        return r_.rows();
+    }
+
+    bool is_positive_definite() const {
+        return positive_definite_;
+    }
+
+    /**
+     * @brief 上三角因子 R, 严格下三角为 0
+     */
+    const Matrix& R() const {
+        return r_;
+    }
+
+    /**
+     * @brief 下三角因子 L = R^T, A = L L^T
+     */
+    Matrix L() const {
+        return r_.T();
+    }
+
+    double det() const {
+        double det = 1.0;
+        for (size_t i = 0; i < size(); i++) {
+            det *= r_(i, i) * r_(i, i);
+        }
+        return det;
+    }
+
+    /**
+     * @brief ln det(A), 行列式上溢或下溢时仍然可用
+     */
+    double log_det() const {
+        double s = 0.0;
+        for (size_t i = 0; i < size(); i++) {
+            s += std::log(r_(i, i));
+        }
+        return 2.0 * s;
+    }
+
+    Vector solve(const Vector& b) const {
+        Vector x(size());
+        solve_into(b, x);
+        return x;
+    }
+
+    /**
+     * @brief 同时求解多个右端项 AX = B, B 的每一列是一个右端项
+     */
+    Matrix solve(const Matrix& B) const {
+        Matrix X(B.rows(), B.cols());
+        solve_into(B, X);
+        return X;
+    }
+
+    Matrix inverse() const {
+        Matrix inv(size(), size());
+        inverse_into(inv);
+        return inv;
+    }
+
+    /**
+     * @brief 解写入 x, x 的大小已经正确时不分配内存. x 可以就是 b
+     */
+    void solve_into(const Vector& b, Vector& x) const {
+        x = b;
+        solve_in_place(MatrixView(x.data(), size(), 1, 1));
+    }
+
+    void solve_into(const Matrix& B, Matrix& X) const {
+        X = B;
+        solve_in_place(X.view());
+    }
+
+    void inverse_into(Matrix& out) const {
+        detail::set_identity(out, size());
+        solve_in_place(out.view());
+    }
+
+    /**
+     * @brief 秩 1 更新: 原地变为 A + x x^T 的分解, O(n^2)
+     */
+    void update(const Vector& x) {
+        assert(x.size() == size());
+        const size_t n = size();
+        Vector w = x;
+        for (size_t k = 0; k < n; k++) {
+            double* rk = r_.row_ptr(k);
+            const double r = std::hypot(rk[k], w(k));
+            const double c = r / rk[k], s = w(k) / rk[k];
+            rk[k] = r;
+            for (size_t j = k + 1; j < n; j++) {
+                rk[j] = (rk[j] + s * w(j)) / c;
+                w(j) = c * w(j) - s * rk[j];
+            }
+        }
+    }
+
+    /**
+     * @brief 秩 1 降阶: 原地变为 A - x x^T 的分解, O(n^2)
+     *
+     * 先解 R^T a = x, ||a|| >= 1 时 A - x x^T 不正定, 返回 false 且不修改分解.
+     * 之后由下往上生成一组 Givens 旋转作用于 R (LINPACK dchdd), 比双曲旋转稳定
+     */
+    bool downdate(const Vector& x) {
+        assert(x.size() == size());
+        const size_t n = size();
+        Vector a = x;
+        trsv(Uplo::Upper, Trans::Yes, Diag::NonUnit, r_, a);
+        double norm2 = 0.0;
+        for (size_t i = 0; i < n; i++) norm2 += a(i) * a(i);
+        if (!(norm2 < 1.0)) return false;
+
+        std::vector<double> c(n), s(n);
+        double alpha = std::sqrt(1.0 - norm2);
+        for (size_t i = n; i-- > 0; ) {
+            const double scale = alpha + std::abs(a(i));
+            const double p = alpha / scale, q = a(i) / scale;
+            const double norm = std::sqrt(p * p + q * q);
+            c[i] = p / norm;
+            s[i] = q / norm;
+            alpha = scale * norm;
+        }
+
+        // 第 i 个旋转作用于 R 的第 i 行和累积行 xx, 从最后一行开始, 每次是整行的连续访问
+        std::vector<double> xx(n, 0.0);
+        for (size_t i = n; i-- > 0; ) {
+            double* ri = r_.row_ptr(i);
+            for (size_t j = i; j < n; j++) {
+                const double t = c[i] * xx[j] + s[i] * ri[j];
+                ri[j] = c[i] * ri[j] - s[i] * xx[j];
+                xx[j] = t;
+            }
+        }
+        // 旋转可能使对角元变号, 整行取反不改变 R^T R
+        for (size_t i = 0; i < n; i++) {
+            double* ri = r_.row_ptr(i);
+            if (ri[i] < 0.0) {
+                for (size_t j = i; j < n; j++) ri[j] = -ri[j];
+            }
+        }
+        return true;
+    }
+
+private:
+    Matrix r_ {0, 0};
+    bool positive_definite_ {false};
+
+    void solve_in_place(MatrixView X) const {
+        trsm(Side::Left, Uplo::Upper, Trans::Yes, Diag::NonUnit, 1.0, r_.view(), X);
+        trsm(Side::Left, Uplo::Upper, Trans::No, Diag::NonUnit, 1.0, r_.view(), X);
+    }
+
+    void factorize_in_place(size_t nb) {
+        const size_t n = r_.rows();
+        positive_definite_ = true;
+        MatrixView A = r_.view();
+
+        for (size_t k0 = 0; k0 < n; k0 += nb) {
+            const size_t kb = std::min(nb, n - k0);
+            if (!factorize_diagonal(A, k0, kb)) {
+                positive_definite_ = false;
+                return;
+            }
+
+            const size_t k1 = k0 + kb;
+            if (k1 < n) {
+                // R12 = R11^{-T} A12
+                trsm(Side::Left, Uplo::Upper, Trans::Yes, Diag::NonUnit, 1.0,
+                     A.block(k0, k0, kb, kb), A.block(k0, k1, kb, n - k1));
+                // A22 -= R12^T R12
+                const double* r12 = &A(k0, k1);
+                detail::syrk_upper_update(A, k1, kb, r12, A.ld(), r12, A.ld());
+            }
+        }
+    }
+
+    // 对角块 A(k0:k1, k0:k1) 不分块分解, 只访问上三角, 按行更新
+    static bool factorize_diagonal(MatrixView A, size_t k0, size_t kb) {
+        const size_t k1 = k0 + kb;
+        for (size_t j = k0; j < k1; j++) {
+            double* rj = A.row_ptr(j);
+            // 同时排除 NaN
+            if (!(rj[j] > 0.0)) return false;
+            rj[j] = std::sqrt(rj[j]);
+            const double d = 1.0 / rj[j];
+            for (size_t c = j + 1; c < k1; c++) rj[c] *= d;
+            for (size_t i = j + 1; i < k1; i++) {
+                double* ri = A.row_ptr(i);
+                const double rji = rj[i];
+                for (size_t c = i; c < k1; c++) {
+                    ri[c] -= rji * rj[c];
+                }
+            }
+        }
+        return true;
+    }
+};
+
+/**
+ * @brief 对称矩阵的 A = U^T D U 分解, U 是单位上三角, D 是对角阵
+ *
+ * 只读取 A 的上三角. 不选主元 (没有 Bunch-Kaufman 的对称交换), 适用于正定矩阵和对称拟定矩阵
+ * (例如 [[H, B^T], [B, -C]] 形式的鞍点系统); 一般的不定矩阵可能遇到 0 主元或数值不稳定, 应使用 lu().
+ * 与 Cholesky 相比不需要开方, 也允许负的主元
+ */
+class LDLTFactorization {
+public:
+    LDLTFactorization() = default;
+
+    explicit LDLTFactorization(const Matrix& A, size_t block = 64) {
+        factorize(A, block);
+    }
+
+    /**
+     * @brief 分解 A, 会复用已有的存储. 返回是否成功 (没有遇到 0 主元)
+     */
+    bool factorize(const Matrix& A, size_t block = 64) {
+        assert(A.rows() == A.cols());
+        ldl_ = A;
+        factorize_in_place(std::max<size_t>(block, 1));
+        detail::zero_lower(ldl_);
+        return !singular_;
+    }
+
+    size_t size() const {
+        return ldl_.rows();
+    }
+
+    /**
+     * @brief 分解时是否遇到了为 0 的主元
+     */
+    bool is_singular() const {
+        return singular_;
+    }
+
+    /**
+     * @brief D 存在对角线上, U 存在严格上三角, U 的对角线为 1, 不存储
+     */
+    const Matrix& LDLT() const {
+        return ldl_;
+    }
+
+    Vector D() const {
+        Vector d(size());
+        for (size_t i = 0; i < size(); i++) d(i) = ldl_(i, i);
+        return d;
+    }
+
+    Matrix U() const {
+        Matrix u = ldl_;
+        for (size_t i = 0; i < size(); i++) u(i, i) = 1.0;
+        return u;
+    }
+
+    double det() const {
+        double det = 1.0;
+        for (size_t i = 0; i < size(); i++) {
+            det *= ldl_(i, i);
+        }
+        return det;
+    }
+
+    /**
+     * @brief D 中负主元的个数, 即 A 的负特征值个数 (Sylvester 惯性定理)
+     */
+    size_t negative_pivots() const {
+        size_t cnt = 0;
+        for (size_t i = 0; i < size(); i++) {
+            if (ldl_(i, i) < 0.0) cnt++;
+        }
+        return cnt;
+    }
+
+    Vector solve(const Vector& b) const {
+        Vector x = b;
+        solve_in_place(MatrixView(x.data(), size(), 1, 1));
+        return x;
+    }
+
+    /**
+     * @brief 同时求解多个右端项 AX = B, B 的每一列是一个右端项
+     */
+    Matrix solve(const Matrix& B) const {
+        Matrix X = B;
+        solve_in_place(X.view());
+        return X;
+    }
+
+    Matrix inverse() const {
+        const size_t n = size();
+        Matrix I(n, n);
+        for (size_t i = 0; i < n; i++) I(i, i) = 1.0;
+        return solve(I);
+    }
+
+    /**
+     * @brief 秩 1 修正: 原地变为 A + alpha x x^T 的分解, O(n^2). alpha 可以为负.
+     *
+     * Gill-Golub-Murray-Saunders 的方法 C1. 新的主元为 0 时返回 false, 此时分解已被部分修改
+     */
+    bool update(const Vector& x, double alpha = 1.0) {
+        assert(x.size() == size());
+        const size_t n = size();
+        Vector w = x;
+        double a = alpha;
+        for (size_t j = 0; j < n; j++) {
+            double* uj = ldl_.row_ptr(j);
+            const double p = w(j);
+            const double d = uj[j] + a * p * p;
+            if (d == 0.0) {
+                singular_ = true;
+                return false;
+            }
+            const double beta = p * a / d;
+            a = uj[j] * a / d;
+            uj[j] = d;
+            for (size_t r = j + 1; r < n; r++) {
+                w(r) -= p * uj[r];
+                uj[r] += beta * w(r);
+            }
+        }
+        return true;
+    }
+
+private:
+    Matrix ldl_ {0, 0};
+    bool singular_ {false};
+    // 分块更新时保存 D1 U12
+    aligned_vector<double> work_;
+
+    void solve_in_place(MatrixView X) const {
+        trsm(Side::Left, Uplo::Upper, Trans::Yes, Diag::Unit, 1.0, ldl_.view(), X);
+        for (size_t i = 0; i < size(); i++) {
+            const double d = 1.0 / ldl_(i, i);
+            double* xi = X.row_ptr(i);
+            for (size_t j = 0; j < X.cols(); j++) xi[j] *= d;
+        }
+        trsm(Side::Left, Uplo::Upper, Trans::No, Diag::Unit, 1.0, ldl_.view(), X);
+    }
+
+    void factorize_in_place(size_t nb) {
+        const size_t n = ldl_.rows();
+        singular_ = false;
+        MatrixView A = ldl_.view();
+
+        for (size_t k0 = 0; k0 < n; k0 += nb) {
+            const size_t kb = std::min(nb, n - k0);
+            if (!factorize_diagonal(A, k0, kb)) {
+                singular_ = true;
+                return;
+            }
+
+            const size_t k1 = k0 + kb;
+            if (k1 < n) {
+                const size_t m = n - k1;
+                // W = U11^{-T} A12 = D1 U12
+                trsm(Side::Left, Uplo::Upper, Trans::Yes, Diag::Unit, 1.0,
+                     A.block(k0, k0, kb, kb), A.block(k0, k1, kb, m));
+                if (work_.size() < kb * m) work_.resize(kb * m);
+                for (size_t i = 0; i < kb; i++) {
+                    double* ri = A.row_ptr(k0 + i) + k1;
+                    std::copy(ri, ri + m, work_.data() + i * m);
+                    const double d = 1.0 / A(k0 + i, k0 + i);
+                    for (size_t j = 0; j < m; j++) ri[j] *= d;
+                }
+                // A22 -= U12^T W
+                detail::syrk_upper_update(A, k1, kb, &A(k0, k1), A.ld(), work_.data(), m);
+            }
+        }
+    }
+
+    // 对角块 A(k0:k1, k0:k1) 不分块分解, 只访问上三角, 按行更新
+    static bool factorize_diagonal(MatrixView A, size_t k0, size_t kb) {
+        const size_t k1 = k0 + kb;
+        for (size_t j = k0; j < k1; j++) {
+            double* rj = A.row_ptr(j);
+            if (rj[j] == 0.0) return false;
+            const double d = 1.0 / rj[j];
+            // 用未缩放的第 j 行更新, 再把它缩放成 U 的一行
+            for (size_t i = j + 1; i < k1; i++) {
+                double* ri = A.row_ptr(i);
+                const double uji = rj[i] * d;
+                for (size_t c = i; c < k1; c++) {
+                    ri[c] -= uji * rj[c];
+                }
+            }
+            for (size_t c = j + 1; c < k1; c++) rj[c] *= d;
+        }
+        return true;
+    }
+};
+
+inline CholeskyFactorization Matrix::cholesky() const {
+    return CholeskyFactorization(*this);
+}
+
+inline LDLTFactorization Matrix::ldlt() const {
+    return LDLTFactorization(*this);
+}
+
+namespace detail {
+
+// 对称且对角线全为正时才值得尝试 Cholesky, 其它矩阵一定不是对称正定的
+inline bool maybe_spd(const Matrix& A) {
+    if (!A.is_symmetric()) return false;
+    for (size_t i = 0; i < A.rows(); i++) {
+        if (!(A(i, i) > 0.0)) return false;
+    }
+    return true;
+}
+
+}
+
+inline Vector Matrix::solve(const Vector& b) const {
+    if (detail::maybe_spd(*this)) {
+        CholeskyFactorization c(*this);
+        if (c.is_positive_definite()) return c.solve(b);
+    }
+    return lu().solve(b);
+}
+
+inline Matrix Matrix::solve(const Matrix& B) const {
+    if (detail::maybe_spd(*this)) {
+        CholeskyFactorization c(*this);
+        if (c.is_positive_definite()) return c.solve(B);
+    }
+    return lu().solve(B);
+}
+
+}
@@ -0,0 +1,1353 @@
+#pragma once
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <zmath/utils/thread_pool.h>
+#include "linalg.h"
+#include "gemm.h"
+
+// 对称矩阵的特征分解和一般矩阵的奇异值分解.
+// 两者都先用 Householder 变换化成三对角 / 双对角矩阵: 每 nb 个反射为一个 panel, panel 内只做矩阵向量乘法,
+// 右下角子矩阵在 panel 结束后用两次 GEMM 一起更新 (LAPACK 的 sytrd / gebrd), 反射的回代也按块用 GEMM 完成.
+// 三对角矩阵的特征值用分治法: 对半分开递归求解, 合并时解久期方程, 特征向量的合并是一次 GEMM.
+// 双对角矩阵的奇异向量同样用分治法 (合并时解以 d^2 为极点的久期方程, 向量的更新是两次 GEMM), 递归到底层时用隐式 QR,
+// 每一轮的旋转攒在一起, 按列分块作用到 (转置存放的) 奇异向量上. 只要奇异值时直接用带位移的隐式 QR 迭代
+
+namespace zmath {
+
+/**
+ * @brief 对称矩阵的特征分解 A = V diag(values) V^T, 特征值升序, V 的第 j 列是 values(j) 的单位特征向量
+ */
+struct EighResult {
+    Vector values;
+    Matrix vectors;
+    bool converged = true;  // 为 false 时 QL 迭代次数达到上限, 结果不可信
+};
+
+/**
+ * @brief 瘦奇异值分解 A = U diag(S) V^T, k = min(m, n), U 是 m x k, V 是 n x k, 奇异值降序
+ */
+struct SVDResult {
+    Matrix U;
+    Vector S;
+    Matrix V;
+    bool converged = true;  // 为 false 时 (分治法底层的) QR 迭代次数达到上限, 结果不可信
+};
+
+namespace detail {
+
+// panel 宽度 (反射的个数), 也是回代时每块的反射个数
+constexpr size_t householder_block = 32;
+// 分治法递归到这个大小时改用隐式 QL
+constexpr size_t tridiag_dc_base = 32;
+// 双对角分治法递归到这个大小时改用隐式 QR
+constexpr size_t bidiag_dc_base = 32;
+
+// 对 [lo, hi) 行并行执行 f(i), 每行大约 cols 次运算
+template <typename F>
+void for_rows(size_t lo, size_t hi, size_t cols, F f) {
+    const size_t grain = std::max<size_t>(1, expr_parallel_grain / std::max<size_t>(cols, 1));
+    parallel_for(lo, hi, grain, [&](size_t a, size_t b) {
+        for (size_t i = a; i < b; i++) {
+            f(i);
+        }
+    });
+}
+
+inline double dot(const double* a, const double* b, size_t n) {
+    double s = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        s += a[i] * b[i];
+    }
+    return s;
+}
+
+/**
+ * @brief 构造 Householder 反射 H = I - tau v v^T 使 H x = (beta, 0, ..., 0), v(0) = 1 (LAPACK 的 larfg)
+ *
+ * x 的相邻元素相隔 stride, 返回 beta; x(1:) 被 v(1:) 覆盖, x(0) 不变. x(1:) 为 0 时 tau = 0
+ */
+inline double householder(double* x, size_t n, size_t stride, double& tau) {
+    const double alpha = x[0];
+    double scale = 0.0;
+    for (size_t i = 1; i < n; i++) {
+        scale = std::max(scale, std::abs(x[i * stride]));
+    }
+    if (scale == 0.0) {
+        tau = 0.0;
+        return alpha;
+    }
+    double ss = 0.0;
+    for (size_t i = 1; i < n; i++) {
+        const double t = x[i * stride] / scale;
+        ss += t * t;
+    }
+    const double beta = -std::copysign(std::hypot(alpha, scale * std::sqrt(ss)), alpha);
+    tau = (beta - alpha) / beta;
+    const double inv = 1.0 / (alpha - beta);
+    for (size_t i = 1; i < n; i++) {
+        x[i * stride] *= inv;
+    }
+    return beta;
+}
+
+/**
+ * @brief Z <- H_0 H_1 ... H_{k-1} Z, H_i = I - tau_i v_i v_i^T
+ *
+ * v_i 在第 i + shift 个分量为 1, 之前为 0, 之后的分量 j 为 v(i, j).
+ * 每 householder_block 个反射合成 I - V T V^T (LAPACK 的 larft), 用两次 GEMM 作用到 Z 上
+ */
+template <typename F>
+void apply_householder(size_t k, size_t shift, F v, const double* tau, MatrixView Z) {
+    const size_t nb = householder_block;
+    const size_t cols = Z.cols();
+    if (k == 0 || cols == 0) return;
+    Matrix Vt, T(nb, nb), Y;
+    for (size_t p0 = (k - 1) / nb * nb + nb; p0 > 0; ) {
+        p0 -= nb;
+        const size_t b = std::min(nb, k - p0);
+        const size_t r0 = p0 + shift;
+        const size_t len = Z.rows() - r0;
+        Vt = Matrix(b, len);
+        for (size_t q = 0; q < b; q++) {
+            double* vq = Vt.row_ptr(q);
+            vq[q] = 1.0;
+            for (size_t c = q + 1; c < len; c++) {
+                vq[c] = v(p0 + q, r0 + c);
+            }
+        }
+        // T 是上三角: T(q, q) = tau_q, T(0:q, q) = -tau_q T(0:q, 0:q) V(:, 0:q)^T v_q
+        for (size_t q = 0; q < b; q++) {
+            const double tq = tau[p0 + q];
+            std::vector<double> w(q);
+            for (size_t r = 0; r < q; r++) {
+                w[r] = -tq * dot(Vt.row_ptr(r) + q, Vt.row_ptr(q) + q, len - q);
+            }
+            for (size_t r = 0; r < q; r++) {
+                double s = 0.0;
+                for (size_t c = r; c < q; c++) {
+                    s += T(r, c) * w[c];
+                }
+                T(r, q) = s;
+            }
+            T(q, q) = tq;
+        }
+        MatrixView Zt = Z.block(r0, 0, len, cols);
+        Y = Matrix(b, cols);
+        gemm(1.0, Vt.view(), Zt, 0.0, Y.view());
+        // Y <- T Y, T 是上三角, 按行从上往下原地计算
+        for (size_t r = 0; r < b; r++) {
+            double* yr = Y.row_ptr(r);
+            for (size_t j = 0; j < cols; j++) {
+                yr[j] *= T(r, r);
+            }
+            for (size_t c = r + 1; c < b; c++) {
+                const double t = T(r, c);
+                const double* yc = Y.row_ptr(c);
+                for (size_t j = 0; j < cols; j++) {
+                    yr[j] += t * yc[j];
+                }
+            }
+        }
+        gemm_strided(len, cols, b, -1.0, Vt.data(), 1, Vt.ld(), Y.data(), Y.ld(), 1, 1.0, Zt.data(), Zt.ld());
+    }
+}
+
+/**
+ * @brief 把对称矩阵 A 化为三对角矩阵 T = Q^T A Q (LAPACK 的 sytrd, 按行存放)
+ *
+ * A 需要完整存放 (两个三角都要正确). 结束时 d, e 是 T 的对角线和次对角线,
+ * 第 i 个反射的 v_i 存在 A(i, i + 2:n) (v_i(i + 1) = 1), Q = H_0 ... H_{n-2}
+ */
+inline void tridiagonalize(MatrixView A, double* d, double* e, double* tau) {
+    const size_t n = A.rows();
+    if (n == 0) return;
+    const size_t nb = householder_block;
+    Matrix W(nb, std::max<size_t>(n, 1));
+    std::vector<double> t1(nb), t2(nb);
+    for (size_t p = 0; p + 1 < n; p += nb) {
+        const size_t b = std::min(nb, n - 1 - p);
+        for (size_t k = 0; k < b; k++) {
+            const size_t i = p + k;
+            double* ai = A.row_ptr(i);
+            // 本 panel 之前的反射还没有作用到第 i 行, 先补上
+            for (size_t q = 0; q < k; q++) {
+                const double* vq = A.row_ptr(p + q);
+                const double* wq = W.row_ptr(q);
+                const double vi = vq[i], wi = wq[i];
+                for (size_t j = i; j < n; j++) {
+                    ai[j] -= vi * wq[j] + wi * vq[j];
+                }
+            }
+            d[i] = ai[i];
+            const size_t len = n - i - 1;
+            e[i] = householder(ai + i + 1, len, 1, tau[i]);
+            ai[i + 1] = 1.0;
+            const double* v = ai + i + 1;
+
+            // w = tau (A v - V W^T v - W V^T v), A 是 panel 开始时的右下角, 按行做内积
+            double* w = W.row_ptr(k) + i + 1;
+            for_rows(i + 1, n, len, [&](size_t r) {
+                w[r - i - 1] = dot(A.row_ptr(r) + i + 1, v, len);
+            });
+            for (size_t q = 0; q < k; q++) {
+                t1[q] = dot(W.row_ptr(q) + i + 1, v, len);
+                t2[q] = dot(A.row_ptr(p + q) + i + 1, v, len);
+            }
+            for (size_t q = 0; q < k; q++) {
+                const double* vq = A.row_ptr(p + q) + i + 1;
+                const double* wq = W.row_ptr(q) + i + 1;
+                for (size_t j = 0; j < len; j++) {
+                    w[j] -= vq[j] * t1[q] + wq[j] * t2[q];
+                }
+            }
+            const double t = tau[i];
+            for (size_t j = 0; j < len; j++) {
+                w[j] *= t;
+            }
+            const double alpha = -0.5 * t * dot(w, v, len);
+            for (size_t j = 0; j < len; j++) {
+                w[j] += alpha * v[j];
+            }
+        }
+        // 右下角 A(s:n, s:n) -= V^T W + W^T V, V 和 W 的第 q 行分别是 v_{p+q} 和 w_q
+        const size_t s = p + b;
+        const size_t ms = n - s;
+        double* c = A.row_ptr(s) + s;
+        const double* vs = A.row_ptr(p) + s;
+        const double* ws = W.row_ptr(0) + s;
+        gemm_strided(ms, ms, b, -1.0, vs, 1, A.ld(), ws, W.ld(), 1, 1.0, c, A.ld());
+        gemm_strided(ms, ms, b, -1.0, ws, 1, W.ld(), vs, A.ld(), 1, 1.0, c, A.ld());
+        for (size_t k = 0; k < b; k++) {
+            A(p + k, p + k + 1) = e[p + k];
+        }
+    }
+    d[n - 1] = A(n - 1, n - 1);
+}
+
+/**
+ * @brief 隐式 QL 求对称三对角矩阵的特征值, vectors 为 true 时把旋转累积到 Z 的列上 (Z 通常初始为单位阵)
+ *
+ * e 的长度为 n, e(i) 连接 d(i) 和 d(i + 1), e(n - 1) 不使用; e 会被破坏. 结果没有排序.
+ * 某个特征值 60 次迭代仍未收敛时返回 false
+ */
+inline bool tridiag_ql(double* d, double* e, size_t n, MatrixView Z, bool vectors) {
+    if (n == 0) return true;
+    e[n - 1] = 0.0;
+    for (size_t l = 0; l < n; l++) {
+        size_t iter = 0;
+        size_t m;
+        do {
+            for (m = l; m + 1 < n; m++) {
+                const double dd = std::abs(d[m]) + std::abs(d[m + 1]);
+                if (std::abs(e[m]) <= DBL_EPSILON * dd) break;
+            }
+            if (m == l) break;
+            if (iter++ == 60) return false;
+            double g = (d[l + 1] - d[l]) / (2.0 * e[l]);
+            double r = std::hypot(g, 1.0);
+            g = d[m] - d[l] + e[l] / (g + std::copysign(r, g));
+            double s = 1.0, c = 1.0, p = 0.0;
+            bool underflow = false;
+            for (size_t i = m; i-- > l; ) {
+                const double f = s * e[i], b = c * e[i];
+                e[i + 1] = r = std::hypot(f, g);
+                if (r == 0.0) {
+                    d[i + 1] -= p;
+                    e[m] = 0.0;
+                    underflow = true;
+                    break;
+                }
+                s = f / r;
+                c = g / r;
+                g = d[i + 1] - p;
+                r = (d[i] - g) * s + 2.0 * c * b;
+                p = s * r;
+                d[i + 1] = g + p;
+                g = c * r - b;
+                if (vectors) {
+                    for (size_t k = 0; k < Z.rows(); k++) {
+                        const double zi = Z(k, i), zi1 = Z(k, i + 1);
+                        Z(k, i + 1) = s * zi + c * zi1;
+                        Z(k, i) = c * zi - s * zi1;
+                    }
+                }
+            }
+            if (underflow) continue;
+            d[l] -= p;
+            e[l] = g;
+            e[m] = 0.0;
+        } while (m != l);
+    }
+    return true;
+}
+
+// Q 的第 j 列换成原来的第 perm[j] 列
+inline void permute_columns(MatrixView Q, const std::vector<size_t>& perm) {
+    const size_t n = perm.size();
+    for_rows(0, Q.rows(), n, [&](size_t r) {
+        double* qr = Q.row_ptr(r);
+        std::vector<double> tmp(qr, qr + n);
+        for (size_t j = 0; j < n; j++) {
+            qr[j] = tmp[perm[j]];
+        }
+    });
+}
+
+// 特征值升序排列, Q 的列随之交换
+inline void sort_eigenpairs(double* d, size_t n, MatrixView Q) {
+    std::vector<size_t> perm(n);
+    std::iota(perm.begin(), perm.end(), size_t(0));
+    std::stable_sort(perm.begin(), perm.end(), [&](size_t a, size_t b) { return d[a] < d[b]; });
+    std::vector<double> tmp(d, d + n);
+    for (size_t j = 0; j < n; j++) {
+        d[j] = tmp[perm[j]];
+    }
+    permute_columns(Q, perm);
+}
+
+/**
+ * @brief 久期方程 1 + rho sum_l z_l^2 / (d_l - lambda) = 0 的第 j 个根 (d 严格升序, rho > 0)
+ *
+ * 根表示为 d(org) + tau, org 是离根较近的极点, 这样 d_l - lambda = (d_l - d_org) - tau 没有相消误差.
+ * 在根所在的区间内用带二分保护的 Newton 迭代
+ */
+inline void secular_root(const double* dk, const double* zk, size_t K, double rho, size_t j, size_t& org, double& tau) {
+    auto f = [&](size_t o, double t, double& fp) {
+        double s = 1.0, sp = 0.0;
+        for (size_t l = 0; l < K; l++) {
+            const double q = zk[l] / ((dk[l] - dk[o]) - t);
+            s += rho * zk[l] * q;
+            sp += rho * q * q;
+        }
+        fp = sp;
+        return s;
+    };
+    double lo, hi, fp;
+    if (j + 1 < K) {
+        const double mid = (dk[j + 1] - dk[j]) / 2;
+        if (f(j, mid, fp) >= 0.0) {
+            org = j;
+            lo = 0.0;
+            hi = mid;
+        } else {
+            org = j + 1;
+            lo = -mid;
+            hi = 0.0;
+        }
+    } else {
+        // 最大的根不超过 d_{K-1} + rho |z|^2
+        org = j;
+        lo = 0.0;
+        hi = rho * dot(zk, zk, K);
+    }
+    double t = (lo + hi) / 2;
+    for (int it = 0; it < 200; it++) {
+        const double fv = f(org, t, fp);
+        if (fv == 0.0) break;
+        if (fv > 0.0) {
+            hi = t;
+        } else {
+            lo = t;
+        }
+        double tn = t - fv / fp;
+        if (!(tn > lo && tn < hi)) {
+            tn = (lo + hi) / 2;
+        }
+        const bool done = std::abs(tn - t) <= 4 * DBL_EPSILON * std::abs(tn) ||
+                          hi - lo <= 4 * DBL_EPSILON * std::max(std::abs(lo), std::abs(hi));
+        t = tn;
+        if (done) break;
+    }
+    tau = t;
+}
+
+/**
+ * @brief 分治法的合并: Q = diag(Q1, Q2) 已经是两个子问题的特征向量, d 是它们的特征值,
+ * 求 diag(d) + rho z z^T 的特征分解并更新 d 和 Q
+ */
+inline void tridiag_dc_merge(double* d, size_t n, size_t m, double rho, double sgn, MatrixView Q) {
+    // z 由 Q1 的最后一行和 Q2 的第一行组成, |z| = sqrt(2)
+    std::vector<double> z(n);
+    for (size_t i = 0; i < m; i++) {
+        z[i] = Q(m - 1, i) / std::sqrt(2.0);
+    }
+    for (size_t i = m; i < n; i++) {
+        z[i] = sgn * Q(m, i) / std::sqrt(2.0);
+    }
+    rho *= 2.0;
+
+    std::vector<size_t> perm(n);
+    std::iota(perm.begin(), perm.end(), size_t(0));
+    std::stable_sort(perm.begin(), perm.end(), [&](size_t a, size_t b) { return d[a] < d[b]; });
+    std::vector<double> dp(n), zp(n);
+    double dmax = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        dp[i] = d[perm[i]];
+        zp[i] = z[perm[i]];
+        dmax = std::max(dmax, std::abs(dp[i]));
+    }
+    Matrix Qp(n, n);
+    for_rows(0, n, n, [&](size_t r) {
+        const double* qr = Q.row_ptr(r);
+        double* pr = Qp.row_ptr(r);
+        for (size_t j = 0; j < n; j++) {
+            pr[j] = qr[perm[j]];
+        }
+    });
+
+    // 收缩: z 的分量很小, 或者两个 d 很接近 (用 Givens 旋转把其中一个 z 分量消成 0) 时,
+    // 对应的特征对直接保留, 不进入久期方程
+    const double tol = 8.0 * DBL_EPSILON * std::max(dmax, rho);
+    std::vector<size_t> nd;
+    for (size_t i = 0; i < n; i++) {
+        if (rho * std::abs(zp[i]) <= tol) continue;
+        if (!nd.empty()) {
+            const size_t j = nd.back();
+            const double r = std::hypot(zp[i], zp[j]);
+            const double c = zp[i] / r, s = zp[j] / r;
+            if (std::abs((dp[i] - dp[j]) * c * s) <= tol) {
+                zp[j] = 0.0;
+                zp[i] = r;
+                const double dj = c * c * dp[j] + s * s * dp[i];
+                const double di = s * s * dp[j] + c * c * dp[i];
+                dp[j] = dj;
+                dp[i] = di;
+                for (size_t k = 0; k < n; k++) {
+                    const double qj = Qp(k, j), qi = Qp(k, i);
+                    Qp(k, j) = c * qj - s * qi;
+                    Qp(k, i) = s * qj + c * qi;
+                }
+                nd.pop_back();
+            }
+        }
+        nd.push_back(i);
+    }
+
+    const size_t K = nd.size();
+    std::vector<double> dk(K), zk(K), tau(K), zh(K);
+    std::vector<size_t> org(K);
+    for (size_t t = 0; t < K; t++) {
+        dk[t] = dp[nd[t]];
+        zk[t] = zp[nd[t]];
+    }
+    parallel_for(0, K, 16, [&](size_t lo, size_t hi) {
+        for (size_t j = lo; j < hi; j++) {
+            secular_root(dk.data(), zk.data(), K, rho, j, org[j], tau[j]);
+        }
+    });
+    // d_i - lambda_j
+    auto delta = [&](size_t j, size_t i) {
+        return (dk[i] - dk[org[j]]) - tau[j];
+    };
+    // 由算出的特征值反推 z (Gu-Eisenstat), 这样特征向量在数值上也是正交的
+    parallel_for(0, K, 64, [&](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; i++) {
+            double p = -delta(i, i) / rho;
+            for (size_t j = 0; j < K; j++) {
+                if (j != i) {
+                    p *= -delta(j, i) / (dk[j] - dk[i]);
+                }
+            }
+            zh[i] = std::copysign(std::sqrt(std::max(p, 0.0)), zk[i]);
+        }
+    });
+    // Ut 的第 j 行是 diag(dk) + rho zh zh^T 的第 j 个特征向量 (dk - lambda_j)^{-1} zh
+    Matrix Ut(K, K), Qk(n, K), R(n, K);
+    for_rows(0, K, K, [&](size_t j) {
+        double* u = Ut.row_ptr(j);
+        double ss = 0.0;
+        for (size_t i = 0; i < K; i++) {
+            u[i] = zh[i] / delta(j, i);
+            ss += u[i] * u[i];
+        }
+        const double inv = 1.0 / std::sqrt(ss);
+        for (size_t i = 0; i < K; i++) {
+            u[i] *= inv;
+        }
+    });
+    for_rows(0, n, K, [&](size_t r) {
+        for (size_t t = 0; t < K; t++) {
+            Qk(r, t) = Qp(r, nd[t]);
+        }
+    });
+    gemm_strided(n, K, K, 1.0, Qk.data(), Qk.ld(), 1, Ut.data(), 1, Ut.ld(), 0.0, R.data(), R.ld());
+
+    // 收缩的特征对和新算出的特征对一起按特征值升序写回
+    std::vector<std::pair<double, size_t>> order; // (特征值, 来源列), 来源 >= n 表示 R 的第 (来源 - n) 列
+    std::vector<char> is_nd(n, 0);
+    for (size_t t = 0; t < K; t++) {
+        is_nd[nd[t]] = 1;
+        order.emplace_back(dk[org[t]] + tau[t], n + t);
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (!is_nd[i]) {
+            order.emplace_back(dp[i], i);
+        }
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (size_t c = 0; c < n; c++) {
+        d[c] = order[c].first;
+    }
+    for_rows(0, n, n, [&](size_t r) {
+        double* qr = Q.row_ptr(r);
+        for (size_t c = 0; c < n; c++) {
+            const size_t src = order[c].second;
+            qr[c] = src >= n ? R(r, src - n) : Qp(r, src);
+        }
+    });
+}
+
+/**
+ * @brief 分治法求对称三对角矩阵的特征分解, 特征值升序写回 d, 特征向量写入 Q 的列. e 会被破坏.
+ * 底层的 QL 未收敛时返回 false
+ */
+inline bool tridiag_dc(double* d, double* e, size_t n, MatrixView Q) {
+    if (n == 0) return true;
+    if (n <= tridiag_dc_base) {
+        std::vector<double> ee(n, 0.0);
+        std::copy(e, e + n - 1, ee.begin());
+        for (size_t i = 0; i < n; i++) {
+            std::fill(Q.row_ptr(i), Q.row_ptr(i) + n, 0.0);
+            Q(i, i) = 1.0;
+        }
+        const bool converged = tridiag_ql(d, ee.data(), n, Q, true);
+        sort_eigenpairs(d, n, Q);
+        return converged;
+    }
+    // T = diag(T1, T2) + rho w w^T, w = e_{m-1} + sgn e_m
+    const size_t m = n / 2;
+    const double beta = e[m - 1];
+    const double rho = std::abs(beta);
+    const double sgn = beta < 0.0 ? -1.0 : 1.0;
+    d[m - 1] -= rho;
+    d[m] -= rho;
+    for (size_t i = 0; i < m; i++) {
+        std::fill(Q.row_ptr(i) + m, Q.row_ptr(i) + n, 0.0);
+    }
+    for (size_t i = m; i < n; i++) {
+        std::fill(Q.row_ptr(i), Q.row_ptr(i) + m, 0.0);
+    }
+    const bool c1 = tridiag_dc(d, e, m, Q.block(0, 0, m, m));
+    const bool c2 = tridiag_dc(d + m, e + m, n - m, Q.block(m, m, n - m, n - m));
+    tridiag_dc_merge(d, n, m, rho, sgn, Q);
+    return c1 && c2;
+}
+
+/**
+ * @brief 把 A (m x n, m >= n) 化为上双对角矩阵 B = Q^T A P (LAPACK 的 gebrd / labrd)
+ *
+ * 结束时 d, e 是 B 的对角线和上次对角线. 左反射 u_i 存在 A(i + 1:m, i) (u_i(i) = 1),
+ * 右反射 v_i 存在 A(i, i + 2:n) (v_i(i + 1) = 1); Q = H_0 ... H_{n-1}, P = G_0 ... G_{n-2}
+ */
+inline void bidiagonalize(MatrixView A, double* d, double* e, double* tauq, double* taup) {
+    const size_t m = A.rows(), n = A.cols();
+    const size_t nb = householder_block;
+    // X 和 Y 按列存放更新量, 这里存它们的转置, 每列连续
+    Matrix Xt(nb, std::max<size_t>(m, 1)), Yt(nb, std::max<size_t>(n, 1));
+    std::vector<double> t1(nb + 1), t2(nb + 1), u(m);
+    for (size_t p = 0; p < n; p += nb) {
+        const size_t b = std::min(nb, n - p);
+        for (size_t k = 0; k < b; k++) {
+            const size_t i = p + k;
+            // 更新第 i 列: A(i:m, i) -= A(i:m, p:i) Y(i, :)^T + X(i:m, :) A(p:i, i)
+            for_rows(i, m, 2 * k, [&](size_t r) {
+                const double* ar = A.row_ptr(r);
+                double s = 0.0;
+                for (size_t q = 0; q < k; q++) {
+                    s += ar[p + q] * Yt(q, i) + Xt(q, r) * A(p + q, i);
+                }
+                A(r, i) -= s;
+            });
+            // 左反射, u_i 同时拷一份到连续的 u
+            d[i] = householder(&A(i, i), m - i, A.ld(), tauq[i]);
+            A(i, i) = 1.0;
+            for (size_t r = i; r < m; r++) {
+                u[r] = A(r, i);
+            }
+            if (i + 1 == n) {
+                taup[i] = 0.0;
+                continue;
+            }
+            const size_t len = n - i - 1;
+
+            // Y(i+1:n, k) = tauq (A^T u - Y (A(i:m, p:i)^T u) - A(p:i, :)^T (X^T u)), 各列按块并行, 逐行累加
+            double* y = Yt.row_ptr(k) + i + 1;
+            parallel_for(0, len, 256, [&](size_t lo, size_t hi) {
+                std::fill(y + lo, y + hi, 0.0);
+                for (size_t r = i; r < m; r++) {
+                    const double ur = u[r];
+                    const double* ar = A.row_ptr(r) + i + 1;
+                    for (size_t j = lo; j < hi; j++) {
+                        y[j] += ur * ar[j];
+                    }
+                }
+            });
+            for (size_t q = 0; q < k; q++) {
+                double s1 = 0.0, s2 = 0.0;
+                for (size_t r = i; r < m; r++) {
+                    s1 += A(r, p + q) * u[r];
+                    s2 += Xt(q, r) * u[r];
+                }
+                t1[q] = s1;
+                t2[q] = s2;
+            }
+            for (size_t q = 0; q < k; q++) {
+                const double* yq = Yt.row_ptr(q) + i + 1;
+                const double* aq = A.row_ptr(p + q) + i + 1;
+                for (size_t j = 0; j < len; j++) {
+                    y[j] -= yq[j] * t1[q] + aq[j] * t2[q];
+                }
+            }
+            for (size_t j = 0; j < len; j++) {
+                y[j] *= tauq[i];
+            }
+
+            // 更新第 i 行: A(i, i+1:n) -= A(i, p:i+1) Y^T + X(i, :) A(p:i, i+1:n)
+            double* ai = A.row_ptr(i) + i + 1;
+            for (size_t q = 0; q <= k; q++) {
+                const double aq = A(i, p + q);
+                const double* yq = Yt.row_ptr(q) + i + 1;
+                for (size_t j = 0; j < len; j++) {
+                    ai[j] -= yq[j] * aq;
+                }
+            }
+            for (size_t q = 0; q < k; q++) {
+                const double xq = Xt(q, i);
+                const double* aq = A.row_ptr(p + q) + i + 1;
+                for (size_t j = 0; j < len; j++) {
+                    ai[j] -= aq[j] * xq;
+                }
+            }
+
+            // 右反射
+            e[i] = householder(ai, len, 1, taup[i]);
+            ai[0] = 1.0;
+            // X(i+1:m, k) = taup (A v - A(:, p:i+1) (Y^T v) - X (A(p:i, :) v)), 按行做内积
+            for (size_t q = 0; q <= k; q++) {
+                t1[q] = dot(Yt.row_ptr(q) + i + 1, ai, len);
+            }
+            for (size_t q = 0; q < k; q++) {
+                t2[q] = dot(A.row_ptr(p + q) + i + 1, ai, len);
+            }
+            double* x = Xt.row_ptr(k);
+            for_rows(i + 1, m, len, [&](size_t r) {
+                const double* ar = A.row_ptr(r);
+                double s = dot(ar + i + 1, ai, len);
+                for (size_t q = 0; q <= k; q++) {
+                    s -= ar[p + q] * t1[q];
+                }
+                for (size_t q = 0; q < k; q++) {
+                    s -= Xt(q, r) * t2[q];
+                }
+                x[r] = taup[i] * s;
+            });
+        }
+        // 右下角 A(s:m, s:n) -= U Y^T + X V, U, V 分别是本 panel 的左右反射
+        const size_t s = p + b;
+        if (s < n) {
+            double* c = A.row_ptr(s) + s;
+            gemm_strided(m - s, n - s, b, -1.0, A.row_ptr(s) + p, A.ld(), 1, Yt.row_ptr(0) + s, Yt.ld(), 1,
+                         1.0, c, A.ld());
+            gemm_strided(m - s, n - s, b, -1.0, Xt.row_ptr(0) + s, 1, Xt.ld(), A.row_ptr(p) + s, A.ld(), 1,
+                         1.0, c, A.ld());
+        }
+        for (size_t k = 0; k < b; k++) {
+            const size_t i = p + k;
+            A(i, i) = d[i];
+            if (i + 1 < n) {
+                A(i, i + 1) = e[i];
+            }
+        }
+    }
+}
+
+// M 的第 k, k + 1 行 (k = lo .. lo + cnt - 1 依次) 做旋转 (x, y) -> (c x + s y, -s x + c y).
+// 列切成小块并行, 每块在缓存里做完整轮旋转, 内层循环沿行连续, 可以向量化
+inline void rotate_rows(MatrixView M, size_t lo, size_t cnt, const double* c, const double* s) {
+    if (cnt == 0) return;
+    const size_t grain = std::max<size_t>(64, expr_parallel_grain / (4 * cnt));
+    parallel_for(0, M.cols(), grain, [&](size_t j0, size_t j1) {
+        for (size_t t = 0; t < cnt; t++) {
+            double* x = M.row_ptr(lo + t);
+            double* y = M.row_ptr(lo + t + 1);
+            const double ct = c[t], st = s[t];
+            for (size_t j = j0; j < j1; j++) {
+                const double a = x[j], b = y[j];
+                x[j] = ct * a + st * b;
+                y[j] = -st * a + ct * b;
+            }
+        }
+    });
+}
+
+// M 的第 j, k 行做旋转 (x, y) -> (c x + s y, -s x + c y)
+inline void rotate_pair(MatrixView M, size_t j, size_t k, double c, double s) {
+    double* x = M.row_ptr(j);
+    double* y = M.row_ptr(k);
+    for (size_t i = 0; i < M.cols(); i++) {
+        const double a = x[i], b = y[i];
+        x[i] = c * a + s * b;
+        y[i] = -s * a + c * b;
+    }
+}
+
+/**
+ * @brief 上双对角矩阵 B (对角线 d, 上次对角线 e) 的奇异值分解, 带 Wilkinson 位移的隐式 QR (Golub-Kahan)
+ *
+ * vectors 为 true 时 Ut, Vt (n x n, 初始为单位阵) 累积左右旋转, 结束时 B = Ut^T diag(d) Vt.
+ * 奇异向量存成行, 旋转作用在相邻的两行上. d 非负但没有排序. 迭代次数达到上限时返回 false
+ */
+inline bool bidiag_qr(double* d, double* e, size_t n, MatrixView Ut, MatrixView Vt, bool vectors) {
+    if (n == 0) return true;
+    // 缩放到最大元素为 1, 平方时不会溢出
+    double scale = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        scale = std::max(scale, std::abs(d[i]));
+        if (i + 1 < n) scale = std::max(scale, std::abs(e[i]));
+    }
+    if (scale == 0.0) return true;
+    for (size_t i = 0; i < n; i++) {
+        d[i] /= scale;
+        if (i + 1 < n) e[i] /= scale;
+    }
+    const double eps = DBL_EPSILON;
+    std::vector<double> cu(n), su(n), cv(n), sv(n);
+    size_t hi = n - 1;
+    size_t iter = 0;
+    const size_t max_iter = 6 * n * n + 100;
+    while (hi > 0 && iter < max_iter) {
+        if (std::abs(e[hi - 1]) <= eps * (std::abs(d[hi - 1]) + std::abs(d[hi]))) {
+            e[hi - 1] = 0.0;
+            hi--;
+            continue;
+        }
+        size_t lo = hi - 1;
+        while (lo > 0 && std::abs(e[lo - 1]) > eps * (std::abs(d[lo - 1]) + std::abs(d[lo]))) {
+            lo--;
+        }
+        if (lo > 0) {
+            e[lo - 1] = 0.0;
+        }
+        iter++;
+
+        // 对角元为 0 时 B 奇异, 用旋转把同一行 (或最后一列) 的次对角元消去, 块就分开了
+        size_t k = lo;
+        while (k < hi && std::abs(d[k]) > eps) k++;
+        if (k < hi) {
+            double x = e[k];
+            e[k] = 0.0;
+            d[k] = 0.0;
+            for (size_t j = k + 1; j <= hi; j++) {
+                const double r = std::hypot(d[j], x);
+                const double c = d[j] / r, s = x / r;
+                d[j] = r;
+                if (vectors) rotate_pair(Ut, j, k, c, s);
+                if (j < hi) {
+                    x = -s * e[j];
+                    e[j] = c * e[j];
+                }
+            }
+            continue;
+        }
+        if (std::abs(d[hi]) <= eps) {
+            double x = e[hi - 1];
+            e[hi - 1] = 0.0;
+            d[hi] = 0.0;
+            for (size_t j = hi; j-- > lo; ) {
+                const double r = std::hypot(d[j], x);
+                const double c = d[j] / r, s = x / r;
+                d[j] = r;
+                if (vectors) rotate_pair(Vt, j, hi, c, s);
+                if (j > lo) {
+                    x = -s * e[j - 1];
+                    e[j - 1] = c * e[j - 1];
+                }
+            }
+            continue;
+        }
+
+        // B^T B 右下角 2x2 块中更接近右下角元素的特征值作为位移
+        const double t11 = d[hi - 1] * d[hi - 1] + (hi - 1 > lo ? e[hi - 2] * e[hi - 2] : 0.0);
+        const double t12 = d[hi - 1] * e[hi - 1];
+        const double t22 = d[hi] * d[hi] + e[hi - 1] * e[hi - 1];
+        const double delta = (t11 - t22) / 2;
+        const double mu = t12 == 0.0 ? t22 : t22 - t12 * t12 / (delta + std::copysign(std::hypot(delta, t12), delta));
+
+        // 一轮 bulge chasing: 右旋转作用于第 k, k+1 列, 左旋转作用于第 k, k+1 行
+        double y = d[lo] * d[lo] - mu, z = d[lo] * e[lo];
+        for (size_t k2 = lo; k2 < hi; k2++) {
+            double r = std::hypot(y, z);
+            double c = r != 0.0 ? y / r : 1.0, s = r != 0.0 ? z / r : 0.0;
+            if (k2 > lo) e[k2 - 1] = r;
+            cv[k2 - lo] = c;
+            sv[k2 - lo] = s;
+            const double dk = d[k2], ek = e[k2];
+            d[k2] = c * dk + s * ek;
+            e[k2] = -s * dk + c * ek;
+            const double bulge = s * d[k2 + 1];
+            d[k2 + 1] *= c;
+
+            r = std::hypot(d[k2], bulge);
+            c = r != 0.0 ? d[k2] / r : 1.0;
+            s = r != 0.0 ? bulge / r : 0.0;
+            d[k2] = r;
+            cu[k2 - lo] = c;
+            su[k2 - lo] = s;
+            const double ek2 = e[k2], dk1 = d[k2 + 1];
+            e[k2] = c * ek2 + s * dk1;
+            d[k2 + 1] = -s * ek2 + c * dk1;
+            if (k2 + 1 < hi) {
+                y = e[k2];
+                z = s * e[k2 + 1];
+                e[k2 + 1] *= c;
+            }
+        }
+        if (vectors) {
+            rotate_rows(Vt, lo, hi - lo, cv.data(), sv.data());
+            rotate_rows(Ut, lo, hi - lo, cu.data(), su.data());
+        }
+    }
+    const bool converged = iter < max_iter;
+    for (size_t i = 0; i < n; i++) {
+        if (d[i] < 0.0) {
+            d[i] = -d[i];
+            if (vectors) {
+                double* v = Vt.row_ptr(i);
+                for (size_t j = 0; j < n; j++) v[j] = -v[j];
+            }
+        }
+        d[i] *= scale;
+    }
+    return converged;
+}
+
+/**
+ * @brief 分治法的底层: n x (n + sqre) 上双对角矩阵 (sqre 为 0 或 1) 的奇异值分解, 用隐式 QR
+ *
+ * sqre 为 1 时多出的一列 (e[n - 1]) 先用右旋转消去, 化成方阵. 结束时 B = U [diag(d) 0] W^T,
+ * U 是 n x n, W 是 (n + sqre) x (n + sqre), d 升序
+ */
+inline bool bidiag_dc_leaf(double* d, double* e, size_t n, size_t sqre, MatrixView U, MatrixView W) {
+    // 第 i 个旋转作用于第 i 列和第 n 列, 从最后一行往上把多出的一列逐个消成 0
+    std::vector<double> gc(n, 1.0), gs(n, 0.0);
+    if (sqre) {
+        double x = e[n - 1];
+        for (size_t i = n; i-- > 0; ) {
+            const double r = std::hypot(d[i], x);
+            const double c = r != 0.0 ? d[i] / r : 1.0, s = r != 0.0 ? x / r : 0.0;
+            d[i] = r;
+            gc[i] = c;
+            gs[i] = s;
+            if (i > 0) {
+                x = -s * e[i - 1];
+                e[i - 1] *= c;
+            }
+        }
+    }
+    Matrix Ut(n, n), Vt(n, n);
+    for (size_t i = 0; i < n; i++) {
+        Ut(i, i) = 1.0;
+        Vt(i, i) = 1.0;
+    }
+    const bool converged = bidiag_qr(d, e, n, Ut.view(), Vt.view(), true);
+
+    std::vector<size_t> perm(n);
+    std::iota(perm.begin(), perm.end(), size_t(0));
+    std::stable_sort(perm.begin(), perm.end(), [&](size_t a, size_t b) { return d[a] < d[b]; });
+    std::vector<double> tmp(d, d + n);
+    for (size_t j = 0; j < n; j++) {
+        d[j] = tmp[perm[j]];
+    }
+    for (size_t i = 0; i < n + sqre; i++) {
+        std::fill(W.row_ptr(i), W.row_ptr(i) + n + sqre, 0.0);
+    }
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < n; j++) {
+            U(i, j) = Ut(perm[j], i);
+            W(i, j) = Vt(perm[j], i);
+        }
+    }
+    if (sqre) {
+        // B G_{n-1} ... G_0 = [B' 0], 所以 W = G_{n-1} ... G_0 diag(W', 1), 最里面的 G_0 先作用
+        W(n, n) = 1.0;
+        for (size_t i = 0; i < n; i++) {
+            double* wi = W.row_ptr(i);
+            double* wn = W.row_ptr(n);
+            for (size_t j = 0; j <= n; j++) {
+                const double a = wi[j], b = wn[j];
+                wi[j] = gc[i] * a - gs[i] * b;
+                wn[j] = gs[i] * a + gc[i] * b;
+            }
+        }
+    }
+    return converged;
+}
+
+/**
+ * @brief 双对角分治法的合并 (Gu-Eisenstat, LAPACK 的 lasd1 ~ lasd3)
+ *
+ * 第 k 行把矩阵分成 B1 (k x (k + 1)) 和 B2 ((n - k - 1) x (n - k - 1 + sqre)), U = diag(U1, 1, U2) 和
+ * W = diag(W1, W2) 已经是两个子问题的奇异向量. 中间一行是 alpha 和 beta 乘上 W1 的最后一行和 W2 的第一行,
+ * 于是 B = U M W^T, M 除第 k 行 (z) 外是对角阵 diag(d), d_k 取 0. M^T M = diag(d^2) + z z^T,
+ * 所以 sigma^2 是以 d^2 为极点的久期方程的根, 与三对角的合并共用 secular_root
+ */
+inline void bidiag_dc_merge(double* d, size_t n, size_t k, size_t sqre, double alpha, double beta,
+                            MatrixView U, MatrixView W) {
+    const size_t m = n + sqre;
+    std::vector<double> z(n);
+    for (size_t c = 0; c <= k; c++) {
+        z[c] = alpha * W(k, c);
+    }
+    for (size_t c = k + 1; c < n; c++) {
+        z[c] = beta * W(k + 1, c);
+    }
+    if (sqre) {
+        // W1 和 W2 的零空间方向 (第 k 列和最后一列) 合成一列, 另一列仍是 M 的零空间
+        const double x = beta * W(k + 1, n);
+        const double r = std::hypot(z[k], x);
+        const double c = r != 0.0 ? z[k] / r : 1.0, s = r != 0.0 ? x / r : 0.0;
+        for_rows(0, m, 4, [&](size_t i) {
+            double* wi = W.row_ptr(i);
+            const double a = wi[k], b = wi[n];
+            wi[k] = c * a + s * b;
+            wi[n] = -s * a + c * b;
+        });
+        z[k] = r;
+    }
+    d[k] = 0.0;
+
+    // 第 0 个位置是 z 所在的行 (极点为 0), 其余按 d 升序
+    std::vector<size_t> perm;
+    perm.reserve(n);
+    perm.push_back(k);
+    for (size_t i = 0; i < n; i++) {
+        if (i != k) perm.push_back(i);
+    }
+    std::stable_sort(perm.begin() + 1, perm.end(), [&](size_t a, size_t b) { return d[a] < d[b]; });
+    std::vector<double> dp(n), zp(n);
+    double scale = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        dp[i] = d[perm[i]];
+        zp[i] = z[perm[i]];
+        scale = std::max({ scale, std::abs(dp[i]), std::abs(zp[i]) });
+    }
+    Matrix Up(n, n), Wp(m, n);
+    for_rows(0, m, n, [&](size_t r) {
+        const double* wr = W.row_ptr(r);
+        double* pr = Wp.row_ptr(r);
+        for (size_t j = 0; j < n; j++) {
+            pr[j] = wr[perm[j]];
+        }
+        if (r < n) {
+            const double* ur = U.row_ptr(r);
+            double* qr = Up.row_ptr(r);
+            for (size_t j = 0; j < n; j++) {
+                qr[j] = ur[perm[j]];
+            }
+        }
+    });
+    auto rotate_cols = [](MatrixView X, size_t j, size_t i, double c, double s) {
+        for (size_t r = 0; r < X.rows(); r++) {
+            const double xj = X(r, j), xi = X(r, i);
+            X(r, j) = c * xj - s * xi;
+            X(r, i) = s * xj + c * xi;
+        }
+    };
+
+    // 收缩: z 的分量很小; d 接近 0, 用右旋转把 z 分量并入第 0 个; 两个 d 很接近, 左右同一个旋转消去一个 z 分量.
+    // 收缩的奇异值就是对应的 d, 奇异向量不变
+    const double tol = 8.0 * DBL_EPSILON * scale;
+    std::vector<size_t> nd { 0 };
+    for (size_t i = 1; i < n; i++) {
+        if (std::abs(zp[i]) <= tol) continue;
+        if (dp[i] <= tol) {
+            const double r = std::hypot(zp[0], zp[i]);
+            const double c = zp[0] / r, s = zp[i] / r;
+            rotate_cols(Wp.view(), 0, i, c, -s);
+            zp[0] = r;
+            zp[i] = 0.0;
+            dp[i] *= c;
+            continue;
+        }
+        const size_t j = nd.back();
+        if (j != 0) {
+            const double r = std::hypot(zp[i], zp[j]);
+            const double c = zp[i] / r, s = zp[j] / r;
+            if (std::abs((dp[i] - dp[j]) * c * s) <= tol) {
+                zp[j] = 0.0;
+                zp[i] = r;
+                const double dj = c * c * dp[j] + s * s * dp[i];
+                const double di = s * s * dp[j] + c * c * dp[i];
+                dp[j] = dj;
+                dp[i] = di;
+                rotate_cols(Up.view(), j, i, c, s);
+                rotate_cols(Wp.view(), j, i, c, s);
+                nd.pop_back();
+            }
+        }
+        nd.push_back(i);
+    }
+    // 第 0 个分量不能为 0, 否则久期方程退化
+    if (std::abs(zp[0]) < tol) {
+        zp[0] = zp[0] < 0.0 ? -tol : tol;
+    }
+
+    const size_t K = nd.size();
+    std::vector<double> dk(K), dk2(K), zk(K), tau(K), zh(K);
+    std::vector<size_t> org(K);
+    for (size_t t = 0; t < K; t++) {
+        dk[t] = dp[nd[t]];
+        dk2[t] = dk[t] * dk[t];
+        zk[t] = zp[nd[t]];
+    }
+    parallel_for(0, K, 16, [&](size_t lo, size_t hi) {
+        for (size_t j = lo; j < hi; j++) {
+            secular_root(dk2.data(), zk.data(), K, 1.0, j, org[j], tau[j]);
+        }
+    });
+    // d_i^2 - sigma_j^2
+    auto delta = [&](size_t j, size_t i) {
+        return (dk[i] - dk[org[j]]) * (dk[i] + dk[org[j]]) - tau[j];
+    };
+    parallel_for(0, K, 64, [&](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; i++) {
+            double p = -delta(i, i);
+            for (size_t j = 0; j < K; j++) {
+                if (j != i) {
+                    p *= -delta(j, i) / ((dk[j] - dk[i]) * (dk[j] + dk[i]));
+                }
+            }
+            zh[i] = std::copysign(std::sqrt(std::max(p, 0.0)), zk[i]);
+        }
+    });
+    // 第 j 个右奇异向量 v_i = zh_i / (d_i^2 - sigma_j^2), 左奇异向量 u_0 = -1, u_i = d_i v_i,
+    // 各自单位化. 两者都按行存放, 左奇异向量不经过 M v / sigma, 小奇异值的向量也准确
+    Matrix Vt(K, K), Ut(K, K), Uk(n, K), Wk(m, K), RU(n, K), RW(m, K);
+    for_rows(0, K, K, [&](size_t j) {
+        double* v = Vt.row_ptr(j);
+        double* u = Ut.row_ptr(j);
+        double sv = 0.0, su = 1.0;
+        v[0] = zh[0] / delta(j, 0);
+        u[0] = -1.0;
+        sv += v[0] * v[0];
+        for (size_t i = 1; i < K; i++) {
+            v[i] = zh[i] / delta(j, i);
+            u[i] = dk[i] * v[i];
+            sv += v[i] * v[i];
+            su += u[i] * u[i];
+        }
+        const double iv = 1.0 / std::sqrt(sv), iu = 1.0 / std::sqrt(su);
+        for (size_t i = 0; i < K; i++) {
+            v[i] *= iv;
+            u[i] *= iu;
+        }
+    });
+    for_rows(0, m, K, [&](size_t r) {
+        for (size_t t = 0; t < K; t++) {
+            Wk(r, t) = Wp(r, nd[t]);
+            if (r < n) Uk(r, t) = Up(r, nd[t]);
+        }
+    });
+    gemm_strided(n, K, K, 1.0, Uk.data(), Uk.ld(), 1, Ut.data(), 1, Ut.ld(), 0.0, RU.data(), RU.ld());
+    gemm_strided(m, K, K, 1.0, Wk.data(), Wk.ld(), 1, Vt.data(), 1, Vt.ld(), 0.0, RW.data(), RW.ld());
+
+    // 收缩的和新算出的奇异值一起升序写回, W 的最后一列 (sqre 为 1 时的零空间) 不动
+    std::vector<std::pair<double, size_t>> order; // (奇异值, 来源列), 来源 >= n 表示 RU / RW 的第 (来源 - n) 列
+    std::vector<char> is_nd(n, 0);
+    for (size_t t = 0; t < K; t++) {
+        is_nd[nd[t]] = 1;
+        order.emplace_back(std::sqrt(dk2[org[t]] + tau[t]), n + t);
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (is_nd[i]) continue;
+        if (dp[i] < 0.0) {
+            // d 接近 0 的收缩旋转可能给出负的 d, 翻转右奇异向量
+            dp[i] = -dp[i];
+            for (size_t r = 0; r < m; r++) Wp(r, i) = -Wp(r, i);
+        }
+        order.emplace_back(dp[i], i);
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (size_t c = 0; c < n; c++) {
+        d[c] = order[c].first;
+    }
+    for_rows(0, m, n, [&](size_t r) {
+        double* wr = W.row_ptr(r);
+        double* ur = r < n ? U.row_ptr(r) : nullptr;
+        for (size_t c = 0; c < n; c++) {
+            const size_t src = order[c].second;
+            wr[c] = src >= n ? RW(r, src - n) : Wp(r, src);
+            if (ur) ur[c] = src >= n ? RU(r, src - n) : Up(r, src);
+        }
+    });
+}
+
+/**
+ * @brief 分治法求 n x (n + sqre) 上双对角矩阵的奇异值分解, B = U [diag(d) 0] W^T, d 升序. e 会被破坏.
+ * 底层的 QR 未收敛时返回 false
+ */
+inline bool bidiag_dc(double* d, double* e, size_t n, size_t sqre, MatrixView U, MatrixView W) {
+    if (n == 0) {
+        if (sqre) W(0, 0) = 1.0;
+        return true;
+    }
+    if (n <= bidiag_dc_base) {
+        return bidiag_dc_leaf(d, e, n, sqre, U, W);
+    }
+    // 第 k 行: d_k 在第 k 列, e_k 在第 k + 1 列
+    const size_t k = n / 2, n2 = n - k - 1;
+    const double alpha = d[k], beta = e[k];
+    for (size_t i = 0; i < n; i++) {
+        std::fill(U.row_ptr(i), U.row_ptr(i) + n, 0.0);
+    }
+    for (size_t i = 0; i < n + sqre; i++) {
+        std::fill(W.row_ptr(i), W.row_ptr(i) + n + sqre, 0.0);
+    }
+    U(k, k) = 1.0;
+    const bool c1 = bidiag_dc(d, e, k, 1, U.block(0, 0, k, k), W.block(0, 0, k + 1, k + 1));
+    const bool c2 = bidiag_dc(d + k + 1, e + k + 1, n2, sqre, U.block(k + 1, k + 1, n2, n2),
+                              W.block(k + 1, k + 1, n2 + sqre, n2 + sqre));
+    // 子问题的奇异值按 d 的位置放好, 第 k 个位置留给 z 所在的行
+    bidiag_dc_merge(d, n, k, sqre, alpha, beta, U, W);
+    return c1 && c2;
+}
+
+/**
+ * @brief 方的上双对角矩阵 B = U diag(d) V^T 的奇异值分解, 分治法, d 升序. 先缩放到最大元素为 1
+ */
+inline bool bidiag_svd_dc(double* d, double* e, size_t n, MatrixView U, MatrixView V) {
+    double scale = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        scale = std::max(scale, std::abs(d[i]));
+        if (i + 1 < n) scale = std::max(scale, std::abs(e[i]));
+    }
+    if (scale == 0.0) {
+        for (size_t i = 0; i < n; i++) {
+            std::fill(U.row_ptr(i), U.row_ptr(i) + n, 0.0);
+            std::fill(V.row_ptr(i), V.row_ptr(i) + n, 0.0);
+            U(i, i) = 1.0;
+            V(i, i) = 1.0;
+        }
+        return true;
+    }
+    for (size_t i = 0; i < n; i++) {
+        d[i] /= scale;
+        if (i + 1 < n) e[i] /= scale;
+    }
+    const bool converged = bidiag_dc(d, e, n, 0, U, V);
+    for (size_t i = 0; i < n; i++) {
+        d[i] *= scale;
+    }
+    return converged;
+}
+
+// 瘦 SVD, A 是 m x n 且 m >= n
+inline SVDResult svd_tall(Matrix B, bool vectors) {
+    const size_t m = B.rows(), n = B.cols();
+    std::vector<double> d(n), e(n), tauq(n), taup(n);
+    bidiagonalize(B.view(), d.data(), e.data(), tauq.data(), taup.data());
+    // 只要奇异值时 QR 只有 O(n^2); 要奇异向量时用分治法, 向量的更新是 GEMM
+    Matrix Ub(vectors ? n : 0, vectors ? n : 0), Vb(vectors ? n : 0, vectors ? n : 0);
+    const bool converged = vectors ? bidiag_svd_dc(d.data(), e.data(), n, Ub.view(), Vb.view())
+                                   : bidiag_qr(d.data(), e.data(), n, MatrixView(), MatrixView(), false);
+
+    std::vector<size_t> perm(n);
+    std::iota(perm.begin(), perm.end(), size_t(0));
+    std::stable_sort(perm.begin(), perm.end(), [&](size_t a, size_t b) { return d[a] > d[b]; });
+    SVDResult ret { Matrix(0, 0), Vector(n), Matrix(0, 0), converged };
+    for (size_t j = 0; j < n; j++) {
+        ret.S(j) = d[perm[j]];
+    }
+    if (!vectors) return ret;
+
+    // U = Q [Ub; 0], V = P Vb, 列按奇异值降序重排
+    ret.U = Matrix(m, n);
+    ret.V = Matrix(n, n);
+    for_rows(0, n, n, [&](size_t i) {
+        for (size_t j = 0; j < n; j++) {
+            ret.U(i, j) = Ub(i, perm[j]);
+            ret.V(i, j) = Vb(i, perm[j]);
+        }
+    });
+    apply_householder(n, 0, [&](size_t i, size_t j) { return B(j, i); }, tauq.data(), ret.U.view());
+    if (n > 1) {
+        apply_householder(n - 1, 1, [&](size_t i, size_t j) { return B(i, j); }, taup.data(), ret.V.view());
+    }
+    return ret;
+}
+
+inline SVDResult svd(const Matrix& A, bool vectors) {
+    if (A.rows() >= A.cols()) {
+        return svd_tall(A, vectors);
+    }
+    SVDResult r = svd_tall(A.T(), vectors);
+    std::swap(r.U, r.V);
+    return r;
+}
+
+// 三对角化之前把上三角复制到下三角, 只读取上三角
+inline Matrix symmetrized_upper(const Matrix& A) {
+    Matrix M(A);
+    const size_t n = M.rows();
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < i; j++) {
+            M(i, j) = M(j, i);
+        }
+    }
+    return M;
+}
+
+// 单位化, 返回缩放系数 (全为 0 时返回 0)
+inline double normalize_tridiag(std::vector<double>& d, std::vector<double>& e) {
+    double scale = 0.0;
+    for (double x : d) scale = std::max(scale, std::abs(x));
+    for (double x : e) scale = std::max(scale, std::abs(x));
+    if (scale != 0.0) {
+        for (double& x : d) x /= scale;
+        for (double& x : e) x /= scale;
+    }
+    return scale;
+}
+
+// 列正交化: 返回 m x l 的 Q, 其列是 Y 的列空间的标准正交基 (Householder QR, l 通常很小)
+inline Matrix orthonormalize(Matrix Y) {
+    const size_t m = Y.rows(), l = std::min(Y.rows(), Y.cols());
+    std::vector<double> tau(l), w(Y.cols());
+    for (size_t i = 0; i < l; i++) {
+        Y(i, i) = householder(&Y(i, i), m - i, Y.ld(), tau[i]);
+        const double ti = tau[i];
+        if (ti == 0.0) continue;
+        // Y(i:m, i+1:) -= tau v (v^T Y(i:m, i+1:))
+        const double beta = Y(i, i);
+        Y(i, i) = 1.0;
+        std::fill(w.begin(), w.end(), 0.0);
+        for (size_t r = i; r < m; r++) {
+            const double vr = Y(r, i);
+            const double* yr = Y.row_ptr(r);
+            for (size_t j = i + 1; j < Y.cols(); j++) w[j] += vr * yr[j];
+        }
+        for_rows(i, m, Y.cols() - i, [&](size_t r) {
+            const double vr = ti * Y(r, i);
+            double* yr = Y.row_ptr(r);
+            for (size_t j = i + 1; j < Y.cols(); j++) yr[j] -= vr * w[j];
+        });
+        Y(i, i) = beta;
+    }
+    Matrix Q(m, l);
+    for (size_t i = 0; i < l; i++) {
+        Q(i, i) = 1.0;
+    }
+    apply_householder(l, 0, [&](size_t i, size_t j) { return Y(j, i); }, tau.data(), Q.view());
+    return Q;
+}
+
+}
+
+inline EighResult Matrix::eigh() const {
+    // TODO if (!is_squared()) error
+    const size_t n = get_row_size();
+    Matrix M = detail::symmetrized_upper(*this);
+    std::vector<double> d(n), e(n), tau(n);
+    detail::tridiagonalize(M.view(), d.data(), e.data(), tau.data());
+    e.resize(n > 0 ? n - 1 : 0);
+    const double scale = detail::normalize_tridiag(d, e);
+    Matrix Q(n, n);
+    const bool converged = detail::tridiag_dc(d.data(), e.data(), n, Q.view());
+    if (n > 1) {
+        detail::apply_householder(n - 1, 1, [&](size_t i, size_t j) { return M(i, j); }, tau.data(), Q.view());
+    }
+    EighResult ret { Vector(n), std::move(Q), converged };
+    for (size_t i = 0; i < n; i++) {
+        ret.values(i) = d[i] * scale;
+    }
+    return ret;
+}
+
+inline Vector Matrix::eigvalsh() const {
+    // TODO if (!is_squared()) error
+    const size_t n = get_row_size();
+    Matrix M = detail::symmetrized_upper(*this);
+    std::vector<double> d(n), e(n), tau(n);
+    detail::tridiagonalize(M.view(), d.data(), e.data(), tau.data());
+    // 只返回特征值, 无法附带标志
+    if (!detail::tridiag_ql(d.data(), e.data(), n, MatrixView(), false)) {
+        throw std::runtime_error("zmath: eigvalsh did not converge");
+    }
+    std::sort(d.begin(), d.end());
+    return Vector(d);
+}
+
+inline SVDResult Matrix::svd() const {
+    return detail::svd(*this, true);
+}
+
+inline Vector Matrix::singular_values() const {
+    SVDResult r = detail::svd(*this, false);
+    if (!r.converged) {
+        throw std::runtime_error("zmath: singular_values did not converge");
+    }
+    return std::move(r.S);
+}
+
+/**
+ * @brief 随机化的截断 SVD, 求前 k 个奇异值和奇异向量 (Halko, Martinsson, Tropp)
+ *
+ * 用 k + oversample 个高斯随机向量采样 A 的列空间, 做 power_iters 次幂迭代 (每次重新正交化) 拉开奇异值的差距,
+ * 再对 Q^T A 做完整的 SVD. 主要开销是 2 (power_iters + 1) 次 m x n x (k + oversample) 的 GEMM.
+ * 奇异值衰减越快结果越准, seed 相同时结果相同
+ */
+inline SVDResult randomized_svd(const Matrix& A, size_t k, size_t oversample = 10, size_t power_iters = 2,
+                                uint64_t seed = 0) {
+    const size_t m = A.rows(), n = A.cols();
+    k = std::min(k, std::min(m, n));
+    const size_t l = std::min(k + oversample, std::min(m, n));
+    std::mt19937_64 rng(seed);
+    std::normal_distribution<double> dist;
+    Matrix Omega(n, l);
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < l; j++) {
+            Omega(i, j) = dist(rng);
+        }
+    }
+    Matrix Y(m, l), Z(n, l);
+    gemm(1.0, A.view(), Omega.view(), 0.0, Y.view());
+    for (size_t it = 0; it < power_iters; it++) {
+        const Matrix Q = detail::orthonormalize(std::move(Y));
+        // Z = A^T Q
+        detail::gemm_strided(n, l, m, 1.0, A.data(), 1, A.ld(), Q.data(), Q.ld(), 1, 0.0, Z.data(), Z.ld());
+        const Matrix P = detail::orthonormalize(Z);
+        Y = Matrix(m, l);
+        gemm(1.0, A.view(), P.view(), 0.0, Y.view());
+    }
+    const Matrix Q = detail::orthonormalize(std::move(Y));
+    // B = Q^T A, l x n
+    Matrix B(l, n);
+    detail::gemm_strided(l, n, m, 1.0, Q.data(), 1, Q.ld(), A.data(), A.ld(), 1, 0.0, B.data(), B.ld());
+    SVDResult small = detail::svd(B, true);
+
+    SVDResult ret { Matrix(m, k), Vector(k), Matrix(n, k), small.converged };
+    Matrix U(m, l);
+    gemm(1.0, Q.view(), small.U.view(), 0.0, U.view());
+    for (size_t i = 0; i < m; i++) {
+        std::copy(U.row_ptr(i), U.row_ptr(i) + k, ret.U.row_ptr(i));
+    }
+    for (size_t i = 0; i < n; i++) {
+        std::copy(small.V.row_ptr(i), small.V.row_ptr(i) + k, ret.V.row_ptr(i));
+    }
+    for (size_t j = 0; j < k; j++) {
+        ret.S(j) = small.S(j);
+    }
+    return ret;
+}
+
+}
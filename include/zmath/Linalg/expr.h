@@ -0,0 +1,415 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <zmath/utils/thread_pool.h>
+
+// Vector / Matrix 逐元素运算的表达式模板. a + b, a - b, c * a, -a 不立即计算, 而是返回一个
+// 记录了运算的轻量对象; 赋给 Vector / Matrix 时整个表达式在一个循环里逐元素求值,
+// 不产生中间结果. 赋给已有对象且大小相同时不分配内存.
+// 表达式中的左值 Vector / Matrix 按引用保存, 右值 (临时对象和子表达式) 按值保存,
+// 所以 auto e = a + b; 之后只要 a, b 还在, e 就可以继续使用.
+// 行向量和列向量是不同的类型, 方向不同的向量不能相加; 列向量乘行向量 (外积) 也是一个矩阵表达式
+
+namespace zmath {
+
+template <bool Row>
+class BasicVector;
+using Vector = BasicVector<false>;
+using RowVector = BasicVector<true>;
+class Matrix;
+
+/**
+ * @brief 向量表达式的基类 (CRTP), E 提供 size(), coeff(i) 和表示方向的 static constexpr bool is_row
+ */
+template <typename E>
+class VectorExpr {
+public:
+    const E& derived() const {
+        return static_cast<const E&>(*this);
+    }
+
+    // 以下函数定义在 linalg.h, 需要完整的 BasicVector.
+    // eval 返回同方向的向量, transpose 返回另一方向的向量
+    auto eval() const;
+    auto transpose() const;
+    std::string to_string() const;
+    void print() const;
+};
+
+/**
+ * @brief 矩阵表达式的基类 (CRTP), E 提供 rows(), cols() 和 coeff(i, j)
+ */
+template <typename E>
+class MatrixExpr {
+public:
+    const E& derived() const {
+        return static_cast<const E&>(*this);
+    }
+
+    Matrix eval() const;
+    std::string to_string() const;
+    void print() const;
+};
+
+namespace detail {
+
+struct ExprAdd {
+    static double apply(double a, double b) {
+        return a + b;
+    }
+};
+
+struct ExprSub {
+    static double apply(double a, double b) {
+        return a - b;
+    }
+};
+
+template <typename T>
+constexpr bool is_vector_expr_v = std::is_base_of_v<VectorExpr<std::decay_t<T>>, std::decay_t<T>>;
+
+template <typename T>
+constexpr bool is_matrix_expr_v = std::is_base_of_v<MatrixExpr<std::decay_t<T>>, std::decay_t<T>>;
+
+// 表达式中操作数的保存方式: 左值 Vector / Matrix 保存引用, 其他按值保存
+template <typename T>
+constexpr bool is_dense_leaf_v = std::is_same_v<std::decay_t<T>, Vector> || std::is_same_v<std::decay_t<T>, RowVector> ||
+                                 std::is_same_v<std::decay_t<T>, Matrix>;
+
+template <typename T>
+using expr_operand_t = std::conditional_t<std::is_lvalue_reference_v<T> && is_dense_leaf_v<T>,
+                                          const std::decay_t<T>&, std::decay_t<T>>;
+
+// 外积的操作数: 每个元素会被读多次, 所以子表达式先求值成向量再保存
+template <typename T>
+using outer_operand_t = std::conditional_t<is_dense_leaf_v<T>, expr_operand_t<T>,
+                                           BasicVector<std::decay_t<T>::is_row>>;
+
+template <typename T>
+struct is_row_vector_expr : std::bool_constant<std::decay_t<T>::is_row> { };
+
+template <typename T>
+struct is_col_vector_expr : std::bool_constant<!std::decay_t<T>::is_row> { };
+
+// 用 conjunction 短路, 不是向量表达式的类型不会去取 is_row
+template <typename L, typename R>
+constexpr bool is_col_times_row_v = std::conjunction_v<std::bool_constant<is_vector_expr_v<L> && is_vector_expr_v<R>>,
+                                                       is_col_vector_expr<L>, is_row_vector_expr<R>>;
+
+template <typename L, typename R>
+constexpr bool is_row_times_col_v = std::conjunction_v<std::bool_constant<is_vector_expr_v<L> && is_vector_expr_v<R>>,
+                                                       is_row_vector_expr<L>, is_col_vector_expr<R>>;
+
+// 每块至少这么多元素时才分给线程池, 逐元素运算受内存带宽限制, 太小的块不值得
+constexpr size_t expr_parallel_grain = size_t(1) << 15;
+
+// out[i] = f(out[i], e.coeff(i)), i in [0, n)
+template <typename E, typename F>
+void expr_assign(double* out, const E& e, size_t n, F f) {
+    parallel_for(0, n, expr_parallel_grain, [&](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; i++) {
+            out[i] = f(out[i], e.coeff(i));
+        }
+    });
+}
+
+// 行主序矩阵 out(i, j) = f(out(i, j), e.coeff(i, j)), 按行分给线程池
+template <typename E, typename F>
+void expr_assign(double* out, size_t ld, const E& e, size_t rows, size_t cols, F f) {
+    const size_t grain = std::max<size_t>(1, expr_parallel_grain / std::max<size_t>(cols, 1));
+    parallel_for(0, rows, grain, [&](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; i++) {
+            double* oi = out + i * ld;
+            for (size_t j = 0; j < cols; j++) {
+                oi[j] = f(oi[j], e.coeff(i, j));
+            }
+        }
+    });
+}
+
+}
+
+template <typename Op, typename L, typename R>
+class VectorBinaryExpr : public VectorExpr<VectorBinaryExpr<Op, L, R>> {
+public:
+    static constexpr bool is_row = std::decay_t<L>::is_row;
+    static_assert(is_row == std::decay_t<R>::is_row, "cannot mix row and column vectors");
+
+    template <typename A, typename B>
+    VectorBinaryExpr(A&& l, B&& r) : l_(std::forward<A>(l)), r_(std::forward<B>(r)) { }
+
+    size_t size() const {
+        return l_.size();
+    }
+
+    double coeff(size_t i) const {
+        return Op::apply(l_.coeff(i), r_.coeff(i));
+    }
+
+private:
+    L l_;
+    R r_;
+};
+
+template <typename E>
+class VectorScaleExpr : public VectorExpr<VectorScaleExpr<E>> {
+public:
+    static constexpr bool is_row = std::decay_t<E>::is_row;
+
+    template <typename A>
+    VectorScaleExpr(double c, A&& e) : c_(c), e_(std::forward<A>(e)) { }
+
+    size_t size() const {
+        return e_.size();
+    }
+
+    double coeff(size_t i) const {
+        return c_ * e_.coeff(i);
+    }
+
+private:
+    double c_;
+    E e_;
+};
+
+template <typename Op, typename L, typename R>
+class MatrixBinaryExpr : public MatrixExpr<MatrixBinaryExpr<Op, L, R>> {
+public:
+    template <typename A, typename B>
+    MatrixBinaryExpr(A&& l, B&& r) : l_(std::forward<A>(l)), r_(std::forward<B>(r)) { }
+
+    size_t rows() const {
+        return l_.rows();
+    }
+
+    size_t cols() const {
+        return l_.cols();
+    }
+
+    double coeff(size_t i, size_t j) const {
+        return Op::apply(l_.coeff(i, j), r_.coeff(i, j));
+    }
+
+private:
+    L l_;
+    R r_;
+};
+
+template <typename E>
+class MatrixScaleExpr : public MatrixExpr<MatrixScaleExpr<E>> {
+public:
+    template <typename A>
+    MatrixScaleExpr(double c, A&& e) : c_(c), e_(std::forward<A>(e)) { }
+
+    size_t rows() const {
+        return e_.rows();
+    }
+
+    size_t cols() const {
+        return e_.cols();
+    }
+
+    double coeff(size_t i, size_t j) const {
+        return c_ * e_.coeff(i, j);
+    }
+
+private:
+    double c_;
+    E e_;
+};
+
+/**
+ * @brief 外积 u v^T, u 是列向量, v 是行向量. 是矩阵表达式, 可以直接写 A += u * v
+ */
+template <typename L, typename R>
+class OuterProductExpr : public MatrixExpr<OuterProductExpr<L, R>> {
+public:
+    template <typename A, typename B>
+    OuterProductExpr(A&& u, B&& v) : u_(std::forward<A>(u)), v_(std::forward<B>(v)) { }
+
+    size_t rows() const {
+        return u_.size();
+    }
+
+    size_t cols() const {
+        return v_.size();
+    }
+
+    double coeff(size_t i, size_t j) const {
+        return u_.coeff(i) * v_.coeff(j);
+    }
+
+private:
+    L u_;
+    R v_;
+};
+
+/**
+ * @brief 向量的转置, 不拷贝: 引用原向量, 只改变方向
+ */
+template <typename V>
+class VectorTransposeExpr : public VectorExpr<VectorTransposeExpr<V>> {
+public:
+    static constexpr bool is_row = !std::decay_t<V>::is_row;
+
+    template <typename A>
+    explicit VectorTransposeExpr(A&& v) : v_(std::forward<A>(v)) { }
+
+    size_t size() const {
+        return v_.size();
+    }
+
+    double coeff(size_t i) const {
+        return v_.coeff(i);
+    }
+
+    double operator()(size_t i) const {
+        return v_.coeff(i);
+    }
+
+    const double* data() const {
+        return v_.data();
+    }
+
+private:
+    V v_;
+};
+
+/**
+ * @brief 矩阵的转置, 不拷贝. 赋给 Matrix 时分块转置, 参与矩阵乘法时以转置的步长直接交给 GEMM
+ */
+template <typename M>
+class TransposeExpr : public MatrixExpr<TransposeExpr<M>> {
+public:
+    template <typename A>
+    explicit TransposeExpr(A&& m) : m_(std::forward<A>(m)) { }
+
+    size_t rows() const {
+        return m_.cols();
+    }
+
+    size_t cols() const {
+        return m_.rows();
+    }
+
+    double coeff(size_t i, size_t j) const {
+        return m_.coeff(j, i);
+    }
+
+    double operator()(size_t i, size_t j) const {
+        return m_.coeff(j, i);
+    }
+
+    // 被转置的矩阵
+    const std::decay_t<M>& nested() const {
+        return m_;
+    }
+
+private:
+    M m_;
+};
+
+namespace detail {
+
+// 表达式中是否有矩阵的转置. 转置按列读取操作数, 赋值的目标出现在表达式中时不能逐元素原地计算
+template <typename E>
+struct expr_has_transpose : std::false_type { };
+
+template <typename M>
+struct expr_has_transpose<TransposeExpr<M>> : std::true_type { };
+
+template <typename Op, typename L, typename R>
+struct expr_has_transpose<MatrixBinaryExpr<Op, L, R>>
+    : std::bool_constant<expr_has_transpose<std::decay_t<L>>::value || expr_has_transpose<std::decay_t<R>>::value> { };
+
+template <typename E>
+struct expr_has_transpose<MatrixScaleExpr<E>> : expr_has_transpose<std::decay_t<E>> { };
+
+}
+
+// 向量表达式的运算符. TODO if (l.size() != r.size()) error
+
+template <typename L, typename R, std::enable_if_t<detail::is_vector_expr_v<L> && detail::is_vector_expr_v<R>, int> = 0>
+auto operator+(L&& l, R&& r) {
+    using Expr = VectorBinaryExpr<detail::ExprAdd, detail::expr_operand_t<L&&>, detail::expr_operand_t<R&&>>;
+    return Expr(std::forward<L>(l), std::forward<R>(r));
+}
+
+template <typename L, typename R, std::enable_if_t<detail::is_vector_expr_v<L> && detail::is_vector_expr_v<R>, int> = 0>
+auto operator-(L&& l, R&& r) {
+    using Expr = VectorBinaryExpr<detail::ExprSub, detail::expr_operand_t<L&&>, detail::expr_operand_t<R&&>>;
+    return Expr(std::forward<L>(l), std::forward<R>(r));
+}
+
+template <typename E, std::enable_if_t<detail::is_vector_expr_v<E>, int> = 0>
+auto operator*(double c, E&& e) {
+    return VectorScaleExpr<detail::expr_operand_t<E&&>>(c, std::forward<E>(e));
+}
+
+template <typename E, std::enable_if_t<detail::is_vector_expr_v<E>, int> = 0>
+auto operator*(E&& e, double c) {
+    return VectorScaleExpr<detail::expr_operand_t<E&&>>(c, std::forward<E>(e));
+}
+
+template <typename E, std::enable_if_t<detail::is_vector_expr_v<E>, int> = 0>
+auto operator-(E&& e) {
+    return VectorScaleExpr<detail::expr_operand_t<E&&>>(-1.0, std::forward<E>(e));
+}
+
+/**
+ * @brief 行向量乘列向量: 内积
+ */
+template <typename L, typename R, std::enable_if_t<detail::is_row_times_col_v<L, R>, int> = 0>
+double operator*(const L& u, const R& v) {
+    // TODO if (u.size() != v.size()) error
+    double r = 0.0;
+    for (size_t i = 0; i < u.size(); i++) {
+        r += u.coeff(i) * v.coeff(i);
+    }
+    return r;
+}
+
+/**
+ * @brief 列向量乘行向量: 外积, 返回矩阵表达式, 赋给 Matrix 时才计算
+ */
+template <typename L, typename R, std::enable_if_t<detail::is_col_times_row_v<L, R>, int> = 0>
+auto operator*(L&& u, R&& v) {
+    using Expr = OuterProductExpr<detail::outer_operand_t<L&&>, detail::outer_operand_t<R&&>>;
+    return Expr(std::forward<L>(u), std::forward<R>(v));
+}
+
+// 矩阵表达式的运算符, 只有逐元素运算; 矩阵乘法见 gemm.h
+
+template <typename L, typename R, std::enable_if_t<detail::is_matrix_expr_v<L> && detail::is_matrix_expr_v<R>, int> = 0>
+auto operator+(L&& l, R&& r) {
+    using Expr = MatrixBinaryExpr<detail::ExprAdd, detail::expr_operand_t<L&&>, detail::expr_operand_t<R&&>>;
+    return Expr(std::forward<L>(l), std::forward<R>(r));
+}
+
+template <typename L, typename R, std::enable_if_t<detail::is_matrix_expr_v<L> && detail::is_matrix_expr_v<R>, int> = 0>
+auto operator-(L&& l, R&& r) {
+    using Expr = MatrixBinaryExpr<detail::ExprSub, detail::expr_operand_t<L&&>, detail::expr_operand_t<R&&>>;
+    return Expr(std::forward<L>(l), std::forward<R>(r));
+}
+
+template <typename E, std::enable_if_t<detail::is_matrix_expr_v<E>, int> = 0>
+auto operator*(double c, E&& e) {
+    return MatrixScaleExpr<detail::expr_operand_t<E&&>>(c, std::forward<E>(e));
+}
+
+template <typename E, std::enable_if_t<detail::is_matrix_expr_v<E>, int> = 0>
+auto operator*(E&& e, double c) {
+    return MatrixScaleExpr<detail::expr_operand_t<E&&>>(c, std::forward<E>(e));
+}
+
+template <typename E, std::enable_if_t<detail::is_matrix_expr_v<E>, int> = 0>
+auto operator-(E&& e) {
+    return MatrixScaleExpr<detail::expr_operand_t<E&&>>(-1.0, std::forward<E>(e));
+}
+
+}
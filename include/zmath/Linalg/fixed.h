@@ -0,0 +1,598 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <initializer_list>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <fmt/format.h>
+
+#include <zmath/utils.h>
+
+// 编译期确定大小的向量 Vec<T, N> 和矩阵 Mat<T, R, C>. 数据放在对象内 (栈上), 不分配内存;
+// 循环用 static_for 在编译期展开, 算术运算都是 constexpr. 用于几何变换这类大量的小矩阵运算
+
+namespace zmath {
+
+/**
+ * @brief 范数的计算方式
+ *
+ * Safe 先除以绝对值最大的分量再平方, 分量很大或很小时不会上溢 / 下溢 (与 std::hypot 相同), 多一次除法;
+ * Fast 直接计算平方和的平方根 sqrt(x^2 + y^2 + ...), 分量超过约 1e154 或小于约 1e-154 时结果不准确
+ */
+enum class NormMode {
+    Safe,
+    Fast
+};
+
+namespace detail {
+
+template <typename F, size_t... I>
+constexpr void static_for_impl(F&& f, std::index_sequence<I...>) {
+    (f(std::integral_constant<size_t, I>{}), ...);
+}
+
+// f(0), f(1), ..., f(N - 1), 下标是编译期常量
+template <size_t N, typename F>
+constexpr void static_for(F&& f) {
+    static_for_impl(std::forward<F>(f), std::make_index_sequence<N>{});
+}
+
+// 2, 3, 4 维的分量可以用 x, y, z, w 访问, 其他维数用数组
+template <typename T, size_t N>
+struct VecStorage {
+    T data_[N] {};
+
+    constexpr T& at(size_t i) {
+        return data_[i];
+    }
+
+    constexpr const T& at(size_t i) const {
+        return data_[i];
+    }
+};
+
+template <typename T>
+struct VecStorage<T, 2> {
+    T x {};
+    T y {};
+
+    constexpr T& at(size_t i) {
+        return i == 0 ? x : y;
+    }
+
+    constexpr const T& at(size_t i) const {
+        return i == 0 ? x : y;
+    }
+};
+
+template <typename T>
+struct VecStorage<T, 3> {
+    T x {};
+    T y {};
+    T z {};
+
+    constexpr T& at(size_t i) {
+        return i == 0 ? x : (i == 1 ? y : z);
+    }
+
+    constexpr const T& at(size_t i) const {
+        return i == 0 ? x : (i == 1 ? y : z);
+    }
+};
+
+template <typename T>
+struct VecStorage<T, 4> {
+    T x {};
+    T y {};
+    T z {};
+    T w {};
+
+    constexpr T& at(size_t i) {
+        return i == 0 ? x : (i == 1 ? y : (i == 2 ? z : w));
+    }
+
+    constexpr const T& at(size_t i) const {
+        return i == 0 ? x : (i == 1 ? y : (i == 2 ? z : w));
+    }
+};
+
+}
+
+/**
+ * @brief N 维定长向量, T 为 float 或 double
+ */
+template <typename T, size_t N>
+class Vec : public detail::VecStorage<T, N> {
+public:
+    static_assert(std::is_floating_point_v<T>, "Vec<T, N> requires a floating point T");
+
+    constexpr Vec() = default;
+
+    // Vec3 v(1, 2, 3); 参数个数必须等于 N
+    template <typename... Args,
+              std::enable_if_t<sizeof...(Args) == N && (std::is_arithmetic_v<Args> && ...), int> = 0>
+    constexpr Vec(Args... args) {
+        const T v[] = { static_cast<T>(args)... };
+        detail::static_for<N>([&](auto i) { (*this)[i] = v[i]; });
+    }
+
+    static constexpr Vec filled(T value) {
+        Vec ret;
+        detail::static_for<N>([&](auto i) { ret[i] = value; });
+        return ret;
+    }
+
+    static constexpr size_t size() {
+        return N;
+    }
+
+    constexpr T& operator[](size_t i) {
+        return this->at(i);
+    }
+
+    constexpr const T& operator[](size_t i) const {
+        return this->at(i);
+    }
+
+    // 点乘
+    constexpr T dot(const Vec& rhs) const {
+        T s = 0;
+        detail::static_for<N>([&](auto i) { s += (*this)[i] * rhs[i]; });
+        return s;
+    }
+
+    // 叉乘, 只有 3 维
+    template <size_t M = N, std::enable_if_t<M == 3, int> = 0>
+    constexpr Vec cross(const Vec& rhs) const {
+        return Vec(this->y * rhs.z - this->z * rhs.y,
+                   this->z * rhs.x - this->x * rhs.z,
+                   this->x * rhs.y - this->y * rhs.x);
+    }
+
+    constexpr T squared_norm() const {
+        return dot(*this);
+    }
+
+    // 范数, 默认与 std::hypot 一样先按绝对值最大的分量缩放, 不会上溢 / 下溢
+    T norm(NormMode mode = NormMode::Safe) const {
+        if constexpr (std::is_floating_point_v<T>) {
+            if (mode == NormMode::Safe) {
+                T m = 0;
+                detail::static_for<N>([&](auto i) { m = std::max(m, std::abs((*this)[i])); });
+                // m == 0: 全为 0, 或含有 NaN (max 忽略 NaN), 直接计算可以得到 0 或 NaN
+                if (m == 0) return std::sqrt(squared_norm());
+                if (std::isinf(m)) return m;
+                T s = 0;
+                detail::static_for<N>([&](auto i) {
+                    const T t = (*this)[i] / m;
+                    s += t * t;
+                });
+                return m * std::sqrt(s);
+            }
+        }
+        return std::sqrt(squared_norm());
+    }
+
+    // 距离
+    T distance(const Vec& v, NormMode mode = NormMode::Safe) const {
+        return (*this - v).norm(mode);
+    }
+
+    // 单位化
+    Vec normalize(NormMode mode = NormMode::Safe) const {
+        Vec v = *this;
+        v /= v.norm(mode);
+        return v;
+    }
+
+    // 两个向量之间的夹角, 返回弧度. Safe 时先单位化再点乘, 点乘本身也不会上溢
+    T angle(const Vec& v, NormMode mode = NormMode::Safe) const {
+        T d;
+        if (mode == NormMode::Fast) {
+            d = dot(v) / std::sqrt(squared_norm() * v.squared_norm());
+        } else {
+            d = normalize().dot(v.normalize());
+        }
+        // clamp
+        d = std::max(std::min(d, T(1)), T(-1));
+        return std::acos(d);
+    }
+
+    // 在 v 方向上的投影
+    constexpr Vec project(const Vec& v) const {
+        return v * (dot(v) / v.dot(v));
+    }
+
+    constexpr Vec& operator+=(const Vec& rhs) {
+        detail::static_for<N>([&](auto i) { (*this)[i] += rhs[i]; });
+        return *this;
+    }
+
+    constexpr Vec& operator-=(const Vec& rhs) {
+        detail::static_for<N>([&](auto i) { (*this)[i] -= rhs[i]; });
+        return *this;
+    }
+
+    constexpr Vec& operator*=(T scaler) {
+        detail::static_for<N>([&](auto i) { (*this)[i] *= scaler; });
+        return *this;
+    }
+
+    constexpr Vec& operator/=(T scaler) {
+        detail::static_for<N>([&](auto i) { (*this)[i] /= scaler; });
+        return *this;
+    }
+
+    friend constexpr Vec operator+(Vec lhs, const Vec& rhs) {
+        return lhs += rhs;
+    }
+
+    friend constexpr Vec operator-(Vec lhs, const Vec& rhs) {
+        return lhs -= rhs;
+    }
+
+    friend constexpr Vec operator-(Vec v) {
+        return v *= T(-1);
+    }
+
+    friend constexpr Vec operator*(Vec v, T c) {
+        return v *= c;
+    }
+
+    friend constexpr Vec operator*(T c, Vec v) {
+        return v *= c;
+    }
+
+    friend constexpr Vec operator/(Vec v, T c) {
+        return v /= c;
+    }
+
+    bool operator==(const Vec& rhs) const {
+        bool ret = true;
+        detail::static_for<N>([&](auto i) { ret = ret && zmath::eq((*this)[i], rhs[i]); });
+        return ret;
+    }
+
+    bool operator!=(const Vec& rhs) const {
+        return !(*this == rhs);
+    }
+
+    std::string to_string() const {
+        std::string str = fmt::format("Vec{} ( ", N);
+        for (size_t i = 0; i < N; i++) {
+            str += fmt::format(i + 1 < N ? "{:.3f}, " : "{:.3f} )", (*this)[i]);
+        }
+        return str;
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const Vec& v) {
+        os << v.to_string();
+        return os;
+    }
+
+    void print() const {
+        std::cout << *this << std::endl;
+    }
+
+    // 2 维和 3 维的方向向量, y 向上, z 向前
+    template <size_t M = N, std::enable_if_t<M == 2 || M == 3, int> = 0>
+    static constexpr Vec up() {
+        return axis(1, 1);
+    }
+
+    template <size_t M = N, std::enable_if_t<M == 2 || M == 3, int> = 0>
+    static constexpr Vec down() {
+        return axis(1, -1);
+    }
+
+    template <size_t M = N, std::enable_if_t<M == 2 || M == 3, int> = 0>
+    static constexpr Vec left() {
+        return axis(0, -1);
+    }
+
+    template <size_t M = N, std::enable_if_t<M == 2 || M == 3, int> = 0>
+    static constexpr Vec right() {
+        return axis(0, 1);
+    }
+
+    template <size_t M = N, std::enable_if_t<M == 3, int> = 0>
+    static constexpr Vec forward() {
+        return axis(2, 1);
+    }
+
+    template <size_t M = N, std::enable_if_t<M == 3, int> = 0>
+    static constexpr Vec back() {
+        return axis(2, -1);
+    }
+
+private:
+    static constexpr Vec axis(size_t i, T sign) {
+        Vec ret;
+        ret[i] = sign;
+        return ret;
+    }
+};
+
+/**
+ * @brief R x C 定长矩阵, 行主序存放在对象内
+ */
+template <typename T, size_t R, size_t C>
+class Mat {
+public:
+    static_assert(std::is_floating_point_v<T>, "Mat<T, R, C> requires a floating point T");
+
+    constexpr Mat() = default;
+
+    // Mat2 m { { 1, 2 }, { 3, 4 } }; 缺少的元素为 0
+    constexpr Mat(std::initializer_list<std::initializer_list<T>> rows) {
+        size_t i = 0;
+        for (const auto& row : rows) {
+            size_t j = 0;
+            for (T v : row) {
+                if (i < R && j < C) m_[i][j] = v;
+                j++;
+            }
+            i++;
+        }
+    }
+
+    static constexpr Mat identity() {
+        static_assert(R == C, "identity requires a square matrix");
+        Mat ret;
+        detail::static_for<R>([&](auto i) { ret.m_[i][i] = T(1); });
+        return ret;
+    }
+
+    static constexpr size_t rows() {
+        return R;
+    }
+
+    static constexpr size_t cols() {
+        return C;
+    }
+
+    constexpr T& operator()(size_t i, size_t j) {
+        return m_[i][j];
+    }
+
+    constexpr const T& operator()(size_t i, size_t j) const {
+        return m_[i][j];
+    }
+
+    constexpr Vec<T, C> row(size_t i) const {
+        Vec<T, C> ret;
+        detail::static_for<C>([&](auto j) { ret[j] = m_[i][j]; });
+        return ret;
+    }
+
+    constexpr Vec<T, R> col(size_t j) const {
+        Vec<T, R> ret;
+        detail::static_for<R>([&](auto i) { ret[i] = m_[i][j]; });
+        return ret;
+    }
+
+    constexpr Mat<T, C, R> transpose() const {
+        Mat<T, C, R> ret;
+        detail::static_for<R>([&](auto i) {
+            detail::static_for<C>([&](auto j) { ret(j, i) = m_[i][j]; });
+        });
+        return ret;
+    }
+
+    constexpr Mat& operator+=(const Mat& rhs) {
+        detail::static_for<R>([&](auto i) {
+            detail::static_for<C>([&](auto j) { m_[i][j] += rhs.m_[i][j]; });
+        });
+        return *this;
+    }
+
+    constexpr Mat& operator-=(const Mat& rhs) {
+        detail::static_for<R>([&](auto i) {
+            detail::static_for<C>([&](auto j) { m_[i][j] -= rhs.m_[i][j]; });
+        });
+        return *this;
+    }
+
+    constexpr Mat& operator*=(T c) {
+        detail::static_for<R>([&](auto i) {
+            detail::static_for<C>([&](auto j) { m_[i][j] *= c; });
+        });
+        return *this;
+    }
+
+    friend constexpr Mat operator+(Mat lhs, const Mat& rhs) {
+        return lhs += rhs;
+    }
+
+    friend constexpr Mat operator-(Mat lhs, const Mat& rhs) {
+        return lhs -= rhs;
+    }
+
+    friend constexpr Mat operator-(Mat m) {
+        return m *= T(-1);
+    }
+
+    friend constexpr Mat operator*(Mat m, T c) {
+        return m *= c;
+    }
+
+    friend constexpr Mat operator*(T c, Mat m) {
+        return m *= c;
+    }
+
+    // 矩阵乘向量
+    friend constexpr Vec<T, R> operator*(const Mat& m, const Vec<T, C>& v) {
+        Vec<T, R> ret;
+        detail::static_for<R>([&](auto i) {
+            T s = 0;
+            detail::static_for<C>([&](auto j) { s += m.m_[i][j] * v[j]; });
+            ret[i] = s;
+        });
+        return ret;
+    }
+
+    // 矩阵乘法, 第 i 行是 B 各行的线性组合, 内层沿 B 的行连续访问
+    template <size_t K>
+    friend constexpr Mat<T, R, K> operator*(const Mat& a, const Mat<T, C, K>& b) {
+        Mat<T, R, K> ret;
+        detail::static_for<R>([&](auto i) {
+            detail::static_for<C>([&](auto p) {
+                const T aip = a.m_[i][p];
+                detail::static_for<K>([&](auto j) { ret(i, j) += aip * b(p, j); });
+            });
+        });
+        return ret;
+    }
+
+    bool operator==(const Mat& rhs) const {
+        bool ret = true;
+        detail::static_for<R>([&](auto i) {
+            detail::static_for<C>([&](auto j) { ret = ret && zmath::eq(m_[i][j], rhs.m_[i][j]); });
+        });
+        return ret;
+    }
+
+    bool operator!=(const Mat& rhs) const {
+        return !(*this == rhs);
+    }
+
+    /**
+     * @brief 行列式, 2, 3, 4 阶用展开式直接计算
+     */
+    template <size_t M = R, std::enable_if_t<M == C && M >= 2 && M <= 4, int> = 0>
+    constexpr T det() const {
+        const auto& a = m_;
+        if constexpr (R == 2) {
+            return a[0][0] * a[1][1] - a[0][1] * a[1][0];
+        } else if constexpr (R == 3) {
+            return a[0][0] * (a[1][1] * a[2][2] - a[1][2] * a[2][1])
+                 - a[0][1] * (a[1][0] * a[2][2] - a[1][2] * a[2][0])
+                 + a[0][2] * (a[1][0] * a[2][1] - a[1][1] * a[2][0]);
+        } else {
+            return minors4().det;
+        }
+    }
+
+    /**
+     * @brief 逆矩阵, 伴随矩阵除以行列式. 奇异时结果含 inf / nan
+     */
+    template <size_t M = R, std::enable_if_t<M == C && M >= 2 && M <= 4, int> = 0>
+    constexpr Mat inv() const {
+        // TODO if (det() == 0) error
+        const auto& a = m_;
+        Mat b;
+        if constexpr (R == 2) {
+            const T d = T(1) / det();
+            b.m_[0][0] = a[1][1] * d;
+            b.m_[0][1] = -a[0][1] * d;
+            b.m_[1][0] = -a[1][0] * d;
+            b.m_[1][1] = a[0][0] * d;
+        } else if constexpr (R == 3) {
+            b.m_[0][0] = a[1][1] * a[2][2] - a[1][2] * a[2][1];
+            b.m_[0][1] = a[0][2] * a[2][1] - a[0][1] * a[2][2];
+            b.m_[0][2] = a[0][1] * a[1][2] - a[0][2] * a[1][1];
+            b.m_[1][0] = a[1][2] * a[2][0] - a[1][0] * a[2][2];
+            b.m_[1][1] = a[0][0] * a[2][2] - a[0][2] * a[2][0];
+            b.m_[1][2] = a[0][2] * a[1][0] - a[0][0] * a[1][2];
+            b.m_[2][0] = a[1][0] * a[2][1] - a[1][1] * a[2][0];
+            b.m_[2][1] = a[0][1] * a[2][0] - a[0][0] * a[2][1];
+            b.m_[2][2] = a[0][0] * a[1][1] - a[0][1] * a[1][0];
+            b *= T(1) / (a[0][0] * b.m_[0][0] + a[0][1] * b.m_[1][0] + a[0][2] * b.m_[2][0]);
+        } else {
+            // 按前两行和后两行的 2 阶子式展开 (Laplace), s 和 c 各 6 个
+            const Minors4 m = minors4();
+            const T* s = m.s;
+            const T* c = m.c;
+            b.m_[0][0] = a[1][1] * c[5] - a[1][2] * c[4] + a[1][3] * c[3];
+            b.m_[0][1] = -a[0][1] * c[5] + a[0][2] * c[4] - a[0][3] * c[3];
+            b.m_[0][2] = a[3][1] * s[5] - a[3][2] * s[4] + a[3][3] * s[3];
+            b.m_[0][3] = -a[2][1] * s[5] + a[2][2] * s[4] - a[2][3] * s[3];
+            b.m_[1][0] = -a[1][0] * c[5] + a[1][2] * c[2] - a[1][3] * c[1];
+            b.m_[1][1] = a[0][0] * c[5] - a[0][2] * c[2] + a[0][3] * c[1];
+            b.m_[1][2] = -a[3][0] * s[5] + a[3][2] * s[2] - a[3][3] * s[1];
+            b.m_[1][3] = a[2][0] * s[5] - a[2][2] * s[2] + a[2][3] * s[1];
+            b.m_[2][0] = a[1][0] * c[4] - a[1][1] * c[2] + a[1][3] * c[0];
+            b.m_[2][1] = -a[0][0] * c[4] + a[0][1] * c[2] - a[0][3] * c[0];
+            b.m_[2][2] = a[3][0] * s[4] - a[3][1] * s[2] + a[3][3] * s[0];
+            b.m_[2][3] = -a[2][0] * s[4] + a[2][1] * s[2] - a[2][3] * s[0];
+            b.m_[3][0] = -a[1][0] * c[3] + a[1][1] * c[1] - a[1][2] * c[0];
+            b.m_[3][1] = a[0][0] * c[3] - a[0][1] * c[1] + a[0][2] * c[0];
+            b.m_[3][2] = -a[3][0] * s[3] + a[3][1] * s[1] - a[3][2] * s[0];
+            b.m_[3][3] = a[2][0] * s[3] - a[2][1] * s[1] + a[2][2] * s[0];
+            b *= T(1) / m.det;
+        }
+        return b;
+    }
+
+    std::string to_string() const {
+        std::string str = "Mat [ ";
+        for (size_t i = 0; i < R; i++) {
+            str += fmt::format("{:.3f}", fmt::join(m_[i], m_[i] + C, ", "));
+            if (i != R - 1) {
+                str += ";\n ";
+            }
+        }
+        str += " ]";
+        return str;
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const Mat& m) {
+        os << m.to_string();
+        return os;
+    }
+
+    void print() const {
+        std::cout << *this << std::endl;
+    }
+
+private:
+    T m_[R][C] {};
+
+    struct Minors4 {
+        T s[6] {};
+        T c[6] {};
+        T det {};
+    };
+
+    // 4 阶矩阵前两行的 2 阶子式 s 和后两行的 2 阶子式 c
+    constexpr Minors4 minors4() const {
+        const auto& a = m_;
+        Minors4 r;
+        r.s[0] = a[0][0] * a[1][1] - a[1][0] * a[0][1];
+        r.s[1] = a[0][0] * a[1][2] - a[1][0] * a[0][2];
+        r.s[2] = a[0][0] * a[1][3] - a[1][0] * a[0][3];
+        r.s[3] = a[0][1] * a[1][2] - a[1][1] * a[0][2];
+        r.s[4] = a[0][1] * a[1][3] - a[1][1] * a[0][3];
+        r.s[5] = a[0][2] * a[1][3] - a[1][2] * a[0][3];
+        r.c[5] = a[2][2] * a[3][3] - a[3][2] * a[2][3];
+        r.c[4] = a[2][1] * a[3][3] - a[3][1] * a[2][3];
+        r.c[3] = a[2][1] * a[3][2] - a[3][1] * a[2][2];
+        r.c[2] = a[2][0] * a[3][3] - a[3][0] * a[2][3];
+        r.c[1] = a[2][0] * a[3][2] - a[3][0] * a[2][2];
+        r.c[0] = a[2][0] * a[3][1] - a[3][0] * a[2][1];
+        r.det = r.s[0] * r.c[5] - r.s[1] * r.c[4] + r.s[2] * r.c[3]
+              + r.s[3] * r.c[2] - r.s[4] * r.c[1] + r.s[5] * r.c[0];
+        return r;
+    }
+};
+
+using Vec2 = Vec<double, 2>;
+using Vec3 = Vec<double, 3>;
+using Vec4 = Vec<double, 4>;
+using Vec2f = Vec<float, 2>;
+using Vec3f = Vec<float, 3>;
+using Vec4f = Vec<float, 4>;
+
+using Mat2 = Mat<double, 2, 2>;
+using Mat3 = Mat<double, 3, 3>;
+using Mat4 = Mat<double, 4, 4>;
+using Mat2f = Mat<float, 2, 2>;
+using Mat3f = Mat<float, 3, 3>;
+using Mat4f = Mat<float, 4, 4>;
+
+}
@@ -0,0 +1,535 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+
+#include <zmath/utils/memory.h>
+#include <zmath/utils/simd.h>
+#include <zmath/utils/thread_pool.h>
+#include "linalg.h"
+
+// 分块 + 打包 + 寄存器分块微核的矩阵乘法 (GEMM), 结构参考 GotoBLAS / BLIS:
+//   C 按 NC 列, A/B 按 KC 分块, B 的 KC x NC 块打包成 NR 列宽的 panel (L3),
+//   A 的 MC x KC 块打包成 MR 行高的 panel (L2), 微核在寄存器中计算 MR x NR 的 C 块
+
+namespace zmath {
+
+namespace detail {
+
+// C[mr x nr] += alpha * A_panel[mr x kc] * B_panel[kc x nr]
+// A_panel 按列存放 (每个 p 连续 mr 个元素), B_panel 按行存放 (每个 p 连续 nr 个元素)
+using gemm_micro_kernel = void (*)(size_t kc, const double* a, const double* b,
+                                   double* c, size_t ldc, double alpha);
+
+struct GemmKernel {
+    SimdLevel level;
+    size_t mr;
+    size_t nr;
+    gemm_micro_kernel fn;
+};
+
+constexpr size_t gemm_mc = 96;   // MR 的整数倍
+constexpr size_t gemm_kc = 256;
+constexpr size_t gemm_nc = 2048; // NR 的整数倍
+constexpr size_t gemv_nb = 512;   // A^T x 每个列块的宽度, y 的一段 (4 KB) 留在 L1 中
+
+inline void gemm_kernel_scalar_4x4(size_t kc, const double* a, const double* b,
+                                   double* c, size_t ldc, double alpha) {
+    double acc[4][4] = {};
+    for (size_t p = 0; p < kc; p++) {
+        for (size_t i = 0; i < 4; i++) {
+            const double ai = a[i];
+            for (size_t j = 0; j < 4; j++) {
+                acc[i][j] += ai * b[j];
+            }
+        }
+        a += 4;
+        b += 4;
+    }
+    for (size_t i = 0; i < 4; i++) {
+        for (size_t j = 0; j < 4; j++) {
+            c[i * ldc + j] += alpha * acc[i][j];
+        }
+    }
+}
+
+#ifdef ZMATH_X86_SIMD
+
+__attribute__((target("avx2,fma")))
+inline void gemm_kernel_avx2_4x8(size_t kc, const double* a, const double* b,
+                                 double* c, size_t ldc, double alpha) {
+    __m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd();
+    __m256d c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+    __m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd();
+    __m256d c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+    for (size_t p = 0; p < kc; p++) {
+        const __m256d b0 = _mm256_loadu_pd(b);
+        const __m256d b1 = _mm256_loadu_pd(b + 4);
+        __m256d ai = _mm256_broadcast_sd(a);
+        c00 = _mm256_fmadd_pd(ai, b0, c00);
+        c01 = _mm256_fmadd_pd(ai, b1, c01);
+        ai = _mm256_broadcast_sd(a + 1);
+        c10 = _mm256_fmadd_pd(ai, b0, c10);
+        c11 = _mm256_fmadd_pd(ai, b1, c11);
+        ai = _mm256_broadcast_sd(a + 2);
+        c20 = _mm256_fmadd_pd(ai, b0, c20);
+        c21 = _mm256_fmadd_pd(ai, b1, c21);
+        ai = _mm256_broadcast_sd(a + 3);
+        c30 = _mm256_fmadd_pd(ai, b0, c30);
+        c31 = _mm256_fmadd_pd(ai, b1, c31);
+        a += 4;
+        b += 8;
+    }
+    const __m256d va = _mm256_set1_pd(alpha);
+    const __m256d acc[4][2] = { { c00, c01 }, { c10, c11 }, { c20, c21 }, { c30, c31 } };
+    for (int i = 0; i < 4; i++) {
+        double* ci = c + i * ldc;
+        _mm256_storeu_pd(ci, _mm256_fmadd_pd(va, acc[i][0], _mm256_loadu_pd(ci)));
+        _mm256_storeu_pd(ci + 4, _mm256_fmadd_pd(va, acc[i][1], _mm256_loadu_pd(ci + 4)));
+    }
+}
+
+__attribute__((target("avx512f")))
+inline void gemm_kernel_avx512_8x16(size_t kc, const double* a, const double* b,
+                                    double* c, size_t ldc, double alpha) {
+    __m512d acc[8][2];
+    for (int i = 0; i < 8; i++) {
+        acc[i][0] = _mm512_setzero_pd();
+        acc[i][1] = _mm512_setzero_pd();
+    }
+    for (size_t p = 0; p < kc; p++) {
+        const __m512d b0 = _mm512_loadu_pd(b);
+        const __m512d b1 = _mm512_loadu_pd(b + 8);
+#pragma GCC unroll 8
+        for (int i = 0; i < 8; i++) {
+            const __m512d ai = _mm512_set1_pd(a[i]);
+            acc[i][0] = _mm512_fmadd_pd(ai, b0, acc[i][0]);
+            acc[i][1] = _mm512_fmadd_pd(ai, b1, acc[i][1]);
+        }
+        a += 8;
+        b += 16;
+    }
+    const __m512d va = _mm512_set1_pd(alpha);
+    for (int i = 0; i < 8; i++) {
+        double* ci = c + i * ldc;
+        _mm512_storeu_pd(ci, _mm512_fmadd_pd(va, acc[i][0], _mm512_loadu_pd(ci)));
+        _mm512_storeu_pd(ci + 8, _mm512_fmadd_pd(va, acc[i][1], _mm512_loadu_pd(ci + 8)));
+    }
+}
+
+#endif
+
+inline GemmKernel gemm_kernel_for(SimdLevel level) {
+#ifdef ZMATH_X86_SIMD
+    if (level >= SimdLevel::AVX512 && cpu_simd_level() >= SimdLevel::AVX512)
+        return { SimdLevel::AVX512, 8, 16, gemm_kernel_avx512_8x16 };
+    if (level >= SimdLevel::AVX2 && cpu_simd_level() >= SimdLevel::AVX2)
+        return { SimdLevel::AVX2, 4, 8, gemm_kernel_avx2_4x8 };
+#endif
+    (void)level;
+    return { SimdLevel::Scalar, 4, 4, gemm_kernel_scalar_4x4 };
+}
+
+// 只保存指令集等级, 原子读写: GEMM 在线程池的多个工作线程上同时运行, 每次 GEMM 开始时读取一次
+inline std::atomic<SimdLevel>& gemm_requested_level() {
+    static std::atomic<SimdLevel> level { cpu_simd_level() };
+    return level;
+}
+
+inline GemmKernel gemm_active_kernel() {
+    return gemm_kernel_for(gemm_requested_level().load(std::memory_order_relaxed));
+}
+
+// 把 A 的 mc x kc 块打包成若干 mr 行的 panel, 不足 mr 行的部分补 0
+// (i, p) 元素位于 a[i * rs + p * cs]
+inline void gemm_pack_a(size_t mc, size_t kc, const double* a, size_t rs, size_t cs,
+                        size_t mr, double* buf) {
+    for (size_t i0 = 0; i0 < mc; i0 += mr) {
+        const size_t m = std::min(mr, mc - i0);
+        for (size_t p = 0; p < kc; p++) {
+            size_t i = 0;
+            for (; i < m; i++) {
+                buf[i] = a[(i0 + i) * rs + p * cs];
+            }
+            for (; i < mr; i++) {
+                buf[i] = 0.0;
+            }
+            buf += mr;
+        }
+    }
+}
+
+// 把 B 的 kc x nc 块打包成若干 nr 列的 panel, 不足 nr 列的部分补 0
+inline void gemm_pack_b(size_t kc, size_t nc, const double* b, size_t rs, size_t cs,
+                        size_t nr, double* buf) {
+    for (size_t j0 = 0; j0 < nc; j0 += nr) {
+        const size_t n = std::min(nr, nc - j0);
+        for (size_t p = 0; p < kc; p++) {
+            const double* bp = b + p * rs + j0 * cs;
+            size_t j = 0;
+            if (cs == 1) {
+                for (; j < n; j++) buf[j] = bp[j];
+            } else {
+                for (; j < n; j++) buf[j] = bp[j * cs];
+            }
+            for (; j < nr; j++) {
+                buf[j] = 0.0;
+            }
+            buf += nr;
+        }
+    }
+}
+
+// 打包好的 A 块 (mc x kc) 乘打包好的 B 块 (kc x nc), 累加到 C
+inline void gemm_macro_kernel(const GemmKernel& k, size_t mc, size_t nc, size_t kc,
+                              const double* pa, const double* pb,
+                              double* c, size_t ldc, double alpha) {
+    alignas(64) double tmp[16 * 16];
+    for (size_t j0 = 0; j0 < nc; j0 += k.nr) {
+        const size_t n = std::min(k.nr, nc - j0);
+        const double* b = pb + j0 * kc;
+        for (size_t i0 = 0; i0 < mc; i0 += k.mr) {
+            const size_t m = std::min(k.mr, mc - i0);
+            const double* a = pa + i0 * kc;
+            double* cij = c + i0 * ldc + j0;
+            if (m == k.mr && n == k.nr) {
+                k.fn(kc, a, b, cij, ldc, alpha);
+            } else {
+                // 边角块先算到临时缓冲区
+                std::fill(tmp, tmp + k.mr * k.nr, 0.0);
+                k.fn(kc, a, b, tmp, k.nr, alpha);
+                for (size_t i = 0; i < m; i++) {
+                    for (size_t j = 0; j < n; j++) {
+                        cij[i * ldc + j] += tmp[i * k.nr + j];
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief C = alpha * op(A) * op(B) + beta * C 的通用实现
+ * 
+ * op(A) 是 m x k, 其 (i, p) 元素位于 a[i * rsa + p * csa]; B 同理.
+ * 打包缓冲区全部由调用线程从 ws 切出: B 的 panel 由所有任务共享, A 的 panel 按并行块分槽位,
+ * 每个并行块独占一个槽位, 工作线程不分配内存
+ */
+inline void gemm_strided(size_t m, size_t n, size_t k, double alpha,
+                         const double* a, size_t rsa, size_t csa,
+                         const double* b, size_t rsb, size_t csb,
+                         double beta, double* c, size_t ldc, Workspace& ws) {
+    if (m == 0 || n == 0) return;
+
+    // 先处理 beta, beta == 0 时直接清零 (不传播 C 中的 NaN)
+    if (beta != 1.0) {
+        for (size_t i = 0; i < m; i++) {
+            double* ci = c + i * ldc;
+            if (beta == 0.0) {
+                std::fill(ci, ci + n, 0.0);
+            } else {
+                for (size_t j = 0; j < n; j++) ci[j] *= beta;
+            }
+        }
+    }
+    if (k == 0 || alpha == 0.0) return;
+
+    const GemmKernel kernel = gemm_active_kernel();
+    const size_t m_blocks = (m + gemm_mc - 1) / gemm_mc;
+    const size_t threads = num_threads();
+    // A 的行块不够分给所有线程时, 再把 C 的列切成若干片
+    auto slices_for = [&](size_t n_panels) {
+        return std::min(n_panels, (threads + m_blocks - 1) / m_blocks);
+    };
+
+    Workspace::Scope scope(ws);
+    const size_t kc_max = std::min(gemm_kc, k);
+    const size_t panels_max = (std::min(gemm_nc, n) + kernel.nr - 1) / kernel.nr;
+    const size_t mc_max = std::min(gemm_mc, (m + kernel.mr - 1) / kernel.mr * kernel.mr);
+    const size_t slots = std::min(threads, m_blocks * slices_for(panels_max));
+    double* pb = ws.allocate<double>(kc_max * panels_max * kernel.nr);
+    double* pa_slots = ws.allocate<double>(slots * mc_max * kc_max);
+
+    for (size_t jc = 0; jc < n; jc += gemm_nc) {
+        const size_t nc = std::min(gemm_nc, n - jc);
+        const size_t n_panels = (nc + kernel.nr - 1) / kernel.nr;
+        const size_t n_slices = slices_for(n_panels);
+        const size_t tasks = m_blocks * n_slices;
+        const size_t chunks = std::min(slots, tasks);
+        for (size_t pc = 0; pc < k; pc += gemm_kc) {
+            const size_t kc = std::min(gemm_kc, k - pc);
+            const double* bp = b + pc * rsb + jc * csb;
+            parallel_for(0, n_panels, 16, [&](size_t lo, size_t hi) {
+                const size_t j0 = lo * kernel.nr;
+                const size_t j1 = std::min(nc, hi * kernel.nr);
+                gemm_pack_b(kc, j1 - j0, bp + j0 * csb, rsb, csb, kernel.nr, pb + j0 * kc);
+            });
+
+            // 每个任务负责 C 的一个 MC 行块和一片列, 写入互不重叠.
+            // 任务连续地分成 chunks 块, 每块用第 lo 个槽位打包 A; 嵌套串行执行时 lo == 0, 只用一个槽位
+            parallel_for(0, chunks, 1, [&](size_t lo, size_t hi) {
+                double* pa = pa_slots + lo * mc_max * kc_max;
+                for (size_t t = tasks * lo / chunks; t < tasks * hi / chunks; t++) {
+                    const size_t ic = (t / n_slices) * gemm_mc;
+                    const size_t s = t % n_slices;
+                    const size_t p0 = n_panels * s / n_slices, p1 = n_panels * (s + 1) / n_slices;
+                    const size_t j0 = p0 * kernel.nr, j1 = std::min(nc, p1 * kernel.nr);
+                    if (j0 >= j1) continue;
+                    const size_t mc = std::min(gemm_mc, m - ic);
+                    gemm_pack_a(mc, kc, a + ic * rsa + pc * csa, rsa, csa, kernel.mr, pa);
+                    gemm_macro_kernel(kernel, mc, j1 - j0, kc, pa, pb + j0 * kc,
+                                      c + ic * ldc + jc + j0, ldc, alpha);
+                }
+            });
+        }
+    }
+}
+
+// 打包缓冲区来自调用线程自己的工作区
+inline void gemm_strided(size_t m, size_t n, size_t k, double alpha,
+                         const double* a, size_t rsa, size_t csa,
+                         const double* b, size_t rsb, size_t csb,
+                         double beta, double* c, size_t ldc) {
+    gemm_strided(m, n, k, alpha, a, rsa, csa, b, rsb, csb, beta, c, ldc, thread_workspace());
+}
+
+}
+
+/**
+ * @brief 强制 GEMM 使用不超过 level 的指令集 (用于测试和对比), 返回实际使用的等级
+ *
+ * 线程安全; 正在进行的 GEMM 继续使用开始时的内核, 之后开始的 GEMM 使用新的等级
+ */
+inline SimdLevel set_gemm_simd_level(SimdLevel level) {
+    const SimdLevel actual = detail::gemm_kernel_for(level).level;
+    detail::gemm_requested_level().store(actual, std::memory_order_relaxed);
+    return actual;
+}
+
+inline SimdLevel gemm_simd_level() {
+    return detail::gemm_active_kernel().level;
+}
+
+/**
+ * @brief C = alpha * A * B + beta * C
+ * 
+ * @param A m x k
+ * @param B k x n
+ * @param C m x n, beta == 0 时 C 的原有内容被忽略
+ * @param ws 打包缓冲区从这里切出, 返回前归还
+ */
+inline void gemm(double alpha, ConstMatrixView A, ConstMatrixView B, double beta, MatrixView C, Workspace& ws) {
+    assert(A.cols() == B.rows() && A.rows() == C.rows() && B.cols() == C.cols());
+    detail::gemm_strided(C.rows(), C.cols(), A.cols(), alpha,
+                         A.data(), A.ld(), 1, B.data(), B.ld(), 1,
+                         beta, C.data(), C.ld(), ws);
+}
+
+// 打包缓冲区来自调用线程自己的工作区, 同样规模的调用第二次起不再分配
+inline void gemm(double alpha, ConstMatrixView A, ConstMatrixView B, double beta, MatrixView C) {
+    gemm(alpha, A, B, beta, C, detail::thread_workspace());
+}
+
+inline void gemm(double alpha, const Matrix& A, const Matrix& B, double beta, Matrix& C) {
+    gemm(alpha, A.view(), B.view(), beta, C.view());
+}
+
+namespace detail {
+
+inline const Matrix& eval_matrix(const Matrix& m) {
+    return m;
+}
+
+template <typename E>
+Matrix eval_matrix(const MatrixExpr<E>& e) {
+    return Matrix(e);
+}
+
+// 转置不求值, 由 gemm_operand 换成转置的步长
+template <typename M>
+const TransposeExpr<M>& eval_matrix(const TransposeExpr<M>& t) {
+    return t;
+}
+
+// GEMM 的一个操作数: rows x cols, (i, p) 元素位于 data[i * rs + p * cs]
+struct GemmOperand {
+    const double* data;
+    size_t rs, cs;
+    size_t rows, cols;
+};
+
+inline GemmOperand gemm_operand(const Matrix& m) {
+    return { m.data(), m.ld(), 1, m.rows(), m.cols() };
+}
+
+template <typename M>
+GemmOperand gemm_operand(const TransposeExpr<M>& t) {
+    const Matrix& m = t.nested();
+    return { m.data(), 1, m.ld(), m.cols(), m.rows() };
+}
+
+}
+
+// 矩阵乘法. 逐元素表达式先求值, 例如 (A + B) * C; 转置不求值, 例如 A.T() * B 直接交给 GEMM 打包.
+// Matrix * Matrix 也走这里, 不另写非模板的重载, 否则 Matrix 与表达式相乘时两者都可行, 产生二义性
+template <typename L, typename R>
+Matrix operator*(const MatrixExpr<L>& lhs, const MatrixExpr<R>& rhs) {
+    const auto& a = detail::eval_matrix(lhs.derived());
+    const auto& b = detail::eval_matrix(rhs.derived());
+    const detail::GemmOperand oa = detail::gemm_operand(a), ob = detail::gemm_operand(b);
+    assert(oa.cols == ob.rows);
+    Matrix C(oa.rows, ob.cols);
+    detail::gemm_strided(C.rows(), C.cols(), oa.cols, 1.0, oa.data, oa.rs, oa.cs, ob.data, ob.rs, ob.cs,
+                         0.0, C.data(), C.ld());
+    return C;
+}
+
+/**
+ * @brief A += alpha * x * y^T (rank-1 更新). 按行分给线程池, 内层循环连续访问 A 的一行
+ *
+ * 与 BLAS 相同, x 和 y 不能与 A 重叠
+ */
+inline void ger(double alpha, ConstVectorView x, ConstVectorView y, MatrixView A, Workspace& ws) {
+    assert(x.size() == A.rows() && y.size() == A.cols());
+    const size_t n = A.cols();
+    // y 不连续时先拷贝到 ws, 内层循环才能向量化; 连续时直接使用
+    Workspace::Scope scope(ws);
+    const double* yc = y.data();
+    if (y.stride() != 1) {
+        double* buf = ws.allocate<double>(n);
+        for (size_t j = 0; j < n; j++) buf[j] = y(j);
+        yc = buf;
+    }
+    const size_t grain = std::max<size_t>(1, detail::expr_parallel_grain / std::max<size_t>(n, 1));
+    parallel_for(0, A.rows(), grain, [&](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; i++) {
+            const double s = alpha * x(i);
+            if (s == 0.0) continue;
+            double* ai = A.row_ptr(i);
+            for (size_t j = 0; j < n; j++) {
+                ai[j] += s * yc[j];
+            }
+        }
+    });
+}
+
+inline void ger(double alpha, ConstVectorView x, ConstVectorView y, MatrixView A) {
+    ger(alpha, x, y, A, detail::thread_workspace());
+}
+
+/**
+ * @brief C += alpha * sum_p U(:, p) * V(p, :), 即 k 个外积一次累加 (rank-k 更新)
+ *
+ * 逐个做 ger 每次都要完整读写一遍 C, 这里交给 GEMM, C 的每个块只读写一次
+ *
+ * @param U m x k, 每列是一个列向量
+ * @param V k x n, 每行是一个行向量
+ */
+inline void rank_k_update(double alpha, ConstMatrixView U, ConstMatrixView V, MatrixView C) {
+    gemm(alpha, U, V, 1.0, C);
+}
+
+inline void rank_k_update(double alpha, const Matrix& U, const Matrix& V, Matrix& C) {
+    rank_k_update(alpha, U.view(), V.view(), C.view());
+}
+
+/**
+ * @brief Gram 矩阵 X^T X = sum_i x_i^T x_i, x_i 是 X 的第 i 行 (一个样本)
+ *
+ * 不形成 X^T, 用转置的步长直接交给 GEMM 打包
+ */
+inline Matrix gram(ConstMatrixView X) {
+    const size_t n = X.cols();
+    Matrix G(n, n);
+    detail::gemm_strided(n, n, X.rows(), 1.0,
+                         X.data(), 1, X.ld(), X.data(), X.ld(), 1,
+                         0.0, G.data(), G.ld());
+    return G;
+}
+
+inline Matrix gram(const Matrix& X) {
+    return gram(X.view());
+}
+
+/**
+ * @brief 批量内积 out[i] = A(i, :) . x, 即 y = A x. 按行分给线程池
+ */
+inline void dot_batch(ConstMatrixView A, ConstVectorView x, double* out) {
+    assert(x.size() == A.cols());
+    const size_t n = A.cols();
+    // x 连续时直接使用, 不拷贝 (迭代法每步都会调用)
+    aligned_vector<double> xc;
+    const double* xp = x.data();
+    if (x.stride() != 1) {
+        xc.resize(n);
+        for (size_t j = 0; j < n; j++) xc[j] = x(j);
+        xp = xc.data();
+    }
+    const size_t grain = std::max<size_t>(1, detail::expr_parallel_grain / std::max<size_t>(n, 1));
+    parallel_for(0, A.rows(), grain, [&](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; i++) {
+            const double* ai = A.row_ptr(i);
+            double s = 0.0;
+            for (size_t j = 0; j < n; j++) {
+                s += ai[j] * xp[j];
+            }
+            out[i] = s;
+        }
+    });
+}
+
+inline Vector operator*(const Matrix& A, const Vector& x) {
+    Vector y(A.get_row_size());
+    dot_batch(A.view(), x.view(), y.data());
+    return y;
+}
+
+/**
+ * @brief out = A^T x, 不形成 A^T: out += x(i) * A(i, :) 逐行累加, 内层循环连续访问 A 的一行
+ *
+ * 按 gemv_nb 列一块分给线程池, 各块写 out 的不同部分, 不需要归约. 每次累加 4 行, out 的一段只读写 rows / 4 次
+ */
+inline void gemv_transpose(ConstMatrixView A, ConstVectorView x, double* out) {
+    assert(x.size() == A.rows());
+    const size_t m = A.rows(), n = A.cols();
+    const size_t blocks = (n + detail::gemv_nb - 1) / detail::gemv_nb;
+    const size_t grain = std::max<size_t>(1, detail::expr_parallel_grain / std::max<size_t>(m * detail::gemv_nb, 1));
+    parallel_for(0, blocks, grain, [&](size_t lo, size_t hi) {
+        const size_t j0 = lo * detail::gemv_nb, j1 = std::min(n, hi * detail::gemv_nb);
+        double* y = out + j0;
+        const size_t w = j1 - j0;
+        std::fill(y, y + w, 0.0);
+        size_t i = 0;
+        for (; i + 4 <= m; i += 4) {
+            const double x0 = x(i), x1 = x(i + 1), x2 = x(i + 2), x3 = x(i + 3);
+            const double* a0 = A.row_ptr(i) + j0;
+            const double* a1 = A.row_ptr(i + 1) + j0;
+            const double* a2 = A.row_ptr(i + 2) + j0;
+            const double* a3 = A.row_ptr(i + 3) + j0;
+            for (size_t j = 0; j < w; j++) {
+                y[j] += x0 * a0[j] + x1 * a1[j] + x2 * a2[j] + x3 * a3[j];
+            }
+        }
+        for (; i < m; i++) {
+            const double xi = x(i);
+            const double* ai = A.row_ptr(i) + j0;
+            for (size_t j = 0; j < w; j++) {
+                y[j] += xi * ai[j];
+            }
+        }
+    });
+}
+
+/**
+ * @brief A^T x, 不形成 A^T, 见 gemv_transpose
+ */
+template <typename M>
+Vector operator*(const TransposeExpr<M>& At, const Vector& x) {
+    const Matrix& A = At.nested();
+    Vector y(A.cols());
+    gemv_transpose(A.view(), x.view(), y.data());
+    return y;
+}
+
+}
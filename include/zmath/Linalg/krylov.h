@@ -0,0 +1,562 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <zmath/utils/memory.h>
+#include <zmath/utils/thread_pool.h>
+#include "linalg.h"
+#include "gemm.h"
+#include "sparse.h"
+
+// 求解 Ax = b 的 Krylov 子空间迭代法: CG (A 对称正定), BiCGSTAB 和重启 GMRES (一般方阵).
+// A 只需要能计算 y = A x: 可以是 Matrix, CsrMatrix, CscMatrix, 或者 void(const double* x, double* y) 的函数对象.
+// 每次迭代的主要开销是一次 (BiCGSTAB 两次) 矩阵向量乘法, 稀疏矩阵为 O(nnz).
+// 求解器对象持有全部工作向量和矩阵向量乘法的工作区, 反复求解同样大小的方程时不再分配内存
+
+namespace zmath {
+
+/**
+ * @brief 迭代法的参数
+ */
+struct IterativeOptions {
+    double tol = 1e-10;     // 相对残差 ||b - Ax|| / ||b|| 不超过 tol 时停止
+    size_t max_iter = 1000; // 最多迭代次数, GMRES 按内层迭代计数
+    size_t restart = 30;    // GMRES 的重启长度
+    bool history = true;    // 是否记录每次迭代后的相对残差
+};
+
+/**
+ * @brief 迭代法的结果. history[0] 是初始残差, 之后每次迭代一项
+ */
+struct IterativeResult {
+    bool converged = false;
+    size_t iterations = 0;
+    double residual = 0.0;
+    std::vector<double> history;
+
+    std::string to_string() const {
+        return fmt::format("{} after {} iterations, residual {:.3e}",
+                           converged ? "converged" : "not converged", iterations, residual);
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const IterativeResult& r) {
+        os << r.to_string();
+        return os;
+    }
+
+    void print() const {
+        std::cout << *this << std::endl;
+    }
+};
+
+/**
+ * @brief 不做预条件, 求解器遇到它时直接跳过预条件这一步
+ */
+struct IdentityPreconditioner { };
+
+/**
+ * @brief Jacobi 预条件 z = D^{-1} r, D 是 A 的对角线
+ */
+class JacobiPreconditioner {
+public:
+    JacobiPreconditioner() = default;
+
+    explicit JacobiPreconditioner(const Matrix& A) : inv_diag_(std::min(A.rows(), A.cols())) {
+        for (size_t i = 0; i < inv_diag_.size(); i++) {
+            inv_diag_[i] = inverse(A(i, i));
+        }
+    }
+
+    explicit JacobiPreconditioner(const CsrMatrix& A) : inv_diag_(std::min(A.rows(), A.cols())) {
+        for (size_t i = 0; i < inv_diag_.size(); i++) {
+            inv_diag_[i] = inverse(A(i, i));
+        }
+    }
+
+    void apply(const double* r, double* z) const {
+        const size_t n = inv_diag_.size();
+        parallel_for(0, n, size_t(1) << 15, [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; i++) {
+                z[i] = inv_diag_[i] * r[i];
+            }
+        });
+    }
+
+private:
+    aligned_vector<double> inv_diag_;
+
+    // 对角元为 0 时该分量不做缩放. TODO if (d == 0) error
+    static double inverse(double d) {
+        return d != 0.0 ? 1.0 / d : 1.0;
+    }
+};
+
+/**
+ * @brief 零填充的不完全 LU 分解 ILU(0): L U 与 A 的非零结构相同, z = U^{-1} L^{-1} r
+ *
+ * 要求 A 是方阵, 每行的列下标有序 (CsrMatrix::from_triplets 保证) 且对角元都在非零结构中, 否则抛出 std::invalid_argument.
+ * 两次三角求解是串行的, 对收敛慢的问题迭代次数的减少通常能抵消这部分开销
+ */
+class Ilu0Preconditioner {
+public:
+    Ilu0Preconditioner() = default;
+
+    explicit Ilu0Preconditioner(const CsrMatrix& A)
+        : n_(A.rows()), row_ptr_(A.row_ptr()), col_idx_(A.col_idx()),
+          values_(A.values().begin(), A.values().end()), diag_(A.rows()) {
+        if (A.rows() != A.cols()) {
+            throw std::invalid_argument("zmath: ILU(0) needs a square matrix");
+        }
+        constexpr size_t none = std::numeric_limits<size_t>::max();
+        std::vector<size_t> pos(n_, none); // 当前行中第 j 列元素的位置
+        for (size_t i = 0; i < n_; i++) {
+            const size_t k0 = row_ptr_[i], k1 = row_ptr_[i + 1];
+            for (size_t k = k0; k < k1; k++) {
+                pos[col_idx_[k]] = k;
+            }
+            if (pos[i] == none) {
+                throw std::invalid_argument("zmath: ILU(0) needs every diagonal entry in the sparsity pattern");
+            }
+            diag_[i] = pos[i];
+            // IKJ 顺序的消去, 只更新第 i 行已有的非零元
+            for (size_t k = k0; k < k1 && col_idx_[k] < i; k++) {
+                const size_t c = col_idx_[k];
+                const double l = values_[k] /= values_[diag_[c]];
+                for (size_t kk = diag_[c] + 1; kk < row_ptr_[c + 1]; kk++) {
+                    const size_t p = pos[col_idx_[kk]];
+                    if (p != none) {
+                        values_[p] -= l * values_[kk];
+                    }
+                }
+            }
+            for (size_t k = k0; k < k1; k++) {
+                pos[col_idx_[k]] = none;
+            }
+        }
+    }
+
+    void apply(const double* r, double* z) const {
+        // L 是单位下三角
+        for (size_t i = 0; i < n_; i++) {
+            double s = r[i];
+            for (size_t k = row_ptr_[i]; k < diag_[i]; k++) {
+                s -= values_[k] * z[col_idx_[k]];
+            }
+            z[i] = s;
+        }
+        for (size_t i = n_; i-- > 0; ) {
+            double s = z[i];
+            for (size_t k = diag_[i] + 1; k < row_ptr_[i + 1]; k++) {
+                s -= values_[k] * z[col_idx_[k]];
+            }
+            z[i] = s / values_[diag_[i]];
+        }
+    }
+
+private:
+    size_t n_ = 0;
+    std::vector<size_t> row_ptr_;
+    std::vector<sparse_index> col_idx_;
+    aligned_vector<double> values_;
+    std::vector<size_t> diag_;
+};
+
+namespace detail {
+
+// 向量运算每块至少这么多个元素才分给线程池
+constexpr size_t krylov_grain = size_t(1) << 14;
+// 内积最多分成这么多块; 块的划分只取决于 n, 所以结果与线程数无关
+constexpr size_t krylov_max_blocks = 64;
+
+// y = A x. ws 是求解器持有的工作区, 只有 CSC 的散射用到它
+inline void apply_operator(const Matrix& A, const double* x, double* y, Workspace&) {
+    dot_batch(A.view(), ConstVectorView(x, A.cols()), y);
+}
+
+inline void apply_operator(const CsrMatrix& A, const double* x, double* y, Workspace&) {
+    A.multiply(x, y);
+}
+
+inline void apply_operator(const CscMatrix& A, const double* x, double* y, Workspace& ws) {
+    A.multiply(x, y, 1.0, 0.0, ws);
+}
+
+template <typename F>
+void apply_operator(const F& f, const double* x, double* y, Workspace&) {
+    f(x, y);
+}
+
+// 不做预条件时返回 r 本身, 否则把 M^{-1} r 写入 z 并返回 z
+template <typename P>
+const double* precondition(const P& M, const double* r, double* z) {
+    if constexpr (std::is_same_v<P, IdentityPreconditioner>) {
+        return r;
+    } else {
+        M.apply(r, z);
+        return z;
+    }
+}
+
+inline double krylov_dot(const double* a, const double* b, size_t n) {
+    const size_t bs = std::max(krylov_grain, (n + krylov_max_blocks - 1) / krylov_max_blocks);
+    const size_t nb = (n + bs - 1) / bs;
+    double partial[krylov_max_blocks];
+    parallel_for(0, nb, 1, [&](size_t lo, size_t hi) {
+        for (size_t b0 = lo; b0 < hi; b0++) {
+            const size_t i1 = std::min(n, (b0 + 1) * bs);
+            double s = 0.0;
+            for (size_t i = b0 * bs; i < i1; i++) {
+                s += a[i] * b[i];
+            }
+            partial[b0] = s;
+        }
+    });
+    double s = 0.0;
+    for (size_t b0 = 0; b0 < nb; b0++) {
+        s += partial[b0];
+    }
+    return s;
+}
+
+inline double krylov_norm(const double* a, size_t n) {
+    return std::sqrt(krylov_dot(a, a, n));
+}
+
+// 对 i in [0, n) 调用 f(i), 按块分给线程池
+template <typename F>
+void krylov_update(size_t n, F f) {
+    parallel_for(0, n, krylov_grain, [&](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; i++) {
+            f(i);
+        }
+    });
+}
+
+// r = b - A x
+template <typename Op>
+void krylov_residual(const Op& A, const double* b, const double* x, double* r, size_t n, Workspace& ws) {
+    apply_operator(A, x, r, ws);
+    krylov_update(n, [&](size_t i) { r[i] = b[i] - r[i]; });
+}
+
+// 记录一次迭代后的相对残差, 返回是否已经收敛
+inline bool krylov_record(IterativeResult& result, const IterativeOptions& opt, double residual) {
+    result.residual = residual;
+    if (opt.history) {
+        result.history.push_back(residual);
+    }
+    result.converged = residual <= opt.tol;
+    return result.converged;
+}
+
+}
+
+/**
+ * @brief 迭代法求解器的公共部分: 参数, 工作向量和 Vector 接口. Derived 实现 solve(A, b, x, n, M)
+ */
+template <typename Derived>
+class KrylovSolver {
+public:
+    explicit KrylovSolver(IterativeOptions opt = {}) : opt_(opt) { }
+
+    IterativeOptions& options() {
+        return opt_;
+    }
+
+    const IterativeOptions& options() const {
+        return opt_;
+    }
+
+    /**
+     * @brief 求解 Ax = b, x 是初始猜测, 结果写回 x. x 的大小与 b 不同时从 0 开始
+     */
+    template <typename Op, typename P = IdentityPreconditioner>
+    IterativeResult solve(const Op& A, const Vector& b, Vector& x, const P& M = {}) {
+        if (x.size() != b.size()) {
+            x = Vector(b.size());
+        }
+        return static_cast<Derived&>(*this).solve(A, b.data(), x.data(), b.size(), M);
+    }
+
+    /**
+     * @brief 从 x = 0 开始求解 Ax = b, 返回 x. info 非空时写入迭代的结果
+     */
+    template <typename Op, typename P = IdentityPreconditioner>
+    Vector solve(const Op& A, const Vector& b, const P& M = {}, IterativeResult* info = nullptr) {
+        Vector x(b.size());
+        IterativeResult r = solve(A, b, x, M);
+        if (info) {
+            *info = std::move(r);
+        }
+        return x;
+    }
+
+protected:
+    IterativeOptions opt_;
+    aligned_vector<double> work_;
+    Workspace ws_; // 矩阵向量乘法的临时数组 (CSC 的散射)
+
+    // 准备 k 个长度为 n 的工作向量, 返回第一个的地址; 大小不变时不重新分配
+    double* workspace(size_t k, size_t n) {
+        if (work_.size() < k * n) {
+            work_.resize(k * n);
+        }
+        return work_.data();
+    }
+
+    // b = 0 时解就是 0, 不必迭代
+    static bool trivial(double* x, size_t n, double bnorm, IterativeResult& result) {
+        if (bnorm != 0.0) {
+            return false;
+        }
+        std::fill(x, x + n, 0.0);
+        result.converged = true;
+        result.residual = 0.0;
+        return true;
+    }
+};
+
+/**
+ * @brief 预条件共轭梯度法, A 和 M 都必须对称正定
+ */
+class ConjugateGradient : public KrylovSolver<ConjugateGradient> {
+public:
+    using KrylovSolver::KrylovSolver;
+    using KrylovSolver::solve;
+
+    template <typename Op, typename P = IdentityPreconditioner>
+    IterativeResult solve(const Op& A, const double* b, double* x, size_t n, const P& M = {}) {
+        IterativeResult result;
+        const double bnorm = detail::krylov_norm(b, n);
+        if (trivial(x, n, bnorm, result)) {
+            return result;
+        }
+        double* r = workspace(4, n);
+        double* z = r + n;
+        double* p = z + n;
+        double* q = p + n;
+
+        detail::krylov_residual(A, b, x, r, n, ws_);
+        if (detail::krylov_record(result, opt_, detail::krylov_norm(r, n) / bnorm)) {
+            return result;
+        }
+        const double* zr = detail::precondition(M, r, z);
+        std::copy(zr, zr + n, p);
+        double rz = detail::krylov_dot(r, zr, n);
+        while (result.iterations < opt_.max_iter) {
+            detail::apply_operator(A, p, q, ws_);
+            const double alpha = rz / detail::krylov_dot(p, q, n);
+            detail::krylov_update(n, [&](size_t i) {
+                x[i] += alpha * p[i];
+                r[i] -= alpha * q[i];
+            });
+            result.iterations++;
+            if (detail::krylov_record(result, opt_, detail::krylov_norm(r, n) / bnorm)) {
+                break;
+            }
+            zr = detail::precondition(M, r, z);
+            const double rz_new = detail::krylov_dot(r, zr, n);
+            const double beta = rz_new / rz;
+            rz = rz_new;
+            detail::krylov_update(n, [&](size_t i) { p[i] = zr[i] + beta * p[i]; });
+        }
+        return result;
+    }
+};
+
+/**
+ * @brief 右预条件的 BiCGSTAB, 适用于一般 (非对称) 方阵. 每次迭代两次矩阵向量乘法, 两次预条件
+ */
+class BiCGSTAB : public KrylovSolver<BiCGSTAB> {
+public:
+    using KrylovSolver::KrylovSolver;
+    using KrylovSolver::solve;
+
+    template <typename Op, typename P = IdentityPreconditioner>
+    IterativeResult solve(const Op& A, const double* b, double* x, size_t n, const P& M = {}) {
+        IterativeResult result;
+        const double bnorm = detail::krylov_norm(b, n);
+        if (trivial(x, n, bnorm, result)) {
+            return result;
+        }
+        // s = r - alpha v 直接写在 r 上
+        double* r = workspace(7, n);
+        double* r0 = r + n;
+        double* p = r0 + n;
+        double* v = p + n;
+        double* t = v + n;
+        double* ph = t + n;
+        double* sh = ph + n;
+
+        detail::krylov_residual(A, b, x, r, n, ws_);
+        if (detail::krylov_record(result, opt_, detail::krylov_norm(r, n) / bnorm)) {
+            return result;
+        }
+        std::copy(r, r + n, r0);
+        std::fill(p, p + n, 0.0);
+        std::fill(v, v + n, 0.0);
+        double rho = 1.0, alpha = 1.0, omega = 1.0;
+        while (result.iterations < opt_.max_iter) {
+            const double rho_new = detail::krylov_dot(r0, r, n);
+            // r 与 r0 正交时方法失效
+            if (rho_new == 0.0) {
+                break;
+            }
+            const double beta = rho_new / rho * (alpha / omega);
+            rho = rho_new;
+            detail::krylov_update(n, [&](size_t i) { p[i] = r[i] + beta * (p[i] - omega * v[i]); });
+
+            const double* php = detail::precondition(M, p, ph);
+            detail::apply_operator(A, php, v, ws_);
+            alpha = rho / detail::krylov_dot(r0, v, n);
+            detail::krylov_update(n, [&](size_t i) { r[i] -= alpha * v[i]; });
+            result.iterations++;
+            const double s_norm = detail::krylov_norm(r, n) / bnorm;
+            if (s_norm <= opt_.tol) {
+                detail::krylov_update(n, [&](size_t i) { x[i] += alpha * php[i]; });
+                detail::krylov_record(result, opt_, s_norm);
+                break;
+            }
+
+            const double* shp = detail::precondition(M, r, sh);
+            detail::apply_operator(A, shp, t, ws_);
+            const double tt = detail::krylov_dot(t, t, n);
+            omega = tt != 0.0 ? detail::krylov_dot(t, r, n) / tt : 0.0;
+            detail::krylov_update(n, [&](size_t i) {
+                x[i] += alpha * php[i] + omega * shp[i];
+                r[i] -= omega * t[i];
+            });
+            if (detail::krylov_record(result, opt_, detail::krylov_norm(r, n) / bnorm) || omega == 0.0) {
+                break;
+            }
+        }
+        return result;
+    }
+};
+
+/**
+ * @brief 右预条件的重启 GMRES(m), m = options().restart. 适用于一般方阵, 内层迭代的残差单调不增
+ *
+ * 正交化用修正的 Gram-Schmidt, 工作空间为 (m + 3) 个长度为 n 的向量
+ */
+class GMRES : public KrylovSolver<GMRES> {
+public:
+    using KrylovSolver::KrylovSolver;
+    using KrylovSolver::solve;
+
+    template <typename Op, typename P = IdentityPreconditioner>
+    IterativeResult solve(const Op& A, const double* b, double* x, size_t n, const P& M = {}) {
+        IterativeResult result;
+        const double bnorm = detail::krylov_norm(b, n);
+        if (trivial(x, n, bnorm, result)) {
+            return result;
+        }
+        const size_t m = std::max<size_t>(1, opt_.restart);
+        double* V = workspace(m + 3, n); // Krylov 子空间的基 V_0 .. V_m
+        double* w = V + (m + 1) * n;
+        double* u = w + n;
+        h_.assign((m + 1) * m, 0.0);
+        cs_.resize(m);
+        sn_.resize(m);
+        g_.resize(m + 1);
+        auto H = [&](size_t i, size_t j) -> double& { return h_[j * (m + 1) + i]; };
+
+        bool first = true;
+        while (true) {
+            detail::krylov_residual(A, b, x, V, n, ws_);
+            const double beta = detail::krylov_norm(V, n);
+            if (first) {
+                first = false;
+                if (detail::krylov_record(result, opt_, beta / bnorm)) {
+                    break;
+                }
+            } else {
+                // 重启时用真实残差代替内层的估计值
+                result.residual = beta / bnorm;
+                result.converged = result.residual <= opt_.tol;
+            }
+            if (result.converged || result.iterations >= opt_.max_iter) {
+                break;
+            }
+            detail::krylov_update(n, [&](size_t i) { V[i] /= beta; });
+            std::fill(g_.begin(), g_.end(), 0.0);
+            g_[0] = beta;
+
+            size_t k = 0;
+            while (k < m && result.iterations < opt_.max_iter) {
+                double* vk = V + k * n;
+                double* vn = vk + n;
+                detail::apply_operator(A, detail::precondition(M, vk, w), vn, ws_);
+                for (size_t i = 0; i <= k; i++) {
+                    const double* vi = V + i * n;
+                    const double h = detail::krylov_dot(vn, vi, n);
+                    H(i, k) = h;
+                    detail::krylov_update(n, [&](size_t l) { vn[l] -= h * vi[l]; });
+                }
+                const double hn = detail::krylov_norm(vn, n);
+                H(k + 1, k) = hn;
+                if (hn != 0.0) {
+                    detail::krylov_update(n, [&](size_t l) { vn[l] /= hn; });
+                }
+                // 用之前的 Givens 旋转消去新列, 再构造消去 H(k + 1, k) 的旋转
+                for (size_t i = 0; i < k; i++) {
+                    const double a = H(i, k), c = H(i + 1, k);
+                    H(i, k) = cs_[i] * a + sn_[i] * c;
+                    H(i + 1, k) = -sn_[i] * a + cs_[i] * c;
+                }
+                const double d = std::hypot(H(k, k), hn);
+                cs_[k] = d != 0.0 ? H(k, k) / d : 1.0;
+                sn_[k] = d != 0.0 ? hn / d : 0.0;
+                H(k, k) = d;
+                H(k + 1, k) = 0.0;
+                g_[k + 1] = -sn_[k] * g_[k];
+                g_[k] = cs_[k] * g_[k];
+                k++;
+                result.iterations++;
+                // hn = 0 时 Krylov 子空间不再增长, 当前的解已经是精确解
+                if (detail::krylov_record(result, opt_, std::abs(g_[k]) / bnorm) || hn == 0.0) {
+                    break;
+                }
+            }
+
+            // 回代求 H y = g, 再令 x += M^{-1} V y
+            for (size_t i = k; i-- > 0; ) {
+                double s = g_[i];
+                for (size_t j = i + 1; j < k; j++) {
+                    s -= H(i, j) * g_[j];
+                }
+                g_[i] = H(i, i) != 0.0 ? s / H(i, i) : 0.0;
+            }
+            detail::krylov_update(n, [&](size_t l) {
+                double s = 0.0;
+                for (size_t j = 0; j < k; j++) {
+                    s += g_[j] * V[j * n + l];
+                }
+                u[l] = s;
+            });
+            const double* z = detail::precondition(M, u, w);
+            detail::krylov_update(n, [&](size_t l) { x[l] += z[l]; });
+            if (result.converged) {
+                break;
+            }
+        }
+        return result;
+    }
+
+private:
+    std::vector<double> h_; // (m + 1) x m 的 Hessenberg 矩阵, 按列存放
+    std::vector<double> cs_;
+    std::vector<double> sn_;
+    std::vector<double> g_;
+};
+
+}
@@ -3,57 +3,103 @@
 #include <vector>
 #include <iostream>
 #include <string>
-#include <memory>
-#include <variant>
+#include <algorithm>
 
 #include <fmt/format.h>
 
-namespace zmath {
-
-enum class VecType {
-    Row = 0,
-    Col = 1
-};
+#include <zmath/utils.h>
+#include <zmath/utils/thread_pool.h>
+#include "view.h"
+#include "expr.h"
 
+namespace zmath {
 
-class Vector;
 class Matrix;
-
-// 乘法的返回类型
-using MulResult = std::variant<double, std::shared_ptr<Matrix>>; 
-
-class Vector {
+class LUFactorization;
+class CholeskyFactorization;
+class LDLTFactorization;
+struct EighResult;
+struct SVDResult;
+
+/**
+ * @brief 稠密向量, 方向是类型的一部分: Vector 是列向量, RowVector 是行向量
+ *
+ * 行向量乘列向量得到 double (内积), 列向量乘行向量得到矩阵表达式 (外积), 方向在编译期确定
+ */
+template <bool Row>
+class BasicVector : public VectorExpr<BasicVector<Row>> {
 public:
-    friend class Matrix;
-    friend MulResult;
+    static constexpr bool is_row = Row;
 
-    Vector(size_t n = 1, VecType type = VecType::Col)
-        : data_(n, 0), type_(type) { }
+    explicit BasicVector(size_t n = 1)
+        : data_(n, 0) { }
 
-    Vector(const std::vector<double>& data, VecType type = VecType::Col) 
-        : data_(data), type_(type) { }
+    BasicVector(const std::vector<double>& data)
+        : data_(data.begin(), data.end()) { }
 
-    VecType type() const {
-        return type_;
+    // 从视图拷贝, 例如矩阵的某一行或某一列
+    explicit BasicVector(ConstVectorView v)
+        : data_(v.size()) {
+        for (size_t i = 0; i < v.size(); i++) {
+            data_[i] = v(i);
+        }
     }
 
-    void set_type(VecType type) {
-        type_ = type;
+    // 对表达式求值, 例如 Vector v = a - 2.5 * b; 只分配一次, 只遍历一遍. 表达式的方向必须与自己相同
+    template <typename E, std::enable_if_t<E::is_row == Row, int> = 0>
+    BasicVector(const VectorExpr<E>& e)
+        : data_(e.derived().size()) {
+        detail::expr_assign(data_.data(), e.derived(), data_.size(), [](double, double x) { return x; });
+    }
+
+    BasicVector(const BasicVector&) = default;
+    BasicVector(BasicVector&&) = default;
+    BasicVector& operator=(const BasicVector&) = default;
+    BasicVector& operator=(BasicVector&&) = default;
+
+    /**
+     * @brief 对表达式求值并赋给自己, 大小相同时不分配内存. 逐元素运算, 表达式中可以出现自己
+     */
+    template <typename E, std::enable_if_t<E::is_row == Row, int> = 0>
+    BasicVector& operator=(const VectorExpr<E>& e) {
+        const E& x = e.derived();
+        if (x.size() != data_.size()) {
+            *this = BasicVector(x);
+            return *this;
+        }
+        detail::expr_assign(data_.data(), x, data_.size(), [](double, double v) { return v; });
+        return *this;
     }
 
     size_t size() const {
         return data_.size();
     }
 
-    // 转置
-    Vector transpose() const {
-        Vector ret = *this;
-        if (ret.type_ == VecType::Col) {
-            ret.type_ = VecType::Row;
-        } else {
-            ret.type_ = VecType::Col;
-        }
-        return ret;
+    double* data() {
+        return data_.data();
+    }
+
+    const double* data() const {
+        return data_.data();
+    }
+
+    VectorView view() {
+        return VectorView(data_.data(), data_.size());
+    }
+
+    ConstVectorView view() const {
+        return ConstVectorView(data_.data(), data_.size());
+    }
+
+    // 转置, 得到另一方向的向量, O(1): 左值返回引用自己的表达式, 右值直接移交存储
+    VectorTransposeExpr<const BasicVector&> transpose() const & {
+        return VectorTransposeExpr<const BasicVector&>(*this);
+    }
+
+    BasicVector<!Row> transpose() && {
+        BasicVector<!Row> v(0);
+        v.data_ = std::move(data_);
+        return v;
     }
 
     double& operator()(size_t i) {
@@ -64,52 +110,43 @@ public:
         return data_[i];
     }
 
-    Vector& operator+=(const Vector& rhs) {
-        for (size_t i = 0; i < data_.size(); ++i) {
-            data_[i] += rhs.data_[i];
-        }
-        return *this;
+    // 表达式模板使用的逐元素访问
+    double coeff(size_t i) const {
+        return data_[i];
     }
 
-    Vector& operator-=(const Vector& rhs) {
-        for (size_t i = 0; i < data_.size(); ++i) {
-            data_[i] -= rhs.data_[i];
-        }
+    // y += a * x 这类更新在一个循环里完成, 不产生临时向量
+    template <typename E, std::enable_if_t<E::is_row == Row, int> = 0>
+    BasicVector& operator+=(const VectorExpr<E>& rhs) {
+        detail::expr_assign(data_.data(), rhs.derived(), data_.size(), [](double a, double b) { return a + b; });
         return *this;
     }
 
-    Vector& operator*=(double c) {
-        for (size_t i = 0; i < data_.size(); ++i) {
-            data_[i] *= c;
-        }
+    template <typename E, std::enable_if_t<E::is_row == Row, int> = 0>
+    BasicVector& operator-=(const VectorExpr<E>& rhs) {
+        detail::expr_assign(data_.data(), rhs.derived(), data_.size(), [](double a, double b) { return a - b; });
         return *this;
     }
 
-    friend Vector operator*(Vector lhs, double c) {
-        lhs *= c;
-        return lhs;
-    }
-
-    friend Vector operator*(double c, Vector rhs) {
-        rhs *= c;
-        return rhs;
-    }
-
-    friend Vector operator+(Vector lhs, const Vector& rhs) {
-        lhs += rhs;
-        return lhs;
+    /**
+     * @brief 改变大小, 新增的元素为 0. 容量足够时不分配内存
+     */
+    void resize(size_t n) {
+        data_.resize(n, 0.0);
     }
 
-    friend Vector operator-(Vector lhs, const Vector& rhs) {
-        lhs -= rhs;
-        return lhs;
+    BasicVector& operator*=(double c) {
+        for (size_t i = 0; i < data_.size(); ++i) {
+            data_[i] *= c;
+        }
+        return *this;
     }
 
     std::string to_string() const {
-        return fmt::format("{} ( {:.3f} )", type_ == VecType::Col ? "Col" : "Row", fmt::join(data_, ", "));
+        return fmt::format("{} ( {:.3f} )", Row ? "Row" : "Col", fmt::join(data_, ", "));
     }
 
-    friend std::ostream& operator<<(std::ostream& os, const Vector& v) {
+    friend std::ostream& operator<<(std::ostream& os, const BasicVector& v) {
         os << v.to_string();
         return os;
     }
@@ -119,20 +156,37 @@ public:
     }
 
 private: 
-    std::vector<double> data_;
-    VecType type_;
+    template <bool>
+    friend class BasicVector;
+
+    aligned_vector<double> data_;
 };
 
 
-class Matrix {
+class Matrix : public MatrixExpr<Matrix> {
 public:
-    friend MulResult;
-    friend MulResult operator*(const Vector& lhs, const Vector& rhs);
 
     using PLU_Type = std::pair<std::vector<size_t>, Matrix>;
 
     Matrix(size_t row = 1, size_t col = 1);
     Matrix(const std::vector<std::vector<double>>& data);
+    // 从视图拷贝
+    Matrix(ConstMatrixView v);
+
+    // 对逐元素表达式求值, 例如 Matrix C = A + 2.0 * B; 只分配一次, 只遍历一遍
+    template <typename E>
+    Matrix(const MatrixExpr<E>& e);
+
+    Matrix(const Matrix&) = default;
+    Matrix(Matrix&&) = default;
+    Matrix& operator=(const Matrix&) = default;
+    Matrix& operator=(Matrix&&) = default;
+
+    /**
+     * @brief 对表达式求值并赋给自己, 形状相同时不分配内存
+     */
+    template <typename E>
+    Matrix& operator=(const MatrixExpr<E>& e);
 
     bool is_squared() const {
         return get_row_size() == get_col_size();
@@ -141,9 +195,9 @@ public:
         if (!is_squared()) return false;
 
         auto n = get_row_size();
-        for (int i = 0; i < n; i++) {
-            for (int j = i; j < n; j++) {
-                if (!eq(data_[i][j], data_[j][i]))
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = i; j < n; j++) {
+                if (!eq((*this)(i, j), (*this)(j, i)))
                     return false;
             }
         }
@@ -151,110 +205,214 @@ public:
     }
 
     size_t get_row_size() const {
-        return data_.size();
+        return rows_;
     }
     size_t get_col_size() const {
-        return data_[0].size();
+        return cols_;
     }
 
-    Vector get_n_row_vector(size_t n) const {
-        return Vector(data_[n], VecType::Row);
+    size_t rows() const {
+        return rows_;
     }
-    Vector get_n_col_vector(size_t n) const {
-        auto s = get_row_size();
-        Vector v(s);
-        for (int i = 0; i < s; i++) {
-            v(i) = data_[i][n];
-        }
-        return v;
+    size_t cols() const {
+        return cols_;
     }
 
-    Matrix LU_decomp() const {
-        // TODO if (!is_squared()) error
-        Matrix LU(*this);
+    /**
+     * @brief 改变形状, 原有内容不保留. 容量足够时不分配内存, 用于 _into 函数的输出
+     */
+    void resize(size_t row, size_t col) {
+        rows_ = row;
+        cols_ = col;
+        data_.resize(row * col);
+    }
 
-        auto n = get_row_size();
-        for (int j = 0; j < n - 1; j++) {
-            // L
-            double cj = 1.0 / LU(j, j);
-            for (int i = j + 1; i < n; i++) {
-                LU(i, j) *= cj;
-            }
-            // U
-            for (int i = j + 1; i < n; i++) {
-                for (int k = j + 1; k < n; k++) {
-                    LU(i, k) -= LU(i, j) * LU(j, k);
-                }
-            }
-        }
-        return LU;
+    // leading dimension: 相邻两行首元素在内存中的距离
+    size_t ld() const {
+        return cols_;
     }
 
-    Vector LU_solve(const Vector& b) const {
-        // TODO if (!is_squared()) error
-        Vector x(b.size());
-        Matrix LU = LU_decomp();
-        auto y = LU_solve_L(LU, b);
-        x = LU_solve_U(LU, y);
-        return x;
+    double* data() {
+        return data_.data();
+    }
+    const double* data() const {
+        return data_.data();
     }
 
-    double det() const {
-        // TODO if (!is_squared()) error
-        Matrix LU = LU_decomp();
-        double det = 1.0;
-        for (int i = 0; i < get_row_size(); i++) {
-            det *= LU(i, i);
-        }
-        return det;
+    // 第 i 行的起始地址
+    double* row_ptr(size_t i) {
+        return data_.data() + i * ld();
+    }
+    const double* row_ptr(size_t i) const {
+        return data_.data() + i * ld();
     }
 
-    Matrix inv() const {
-        // TODO if (!is_squared()) error
-        auto n = get_row_size();
-        Matrix mat(n, n);
-        Matrix LU = LU_decomp();
-        Vector ej(n), xj(n);
-        ej(0) = 1.0;
-        for (int j = 0; j < n; j++) {
-            if (j >= 1) std::swap(ej(j-1), ej(j));
-            auto yj = LU_solve_L(LU, ej);
-            xj = LU_solve_U(LU, yj);
-            for (int i = 0; i < n; i++) {
-                mat(i, j) = xj(i);
-            }
-        }
-        return mat;
+    MatrixView view() {
+        return MatrixView(data_.data(), rows_, cols_, ld());
+    }
+    ConstMatrixView view() const {
+        return ConstMatrixView(data_.data(), rows_, cols_, ld());
     }
 
-    Matrix T() const {
-        const int r = get_row_size(), c = get_col_size();
-        Matrix mat(c, r);
-        for (int i = 0; i < r; i++) {
-            for (int j = 0; j < c; j++) {
-                mat(j, i) = data_[i][j];
-            }
+    // 第 i 行 / 第 j 列 / 子矩阵的视图, 与矩阵共享内存
+    VectorView row(size_t i) {
+        return view().row(i);
+    }
+    ConstVectorView row(size_t i) const {
+        return view().row(i);
+    }
+    VectorView col(size_t j) {
+        return view().col(j);
+    }
+    ConstVectorView col(size_t j) const {
+        return view().col(j);
+    }
+    MatrixView block(size_t i, size_t j, size_t r, size_t c) {
+        return view().block(i, j, r, c);
+    }
+    ConstMatrixView block(size_t i, size_t j, size_t r, size_t c) const {
+        return view().block(i, j, r, c);
+    }
+
+    RowVector get_n_row_vector(size_t n) const {
+        return RowVector(row(n));
+    }
+    Vector get_n_col_vector(size_t n) const {
+        return Vector(col(n));
+    }
+
+    /**
+     * @brief 不选主元的 LU 分解, L 和 U 存在同一个矩阵里. 主元可能为 0 时应使用 lu()
+     */
+    Matrix LU_decomp() const {
+        Matrix LU(0, 0);
+        LU_decomp_into(LU);
+        return LU;
+    }
+
+    /**
+     * @brief LU_decomp 的结果写入 LU, LU 的容量足够时不分配内存
+     */
+    void LU_decomp_into(Matrix& LU) const {
+        // TODO if (!is_squared()) error
+        LU = *this;
+
+        const size_t n = get_row_size();
+        const size_t ld = LU.ld();
+        double* a = LU.data();
+        for (size_t j = 0; j + 1 < n; j++) {
+            const double* rj = a + j * ld;
+            double cj = 1.0 / rj[j];
+            // 右下角子矩阵的每一行互不依赖, 按行分给线程池
+            const size_t grain = std::max<size_t>(1, 16384 / (n - j));
+            parallel_for(j + 1, n, grain, [=](size_t lo, size_t hi) {
+                for (size_t i = lo; i < hi; i++) {
+                    double* ri = a + i * ld;
+                    // L
+                    const double lij = ri[j] *= cj;
+                    // U, 按行连续访问
+                    for (size_t k = j + 1; k < n; k++) {
+                        ri[k] -= lij * rj[k];
+                    }
+                }
+            });
         }
-        return mat;
     }
 
-    const double& operator()(size_t i, size_t j) const;
-    double& operator()(size_t i, size_t j);
-    Matrix& operator+=(const Matrix& rhs);
-    Matrix& operator-=(const Matrix& rhs); 
+    /**
+     * @brief 选列主元的 LU 分解, 需要多次求解时应保存返回的对象重复使用
+     */
+    LUFactorization lu() const;
+
+    /**
+     * @brief PA = LU, 返回置换 P 和合并存储的 LU
+     */
+    PLU_Type PLU_decomp() const;
+
+    Vector LU_solve(const Vector& b) const;
+    Matrix LU_solve(const Matrix& B) const;
+    double det() const;
+    Matrix inv() const;
+
+    // 以下版本的临时存储 (LU 因子和主元) 从 ws 中切出, 结果写入调用者提供的 x / X / out.
+    // ws 和输出的容量足够后 (通常是第一次调用之后) 不再分配内存
+    void LU_solve_into(const Vector& b, Vector& x, Workspace& ws) const;
+    void LU_solve_into(const Matrix& B, Matrix& X, Workspace& ws) const;
+    double det(Workspace& ws) const;
+    void inv_into(Matrix& out, Workspace& ws) const;
+
+    /**
+     * @brief 对称正定矩阵的 Cholesky 分解 A = R^T R, 只读取上三角
+     */
+    CholeskyFactorization cholesky() const;
+
+    /**
+     * @brief 对称矩阵的 A = U^T D U 分解 (不选主元), 只读取上三角
+     */
+    LDLTFactorization ldlt() const;
+
+    /**
+     * @brief 求解 Ax = b. 矩阵对称且对角线全为正时先尝试 Cholesky (计算量是 LU 的一半), 不正定时退回选主元 LU
+     */
+    Vector solve(const Vector& b) const;
+    Matrix solve(const Matrix& B) const;
+
+    /**
+     * @brief 对称矩阵的特征分解, 特征值升序. 只读取上三角. 迭代未收敛时 converged 为 false
+     */
+    EighResult eigh() const;
+
+    /**
+     * @brief 对称矩阵的全部特征值 (升序), 不计算特征向量, 只读取上三角. 迭代未收敛时抛出 std::runtime_error
+     */
+    Vector eigvalsh() const;
+
+    /**
+     * @brief 瘦奇异值分解 A = U diag(S) V^T, 奇异值降序. 迭代未收敛时 converged 为 false
+     */
+    SVDResult svd() const;
+
+    /**
+     * @brief 全部奇异值 (降序), 不计算奇异向量. 迭代未收敛时抛出 std::runtime_error
+     */
+    Vector singular_values() const;
+
+    /**
+     * @brief 转置, 不拷贝. A.T() * B 直接以转置的步长做 GEMM; 赋给 Matrix 时才分块转置.
+     * 右值的转置保存矩阵本身, 左值的转置引用原矩阵, 保存下来时原矩阵必须还在
+     */
+    TransposeExpr<const Matrix&> T() const &;
+    TransposeExpr<Matrix> T() &&;
+
+    /**
+     * @brief 原地转置. 方阵按块两两交换, 不分配内存; 非方阵需要一块同样大小的临时存储
+     */
+    Matrix& transpose_in_place();
+
+    const double& operator()(size_t i, size_t j) const {
+        return data_[i * ld() + j];
+    }
+    double& operator()(size_t i, size_t j) {
+        return data_[i * ld() + j];
+    }
+
+    // 表达式模板使用的逐元素访问
+    double coeff(size_t i, size_t j) const {
+        return data_[i * ld() + j];
+    }
+
+    template <typename E>
+    Matrix& operator+=(const MatrixExpr<E>& rhs);
+    template <typename E>
+    Matrix& operator-=(const MatrixExpr<E>& rhs);
     Matrix& operator*=(double c);
 
-    friend Matrix operator*(Matrix lhs, double c);
-    friend Matrix operator*(double c, Matrix rhs);
-    friend Matrix operator+(Matrix lhs, const Matrix& rhs);
-    friend Matrix operator-(Matrix lhs, const Matrix& rhs);
-    friend Matrix operator*(Matrix lhs, const Matrix& rhs);
-
     std::string to_string() const {
         std::string str = "Mat [ ";
         const size_t m = get_row_size();
-        for (int i = 0; i < m; i++) {
-            str += fmt::format("{:.3f}", fmt::join(data_[i], ", "));
+        for (size_t i = 0; i < m; i++) {
+            auto first = data_.begin() + i * ld();
+            str += fmt::format("{:.3f}", fmt::join(first, first + cols_, ", "));
             if (i != m - 1) {
                 str += ";\n ";
             }
@@ -273,56 +431,188 @@ public:
     }
 
 private: 
-    std::vector<std::vector<double>> data_;
-
-    Vector LU_solve_L(const Matrix& LU, const Vector& b) const {
-        auto n = b.size();
-        Vector x(n);
-        for (int i = 0; i < n; i++) {
-            x(i) = b(i);
-            for (int j = 0; j < i; j++) {
-                x(i) -= LU(i, j) * x(j);
+    // 行主序连续存储, (i, j) 位于 data_[i * ld() + j]
+    size_t rows_;
+    size_t cols_;
+    aligned_vector<double> data_;
+};
+
+inline Matrix::Matrix(size_t row, size_t col)
+    : rows_(row), cols_(col), data_(row * col, 0) { }
+
+inline Matrix::Matrix(const std::vector<std::vector<double>>& data)
+    : rows_(data.size()), cols_(data.empty() ? 0 : data[0].size()), data_(rows_ * cols_, 0) {
+    for (size_t i = 0; i < rows_; i++) {
+        std::copy(data[i].begin(), data[i].end(), data_.begin() + i * ld());
+    }
+}
+
+inline Matrix::Matrix(ConstMatrixView v)
+    : rows_(v.rows()), cols_(v.cols()), data_(rows_ * cols_) {
+    for (size_t i = 0; i < rows_; i++) {
+        std::copy(v.row_ptr(i), v.row_ptr(i) + cols_, data_.begin() + i * ld());
+    }
+}
+
+namespace detail {
+
+template <typename E>
+struct is_transpose_expr : std::false_type { };
+
+template <typename M>
+struct is_transpose_expr<TransposeExpr<M>> : std::true_type { };
+
+// 分块转置的块大小: 32 x 32 个 double 的源块和目标块一共 16KB, 可以同时留在 L1 里
+constexpr size_t transpose_tile = 32;
+
+// dst(j, i) = src(i, j). 逐元素转置时对目标按列写入, 每次写都落在不同的缓存行和页上;
+// 按块处理后块内的读写只涉及 32 行. 按目标的行块分给线程池
+inline void transpose_into(ConstMatrixView src, double* dst, size_t ldd) {
+    const size_t r = src.rows(), c = src.cols();
+    const size_t tiles = (c + transpose_tile - 1) / transpose_tile;
+    const size_t grain = std::max<size_t>(1, expr_parallel_grain / std::max<size_t>(r * transpose_tile, 1));
+    parallel_for(0, tiles, grain, [&](size_t lo, size_t hi) {
+        for (size_t j0 = lo * transpose_tile; j0 < std::min(c, hi * transpose_tile); j0 += transpose_tile) {
+            const size_t j1 = std::min(c, j0 + transpose_tile);
+            for (size_t i0 = 0; i0 < r; i0 += transpose_tile) {
+                const size_t i1 = std::min(r, i0 + transpose_tile);
+                for (size_t j = j0; j < j1; j++) {
+                    double* dj = dst + j * ldd;
+                    for (size_t i = i0; i < i1; i++) {
+                        dj[i] = src(i, j);
+                    }
+                }
             }
         }
-        return x;
-    }
+    });
+}
 
-    Vector LU_solve_U(const Matrix& LU, const Vector& b) const {
-        auto n = b.size();
-        Vector x(n);
-        for (int i = n - 1; i >= 0; i--) {
-            x(i) = b(i);
-            for (int j = i + 1; j < n; j++) {
-                x(i) -= LU(i, j) * x(j);
+// 方阵原地转置: 块 (I, J) 与块 (J, I) 的转置交换, 对角块在块内交换. 按块行分给线程池, 各块行交换的元素互不重叠
+inline void transpose_square_in_place(MatrixView A) {
+    const size_t n = A.rows();
+    const size_t tiles = (n + transpose_tile - 1) / transpose_tile;
+    parallel_for(0, tiles, 1, [&](size_t lo, size_t hi) {
+        for (size_t bi = lo; bi < hi; bi++) {
+            const size_t i0 = bi * transpose_tile, i1 = std::min(n, i0 + transpose_tile);
+            for (size_t j0 = i0; j0 < n; j0 += transpose_tile) {
+                const size_t j1 = std::min(n, j0 + transpose_tile);
+                for (size_t i = i0; i < i1; i++) {
+                    for (size_t j = (j0 == i0 ? i + 1 : j0); j < j1; j++) {
+                        std::swap(A(i, j), A(j, i));
+                    }
+                }
             }
-            x(i) /= LU(i, i);
         }
-        return x;
+    });
+}
+
+}
+
+template <typename E>
+Matrix::Matrix(const MatrixExpr<E>& e)
+    : rows_(e.derived().rows()), cols_(e.derived().cols()), data_(rows_ * cols_) {
+    if constexpr (detail::is_transpose_expr<E>::value) {
+        detail::transpose_into(e.derived().nested().view(), data_.data(), ld());
+    } else {
+        detail::expr_assign(data_.data(), ld(), e.derived(), rows_, cols_, [](double, double x) { return x; });
     }
-};
+}
 
-MulResult operator*(const Vector& lhs, const Vector& rhs) {
-    MulResult result;
-    if (lhs.type() == VecType::Row && rhs.type() == VecType::Col) {
-        double r = 0.0;
-        for (int i = 0; i < lhs.size(); i++) {
-            r += lhs(i) * rhs(i);
-        }
-        result = r;
-        return result;
-    } else if (lhs.type() == VecType::Col && rhs.type() == VecType::Row) {
-        auto mat = std::make_shared<Matrix>(lhs.size(), rhs.size());
-        for (int i = 0; i < lhs.size(); i++) {
-            for (int j = 0; j < rhs.size(); j++) {
-                mat->data_[i][j] = lhs(i) * rhs(j);
-            }
+template <typename E>
+Matrix& Matrix::operator=(const MatrixExpr<E>& e) {
+    const E& x = e.derived();
+    if constexpr (detail::is_transpose_expr<E>::value) {
+        if (x.rows() == rows_ && x.cols() == cols_ && &x.nested() != this) {
+            detail::transpose_into(x.nested().view(), data_.data(), ld());
+            return *this;
         }
-        result = mat;
-        return result;
+    }
+    // 有转置时自己可能出现在表达式中 (例如 A = A + A.T()), 先求值到新的存储
+    if (x.rows() != rows_ || x.cols() != cols_ || detail::expr_has_transpose<E>::value) {
+        *this = Matrix(x);
+        return *this;
+    }
+    detail::expr_assign(data_.data(), ld(), x, rows_, cols_, [](double, double v) { return v; });
+    return *this;
+}
+
+template <typename E>
+Matrix& Matrix::operator+=(const MatrixExpr<E>& rhs) {
+    if constexpr (detail::expr_has_transpose<E>::value) {
+        return *this += Matrix(rhs.derived());
+    } else {
+        detail::expr_assign(data_.data(), ld(), rhs.derived(), rows_, cols_, [](double a, double b) { return a + b; });
+        return *this;
+    }
+}
+
+template <typename E>
+Matrix& Matrix::operator-=(const MatrixExpr<E>& rhs) {
+    if constexpr (detail::expr_has_transpose<E>::value) {
+        return *this -= Matrix(rhs.derived());
+    } else {
+        detail::expr_assign(data_.data(), ld(), rhs.derived(), rows_, cols_, [](double a, double b) { return a - b; });
+        return *this;
+    }
+}
+
+inline TransposeExpr<const Matrix&> Matrix::T() const & {
+    return TransposeExpr<const Matrix&>(*this);
+}
+
+inline TransposeExpr<Matrix> Matrix::T() && {
+    return TransposeExpr<Matrix>(std::move(*this));
+}
+
+inline Matrix& Matrix::transpose_in_place() {
+    if (is_squared()) {
+        detail::transpose_square_in_place(view());
     } else {
-        result = zmath::inf; // error
-        return result;
+        *this = Matrix(T());
     }
+    return *this;
+}
+
+inline Matrix& Matrix::operator*=(double c) {
+    for (auto& d : data_) {
+        d *= c;
+    }
+    return *this;
+}
+
+template <typename E>
+auto VectorExpr<E>::eval() const {
+    return BasicVector<E::is_row>(*this);
+}
+
+template <typename E>
+auto VectorExpr<E>::transpose() const {
+    return eval().transpose();
+}
+
+template <typename E>
+std::string VectorExpr<E>::to_string() const {
+    return eval().to_string();
+}
+
+template <typename E>
+void VectorExpr<E>::print() const {
+    eval().print();
+}
+
+template <typename E>
+Matrix MatrixExpr<E>::eval() const {
+    return Matrix(*this);
+}
+
+template <typename E>
+std::string MatrixExpr<E>::to_string() const {
+    return eval().to_string();
+}
+
+template <typename E>
+void MatrixExpr<E>::print() const {
+    eval().print();
 }
 
 }
\ No newline at end of file
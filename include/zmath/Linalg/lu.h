@@ -0,0 +1,326 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <zmath/utils/memory.h>
+#include <zmath/utils/thread_pool.h>
+#include "linalg.h"
+#include "gemm.h"
+#include "triangular.h"
+
+namespace zmath {
+
+namespace detail {
+
+struct LuInfo {
+    double sign;
+    bool singular;
+};
+
+// 对第 k0 ~ k0+kb 列 (第 k0 行以下) 做不分块的选主元 LU, 行交换作用于整行
+inline void lu_factorize_panel(MatrixView A, size_t k0, size_t kb, size_t* ipiv, LuInfo& info) {
+    const size_t n = A.rows();
+    const size_t k1 = k0 + kb;
+    for (size_t j = k0; j < k1; j++) {
+        size_t p = j;
+        double best = std::abs(A(j, j));
+        for (size_t i = j + 1; i < n; i++) {
+            const double v = std::abs(A(i, j));
+            if (v > best) {
+                best = v;
+                p = i;
+            }
+        }
+        ipiv[j] = p;
+        if (p != j) {
+            std::swap_ranges(A.row_ptr(j), A.row_ptr(j) + n, A.row_ptr(p));
+            info.sign = -info.sign;
+        }
+        if (A(j, j) == 0.0) {
+            info.singular = true;
+            continue;
+        }
+
+        const double dj = 1.0 / A(j, j);
+        const double* rj = A.row_ptr(j);
+        const size_t grain = std::max<size_t>(1, 16384 / (k1 - j));
+        parallel_for(j + 1, n, grain, [=](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; i++) {
+                double* ri = A.row_ptr(i);
+                const double lij = ri[j] *= dj;
+                for (size_t c = j + 1; c < k1; c++) {
+                    ri[c] -= lij * rj[c];
+                }
+            }
+        });
+    }
+}
+
+// 原地分解 PA = LU, L 的对角线为 1, 不存储; 第 k 步与第 ipiv[k] 行交换. 不分配内存
+inline LuInfo lu_factorize(MatrixView A, size_t* ipiv, size_t nb) {
+    const size_t n = A.rows();
+    LuInfo info { 1.0, false };
+    for (size_t k0 = 0; k0 < n; k0 += nb) {
+        const size_t kb = std::min(nb, n - k0);
+        lu_factorize_panel(A, k0, kb, ipiv, info);
+
+        const size_t k1 = k0 + kb;
+        if (k1 < n) {
+            // U12 = L11^{-1} A12
+            trsm(Side::Left, Uplo::Lower, Trans::No, Diag::Unit, 1.0,
+                 A.block(k0, k0, kb, kb), A.block(k0, k1, kb, n - k1));
+            // A22 -= L21 * U12
+            gemm(-1.0, A.block(k1, k0, n - k1, kb), A.block(k0, k1, kb, n - k1),
+                 1.0, A.block(k1, k1, n - k1, n - k1));
+        }
+    }
+    return info;
+}
+
+inline void lu_apply_pivots(const size_t* ipiv, size_t n, MatrixView B) {
+    for (size_t k = 0; k < n; k++) {
+        if (ipiv[k] != k) {
+            std::swap_ranges(B.row_ptr(k), B.row_ptr(k) + B.cols(), B.row_ptr(ipiv[k]));
+        }
+    }
+}
+
+// B <- A^{-1} B, LU 和 ipiv 是 lu_factorize 的结果
+inline void lu_solve_in_place(ConstMatrixView LU, const size_t* ipiv, MatrixView B) {
+    lu_apply_pivots(ipiv, LU.rows(), B);
+    trsm(Side::Left, Uplo::Lower, Trans::No, Diag::Unit, 1.0, LU, B);
+    trsm(Side::Left, Uplo::Upper, Trans::No, Diag::NonUnit, 1.0, LU, B);
+}
+
+// out = A^{-1} = U^{-1} L^{-1} P (LAPACK getri): 先按列块求 U^{-1} (第 j 列只有前 j+1 行非零, 只解这一部分),
+// 再右乘解 X L = U^{-1}, 最后按主元逆序交换列. 共 4/3 n^3 次运算, 对单位阵直接求解是 2 n^3
+inline void lu_inverse(ConstMatrixView LU, const size_t* ipiv, Matrix& out) {
+    const size_t n = LU.rows();
+    out.resize(n, n);
+    std::fill(out.data(), out.data() + n * n, 0.0);
+    for (size_t j0 = 0; j0 < n; j0 += trsm_block) {
+        const size_t j1 = std::min(n, j0 + trsm_block);
+        for (size_t j = j0; j < j1; j++) out(j, j) = 1.0;
+        trsm(Side::Left, Uplo::Upper, Trans::No, Diag::NonUnit, 1.0,
+             LU.block(0, 0, j1, j1), out.block(0, j0, j1, j1 - j0));
+    }
+    trsm(Side::Right, Uplo::Lower, Trans::No, Diag::Unit, 1.0, LU, out.view());
+    // 列交换逐行进行, 每行的全部交换都在这一行内完成
+    const size_t grain = std::max<size_t>(1, expr_parallel_grain / std::max<size_t>(n, 1));
+    parallel_for(0, n, grain, [&](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; i++) {
+            double* oi = out.row_ptr(i);
+            for (size_t k = n; k-- > 0; ) {
+                if (ipiv[k] != k) std::swap(oi[k], oi[ipiv[k]]);
+            }
+        }
+    });
+}
+
+// 在工作区里分解 A 的拷贝, 返回的视图和 ipiv 在 ws 归还之前有效
+inline LuInfo lu_factorize_copy(const Matrix& A, Workspace& ws, MatrixView& LU, size_t*& ipiv) {
+    // TODO if (!A.is_squared()) error
+    const size_t n = A.rows();
+    double* a = ws.allocate<double>(n * n);
+    ipiv = ws.allocate<size_t>(n);
+    for (size_t i = 0; i < n; i++) {
+        std::copy(A.row_ptr(i), A.row_ptr(i) + n, a + i * n);
+    }
+    LU = MatrixView(a, n, n, n);
+    return lu_factorize(LU, ipiv, 64);
+}
+
+inline void set_identity(Matrix& I, size_t n) {
+    I.resize(n, n);
+    std::fill(I.data(), I.data() + n * n, 0.0);
+    for (size_t i = 0; i < n; i++) I(i, i) = 1.0;
+}
+
+}
+
+/**
+ * @brief 选列主元的 LU 分解 PA = LU
+ *
+ * 分解一次, 之后可以反复求解 / 求行列式 / 求逆而不需要重新分解.
+ * 采用分块的右视 (right-looking) 算法: 每次分解 nb 列宽的 panel,
+ * 然后用三角求解得到 U 的对应行, 再用 GEMM 更新右下角子矩阵.
+ * factorize 和各个 _into 函数复用已有的存储, 大小不变时不分配内存
+ */
+class LUFactorization {
+public:
+    LUFactorization() = default;
+
+    explicit LUFactorization(const Matrix& A, size_t block = 64) {
+        factorize(A, block);
+    }
+
+    /**
+     * @brief 分解 A, 会复用已有的存储
+     */
+    void factorize(const Matrix& A, size_t block = 64) {
+        // TODO if (!A.is_squared()) error
+        lu_ = A;
+        ipiv_.resize(A.rows());
+        const detail::LuInfo info = detail::lu_factorize(lu_.view(), ipiv_.data(), std::max<size_t>(block, 1));
+        sign_ = info.sign;
+        singular_ = info.singular;
+    }
+
+    size_t size() const {
+        return ipiv_.size();
+    }
+
+    /**
+     * @brief 分解时是否遇到了为 0 的主元
+     */
+    bool is_singular() const {
+        return singular_;
+    }
+
+    /**
+     * @brief L 和 U 存在同一个矩阵里, L 的对角线为 1, 不存储
+     */
+    const Matrix& LU() const {
+        return lu_;
+    }
+
+    /**
+     * @brief 第 k 步与第 k 行交换的行号 (LAPACK 的 ipiv 格式)
+     */
+    const std::vector<size_t>& pivots() const {
+        return ipiv_;
+    }
+
+    /**
+     * @brief 置换 P: PA 的第 i 行是 A 的第 perm[i] 行
+     */
+    std::vector<size_t> permutation() const {
+        std::vector<size_t> perm(size());
+        for (size_t i = 0; i < perm.size(); i++) perm[i] = i;
+        for (size_t k = 0; k < ipiv_.size(); k++) {
+            std::swap(perm[k], perm[ipiv_[k]]);
+        }
+        return perm;
+    }
+
+    Matrix::PLU_Type PLU() const {
+        return { permutation(), lu_ };
+    }
+
+    double det() const {
+        double det = sign_;
+        for (size_t i = 0; i < size(); i++) {
+            det *= lu_(i, i);
+        }
+        return det;
+    }
+
+    Vector solve(const Vector& b) const {
+        Vector x(size());
+        solve_into(b, x);
+        return x;
+    }
+
+    /**
+     * @brief 同时求解多个右端项 AX = B, B 的每一列是一个右端项
+     */
+    Matrix solve(const Matrix& B) const {
+        Matrix X(B.rows(), B.cols());
+        solve_into(B, X);
+        return X;
+    }
+
+    /**
+     * @brief 解写入 x, x 的大小已经正确时不分配内存. x 可以就是 b
+     */
+    void solve_into(const Vector& b, Vector& x) const {
+        x = b;
+        detail::lu_solve_in_place(lu_.view(), ipiv_.data(), MatrixView(x.data(), size(), 1, 1));
+    }
+
+    void solve_into(const Matrix& B, Matrix& X) const {
+        X = B;
+        detail::lu_solve_in_place(lu_.view(), ipiv_.data(), X.view());
+    }
+
+    Matrix inverse() const {
+        Matrix inv(size(), size());
+        inverse_into(inv);
+        return inv;
+    }
+
+    void inverse_into(Matrix& out) const {
+        detail::lu_inverse(lu_.view(), ipiv_.data(), out);
+    }
+
+private:
+    Matrix lu_ {0, 0};
+    std::vector<size_t> ipiv_;
+    double sign_ {1.0};
+    bool singular_ {false};
+};
+
+inline LUFactorization Matrix::lu() const {
+    return LUFactorization(*this);
+}
+
+inline Matrix::PLU_Type Matrix::PLU_decomp() const {
+    return lu().PLU();
+}
+
+inline Vector Matrix::LU_solve(const Vector& b) const {
+    return lu().solve(b);
+}
+
+inline Matrix Matrix::LU_solve(const Matrix& B) const {
+    return lu().solve(B);
+}
+
+inline double Matrix::det() const {
+    return lu().det();
+}
+
+inline Matrix Matrix::inv() const {
+    return lu().inverse();
+}
+
+inline void Matrix::LU_solve_into(const Vector& b, Vector& x, Workspace& ws) const {
+    Workspace::Scope scope(ws);
+    MatrixView LU;
+    size_t* ipiv;
+    detail::lu_factorize_copy(*this, ws, LU, ipiv);
+    x = b;
+    detail::lu_solve_in_place(LU, ipiv, MatrixView(x.data(), x.size(), 1, 1));
+}
+
+inline void Matrix::LU_solve_into(const Matrix& B, Matrix& X, Workspace& ws) const {
+    Workspace::Scope scope(ws);
+    MatrixView LU;
+    size_t* ipiv;
+    detail::lu_factorize_copy(*this, ws, LU, ipiv);
+    X = B;
+    detail::lu_solve_in_place(LU, ipiv, X.view());
+}
+
+inline double Matrix::det(Workspace& ws) const {
+    Workspace::Scope scope(ws);
+    MatrixView LU;
+    size_t* ipiv;
+    double det = detail::lu_factorize_copy(*this, ws, LU, ipiv).sign;
+    for (size_t i = 0; i < LU.rows(); i++) {
+        det *= LU(i, i);
+    }
+    return det;
+}
+
+inline void Matrix::inv_into(Matrix& out, Workspace& ws) const {
+    Workspace::Scope scope(ws);
+    MatrixView LU;
+    size_t* ipiv;
+    detail::lu_factorize_copy(*this, ws, LU, ipiv);
+    detail::lu_inverse(LU, ipiv, out);
+}
+
+}
@@ -0,0 +1,504 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <zmath/utils/memory.h>
+#include <zmath/utils/thread_pool.h>
+#include "linalg.h"
+
+// 稀疏矩阵: CSR (按行压缩), CSC (按列压缩) 和 COO (三元组, 用于组装).
+// SpMV 受内存带宽限制, 列下标用 32 位整数存放, 比 size_t 少读三分之一的数据; 行数和列数都不能超过 2^32
+
+namespace zmath {
+
+using sparse_index = uint32_t;
+
+/**
+ * @brief 稀疏矩阵的一个非零元 (row, col, value)
+ */
+struct Triplet {
+    size_t row;
+    size_t col;
+    double value;
+};
+
+namespace detail {
+
+// SpMV 每块至少包含这么多个非零元
+constexpr size_t spmv_grain = size_t(1) << 14;
+
+// 下标用 32 位存放, 维数超过 UINT32_MAX 时抛出 std::length_error
+inline void check_sparse_dim(size_t n) {
+    if (n > UINT32_MAX) throw std::length_error("zmath: sparse matrix dimension exceeds 32-bit index range");
+}
+
+inline void check_sparse_index(size_t i, size_t j, size_t rows, size_t cols) {
+    if (i >= rows || j >= cols) throw std::out_of_range("zmath: sparse matrix index out of range");
+}
+
+}
+
+/**
+ * @brief CSR 格式的稀疏矩阵. 第 i 行的非零元是 [row_ptr[i], row_ptr[i + 1]), 每行内列下标递增且不重复
+ */
+class CsrMatrix {
+public:
+    /**
+     * @brief rows x cols 的零矩阵
+     */
+    explicit CsrMatrix(size_t rows = 0, size_t cols = 0)
+        : rows_(rows), cols_(cols), row_ptr_(rows + 1, 0) {
+        detail::check_sparse_dim(cols);
+    }
+
+    /**
+     * @brief 直接使用已经排好的三个数组, 不检查
+     */
+    CsrMatrix(size_t rows, size_t cols, std::vector<size_t> row_ptr, std::vector<sparse_index> col_idx,
+              aligned_vector<double> values)
+        : rows_(rows), cols_(cols), row_ptr_(std::move(row_ptr)), col_idx_(std::move(col_idx)),
+          values_(std::move(values)) { }
+
+    /**
+     * @brief 从稠密矩阵构造, 只保留绝对值大于 drop_tol 的元素. 列数超过 UINT32_MAX 时抛出 std::length_error
+     */
+    explicit CsrMatrix(const Matrix& dense, double drop_tol = 0.0)
+        : rows_(dense.rows()), cols_(dense.cols()), row_ptr_(rows_ + 1, 0) {
+        detail::check_sparse_dim(cols_);
+        for (size_t i = 0; i < rows_; i++) {
+            for (size_t j = 0; j < cols_; j++) {
+                const double v = dense(i, j);
+                if (std::abs(v) > drop_tol) {
+                    col_idx_.push_back(static_cast<sparse_index>(j));
+                    values_.push_back(v);
+                }
+            }
+            row_ptr_[i + 1] = values_.size();
+        }
+    }
+
+    /**
+     * @brief 从三元组组装, 位置相同的三元组相加
+     *
+     * 先按行做计数排序, 再在每行内按列排序并合并重复项, 行之间并行.
+     * 下标越界时抛出 std::out_of_range, 列数超过 UINT32_MAX 时抛出 std::length_error
+     */
+    static CsrMatrix from_triplets(size_t rows, size_t cols, const std::vector<Triplet>& triplets) {
+        detail::check_sparse_dim(cols);
+        std::vector<size_t> start(rows + 1, 0);
+        for (const auto& t : triplets) {
+            detail::check_sparse_index(t.row, t.col, rows, cols);
+            start[t.row + 1]++;
+        }
+        for (size_t i = 0; i < rows; i++) {
+            start[i + 1] += start[i];
+        }
+        std::vector<std::pair<sparse_index, double>> entries(triplets.size());
+        {
+            std::vector<size_t> pos(start.begin(), start.end() - 1);
+            for (const auto& t : triplets) {
+                entries[pos[t.row]++] = { static_cast<sparse_index>(t.col), t.value };
+            }
+        }
+
+        // 每行排序并合并, count[i] 是合并后第 i 行的非零元个数
+        std::vector<size_t> count(rows, 0);
+        parallel_for(0, rows, std::max<size_t>(1, detail::spmv_grain / 16), [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; i++) {
+                auto first = entries.begin() + start[i], last = entries.begin() + start[i + 1];
+                std::sort(first, last, [](const auto& a, const auto& b) { return a.first < b.first; });
+                size_t k = 0;
+                for (auto it = first; it != last; ++it) {
+                    if (k > 0 && first[k - 1].first == it->first) {
+                        first[k - 1].second += it->second;
+                    } else {
+                        first[k++] = *it;
+                    }
+                }
+                count[i] = k;
+            }
+        });
+
+        std::vector<size_t> row_ptr(rows + 1, 0);
+        for (size_t i = 0; i < rows; i++) {
+            row_ptr[i + 1] = row_ptr[i] + count[i];
+        }
+        std::vector<sparse_index> col_idx(row_ptr[rows]);
+        aligned_vector<double> values(row_ptr[rows]);
+        parallel_for(0, rows, std::max<size_t>(1, detail::spmv_grain / 16), [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; i++) {
+                for (size_t k = 0; k < count[i]; k++) {
+                    col_idx[row_ptr[i] + k] = entries[start[i] + k].first;
+                    values[row_ptr[i] + k] = entries[start[i] + k].second;
+                }
+            }
+        });
+        return CsrMatrix(rows, cols, std::move(row_ptr), std::move(col_idx), std::move(values));
+    }
+
+    size_t rows() const {
+        return rows_;
+    }
+
+    size_t cols() const {
+        return cols_;
+    }
+
+    size_t nnz() const {
+        return values_.size();
+    }
+
+    const std::vector<size_t>& row_ptr() const {
+        return row_ptr_;
+    }
+
+    const std::vector<sparse_index>& col_idx() const {
+        return col_idx_;
+    }
+
+    const aligned_vector<double>& values() const {
+        return values_;
+    }
+
+    aligned_vector<double>& values() {
+        return values_;
+    }
+
+    /**
+     * @brief (i, j) 处的值, 在第 i 行内二分查找, 不存在时为 0
+     */
+    double operator()(size_t i, size_t j) const {
+        const auto first = col_idx_.begin() + row_ptr_[i], last = col_idx_.begin() + row_ptr_[i + 1];
+        const auto it = std::lower_bound(first, last, static_cast<sparse_index>(j));
+        return it != last && *it == j ? values_[it - col_idx_.begin()] : 0.0;
+    }
+
+    Matrix to_dense() const {
+        Matrix m(rows_, cols_);
+        for (size_t i = 0; i < rows_; i++) {
+            for (size_t k = row_ptr_[i]; k < row_ptr_[i + 1]; k++) {
+                m(i, col_idx_[k]) = values_[k];
+            }
+        }
+        return m;
+    }
+
+    /**
+     * @brief 转置, 按列计数排序, O(nnz + rows + cols). 结果每行内列下标仍然递增.
+     * 行数成为结果的列数, 超过 UINT32_MAX 时抛出 std::length_error
+     */
+    CsrMatrix transpose() const {
+        detail::check_sparse_dim(rows_);
+        std::vector<size_t> row_ptr(cols_ + 1, 0);
+        for (sparse_index j : col_idx_) {
+            row_ptr[j + 1]++;
+        }
+        for (size_t j = 0; j < cols_; j++) {
+            row_ptr[j + 1] += row_ptr[j];
+        }
+        std::vector<sparse_index> col_idx(nnz());
+        aligned_vector<double> values(nnz());
+        std::vector<size_t> pos(row_ptr.begin(), row_ptr.end() - 1);
+        for (size_t i = 0; i < rows_; i++) {
+            for (size_t k = row_ptr_[i]; k < row_ptr_[i + 1]; k++) {
+                const size_t p = pos[col_idx_[k]]++;
+                col_idx[p] = static_cast<sparse_index>(i);
+                values[p] = values_[k];
+            }
+        }
+        return CsrMatrix(cols_, rows_, std::move(row_ptr), std::move(col_idx), std::move(values));
+    }
+
+    /**
+     * @brief y = alpha * A x + beta * y, beta == 0 时忽略 y 原有的内容
+     *
+     * 按非零元个数把行分块 (而不是按行数), 每行非零元个数相差很大时各线程的工作量也均衡
+     */
+    void multiply(const double* x, double* y, double alpha = 1.0, double beta = 0.0) const {
+        const size_t parts = std::max<size_t>(1, std::min(nnz() / detail::spmv_grain, 8 * num_threads()));
+        parallel_for(0, parts, 1, [&](size_t p0, size_t p1) {
+            const size_t r0 = part_begin(p0, parts), r1 = part_begin(p1, parts);
+            for (size_t i = r0; i < r1; i++) {
+                double s = 0.0;
+                for (size_t k = row_ptr_[i]; k < row_ptr_[i + 1]; k++) {
+                    s += values_[k] * x[col_idx_[k]];
+                }
+                y[i] = beta == 0.0 ? alpha * s : alpha * s + beta * y[i];
+            }
+        });
+    }
+
+    /**
+     * @brief y = alpha * A^T x + beta * y
+     *
+     * 按行分块, 第一块直接散射到 y, 其余各块累加到从 ws 切出的缓冲区, 再按块的顺序加到 y 上.
+     * 块数不超过线程数, 所以 ws 的用量是 (num_threads() - 1) * cols(), 反复调用时不分配内存;
+     * 求和顺序与线程数有关, 结果可能有舍入误差级别的差异
+     */
+    void multiply_transpose(const double* x, double* y, double alpha, double beta, Workspace& ws) const {
+        const size_t parts = std::max<size_t>(1, std::min(nnz() / detail::spmv_grain, num_threads()));
+        Workspace::Scope scope(ws);
+        double* partial = parts > 1 ? ws.allocate<double>((parts - 1) * cols_) : nullptr;
+        parallel_for(0, parts, 1, [&](size_t p0, size_t p1) {
+            for (size_t p = p0; p < p1; p++) {
+                double* dst = p == 0 ? y : partial + (p - 1) * cols_;
+                if (p == 0 && beta != 0.0) {
+                    for (size_t j = 0; j < cols_; j++) dst[j] *= beta;
+                } else {
+                    std::fill(dst, dst + cols_, 0.0);
+                }
+                scatter_rows(part_begin(p, parts), part_begin(p + 1, parts), x, alpha, dst);
+            }
+        });
+        if (parts == 1) return;
+        parallel_for(0, cols_, detail::spmv_grain, [&](size_t lo, size_t hi) {
+            for (size_t p = 1; p < parts; p++) {
+                const double* src = partial + (p - 1) * cols_;
+                for (size_t j = lo; j < hi; j++) {
+                    y[j] += src[j];
+                }
+            }
+        });
+    }
+
+    // 缓冲区来自调用线程自己的工作区
+    void multiply_transpose(const double* x, double* y, double alpha = 1.0, double beta = 0.0) const {
+        multiply_transpose(x, y, alpha, beta, detail::thread_workspace());
+    }
+
+    friend Vector operator*(const CsrMatrix& A, const Vector& x) {
+        assert(x.size() == A.cols());
+        Vector y(A.rows());
+        A.multiply(x.data(), y.data());
+        return y;
+    }
+
+    Vector multiply_transpose(const Vector& x) const {
+        assert(x.size() == rows());
+        Vector y(cols_);
+        multiply_transpose(x.data(), y.data());
+        return y;
+    }
+
+    std::string to_string() const {
+        std::string str = fmt::format("Csr {} x {}, nnz {} [ ", rows_, cols_, nnz());
+        for (size_t i = 0; i < rows_; i++) {
+            for (size_t k = row_ptr_[i]; k < row_ptr_[i + 1]; k++) {
+                str += fmt::format("({}, {}) {:.3f}", i, col_idx_[k], values_[k]);
+                if (k + 1 != nnz()) {
+                    str += ", ";
+                }
+            }
+        }
+        str += " ]";
+        return str;
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const CsrMatrix& m) {
+        os << m.to_string();
+        return os;
+    }
+
+    void print() const {
+        std::cout << *this << std::endl;
+    }
+
+private:
+    size_t rows_;
+    size_t cols_;
+    std::vector<size_t> row_ptr_;
+    std::vector<sparse_index> col_idx_;
+    aligned_vector<double> values_;
+
+    // 第 p 块的第一行: 第一个起点不小于 p * nnz / parts 的行
+    size_t part_begin(size_t p, size_t parts) const {
+        if (p >= parts) return rows_;
+        const size_t target = nnz() / parts * p + nnz() % parts * p / parts;
+        return std::lower_bound(row_ptr_.begin(), row_ptr_.end(), target) - row_ptr_.begin();
+    }
+
+    void scatter_rows(size_t r0, size_t r1, const double* x, double alpha, double* y) const {
+        for (size_t i = r0; i < r1; i++) {
+            const double xi = alpha * x[i];
+            for (size_t k = row_ptr_[i]; k < row_ptr_[i + 1]; k++) {
+                y[col_idx_[k]] += values_[k] * xi;
+            }
+        }
+    }
+};
+
+/**
+ * @brief CSC 格式的稀疏矩阵, 存储上就是转置矩阵的 CSR: 第 j 列的非零元是 [col_ptr[j], col_ptr[j + 1])
+ *
+ * A x 是对列的散射, A^T x 是对列的收集, 与 CSR 正好相反
+ */
+class CscMatrix {
+public:
+    explicit CscMatrix(size_t rows = 0, size_t cols = 0) : t_(cols, rows) { }
+
+    explicit CscMatrix(const Matrix& dense, double drop_tol = 0.0) : t_(CsrMatrix(dense, drop_tol).transpose()) { }
+
+    explicit CscMatrix(const CsrMatrix& csr) : t_(csr.transpose()) { }
+
+    static CscMatrix from_triplets(size_t rows, size_t cols, const std::vector<Triplet>& triplets) {
+        std::vector<Triplet> swapped(triplets.size());
+        for (size_t k = 0; k < triplets.size(); k++) {
+            swapped[k] = { triplets[k].col, triplets[k].row, triplets[k].value };
+        }
+        CscMatrix m;
+        m.t_ = CsrMatrix::from_triplets(cols, rows, swapped);
+        return m;
+    }
+
+    size_t rows() const {
+        return t_.cols();
+    }
+
+    size_t cols() const {
+        return t_.rows();
+    }
+
+    size_t nnz() const {
+        return t_.nnz();
+    }
+
+    const std::vector<size_t>& col_ptr() const {
+        return t_.row_ptr();
+    }
+
+    const std::vector<sparse_index>& row_idx() const {
+        return t_.col_idx();
+    }
+
+    const aligned_vector<double>& values() const {
+        return t_.values();
+    }
+
+    double operator()(size_t i, size_t j) const {
+        return t_(j, i);
+    }
+
+    CsrMatrix to_csr() const {
+        return t_.transpose();
+    }
+
+    Matrix to_dense() const {
+        return t_.to_dense().T();
+    }
+
+    // y = alpha * A x + beta * y, 对列的散射需要 (num_threads() - 1) * rows() 的缓冲区, 从 ws 切出
+    void multiply(const double* x, double* y, double alpha, double beta, Workspace& ws) const {
+        t_.multiply_transpose(x, y, alpha, beta, ws);
+    }
+
+    void multiply(const double* x, double* y, double alpha = 1.0, double beta = 0.0) const {
+        t_.multiply_transpose(x, y, alpha, beta);
+    }
+
+    // y = alpha * A^T x + beta * y
+    void multiply_transpose(const double* x, double* y, double alpha = 1.0, double beta = 0.0) const {
+        t_.multiply(x, y, alpha, beta);
+    }
+
+    friend Vector operator*(const CscMatrix& A, const Vector& x) {
+        return A.t_.multiply_transpose(x);
+    }
+
+    Vector multiply_transpose(const Vector& x) const {
+        return t_ * x;
+    }
+
+    std::string to_string() const {
+        std::string str = fmt::format("Csc {} x {}, nnz {} [ ", rows(), cols(), nnz());
+        for (size_t j = 0; j < cols(); j++) {
+            for (size_t k = col_ptr()[j]; k < col_ptr()[j + 1]; k++) {
+                str += fmt::format("({}, {}) {:.3f}", row_idx()[k], j, values()[k]);
+                if (k + 1 != nnz()) {
+                    str += ", ";
+                }
+            }
+        }
+        str += " ]";
+        return str;
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const CscMatrix& m) {
+        os << m.to_string();
+        return os;
+    }
+
+    void print() const {
+        std::cout << *this << std::endl;
+    }
+
+private:
+    CsrMatrix t_;
+};
+
+/**
+ * @brief COO 格式, 用于组装: 逐个加入三元组 (可以重复), 最后转换为 CSR 或 CSC, 重复的位置相加
+ */
+class CooMatrix {
+public:
+    /**
+     * @brief 列数超过 UINT32_MAX 时抛出 std::length_error
+     */
+    explicit CooMatrix(size_t rows = 0, size_t cols = 0) : rows_(rows), cols_(cols) {
+        detail::check_sparse_dim(cols);
+    }
+
+    void reserve(size_t n) {
+        triplets_.reserve(n);
+    }
+
+    /**
+     * @brief 加入一个三元组, 下标越界时抛出 std::out_of_range
+     */
+    void add(size_t i, size_t j, double value) {
+        detail::check_sparse_index(i, j, rows_, cols_);
+        triplets_.push_back({ i, j, value });
+    }
+
+    size_t rows() const {
+        return rows_;
+    }
+
+    size_t cols() const {
+        return cols_;
+    }
+
+    /**
+     * @brief 已加入的三元组个数 (包含重复的位置)
+     */
+    size_t size() const {
+        return triplets_.size();
+    }
+
+    const std::vector<Triplet>& triplets() const {
+        return triplets_;
+    }
+
+    CsrMatrix to_csr() const {
+        return CsrMatrix::from_triplets(rows_, cols_, triplets_);
+    }
+
+    CscMatrix to_csc() const {
+        return CscMatrix::from_triplets(rows_, cols_, triplets_);
+    }
+
+private:
+    size_t rows_;
+    size_t cols_;
+    std::vector<Triplet> triplets_;
+};
+
+}
@@ -0,0 +1,427 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <zmath/utils.h>
+#include <zmath/utils/simd.h>
+#include <zmath/utils/thread_pool.h>
+#include "fixed.h"
+#include "vec3_batch.h"
+
+// 三维旋转和仿射变换: 四元数 Quaternion, 旋转矩阵 Mat3, 齐次仿射矩阵 Mat4 之间的转换,
+// 以及成批变换点的 transform_points. 批量变换先把任意表示转换成 3 x 4 的 [R | t], 再对所有点套用同一个核
+
+namespace zmath {
+
+/**
+ * @brief 单位四元数表示的旋转, q = w + xi + yj + zk
+ */
+template <typename T>
+class Quaternion {
+public:
+    T w {1};
+    T x {0};
+    T y {0};
+    T z {0};
+
+    constexpr Quaternion() = default;
+    constexpr Quaternion(T w, T x, T y, T z) : w(w), x(x), y(y), z(z) { }
+
+    static constexpr Quaternion identity() {
+        return Quaternion();
+    }
+
+    /**
+     * @brief 绕 axis 旋转 angle 弧度, axis 不需要是单位向量
+     */
+    static Quaternion from_axis_angle(const Vec<T, 3>& axis, T angle) {
+        const Vec<T, 3> u = axis.normalize();
+        const T s = std::sin(angle / 2);
+        return Quaternion(std::cos(angle / 2), u.x * s, u.y * s, u.z * s);
+    }
+
+    /**
+     * @brief 从旋转矩阵构造 (Shepperd 方法: 按最大的对角量选择公式, 避免除以接近 0 的数)
+     */
+    static Quaternion from_matrix(const Mat<T, 3, 3>& m) {
+        const T tr = m(0, 0) + m(1, 1) + m(2, 2);
+        Quaternion q;
+        if (tr > 0) {
+            const T s = std::sqrt(tr + 1) * 2; // 4w
+            q = Quaternion(s / 4, (m(2, 1) - m(1, 2)) / s, (m(0, 2) - m(2, 0)) / s, (m(1, 0) - m(0, 1)) / s);
+        } else if (m(0, 0) > m(1, 1) && m(0, 0) > m(2, 2)) {
+            const T s = std::sqrt(1 + m(0, 0) - m(1, 1) - m(2, 2)) * 2; // 4x
+            q = Quaternion((m(2, 1) - m(1, 2)) / s, s / 4, (m(0, 1) + m(1, 0)) / s, (m(0, 2) + m(2, 0)) / s);
+        } else if (m(1, 1) > m(2, 2)) {
+            const T s = std::sqrt(1 + m(1, 1) - m(0, 0) - m(2, 2)) * 2; // 4y
+            q = Quaternion((m(0, 2) - m(2, 0)) / s, (m(0, 1) + m(1, 0)) / s, s / 4, (m(1, 2) + m(2, 1)) / s);
+        } else {
+            const T s = std::sqrt(1 + m(2, 2) - m(0, 0) - m(1, 1)) * 2; // 4z
+            q = Quaternion((m(1, 0) - m(0, 1)) / s, (m(0, 2) + m(2, 0)) / s, (m(1, 2) + m(2, 1)) / s, s / 4);
+        }
+        return q.normalize();
+    }
+
+    /**
+     * @brief 旋转轴和角度, 角度在 [0, pi]. 旋转角为 0 时轴取 x 轴
+     */
+    std::pair<Vec<T, 3>, T> to_axis_angle() const {
+        const Quaternion q = w < 0 ? -*this : *this;
+        const T s = std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z);
+        if (s == 0) return { Vec<T, 3>(1, 0, 0), T(0) };
+        return { Vec<T, 3>(q.x / s, q.y / s, q.z / s), 2 * std::atan2(s, q.w) };
+    }
+
+    constexpr Mat<T, 3, 3> to_matrix() const {
+        const T xx = x * x, yy = y * y, zz = z * z;
+        const T xy = x * y, xz = x * z, yz = y * z;
+        const T wx = w * x, wy = w * y, wz = w * z;
+        return Mat<T, 3, 3> {
+            { 1 - 2 * (yy + zz), 2 * (xy - wz), 2 * (xz + wy) },
+            { 2 * (xy + wz), 1 - 2 * (xx + zz), 2 * (yz - wx) },
+            { 2 * (xz - wy), 2 * (yz + wx), 1 - 2 * (xx + yy) },
+        };
+    }
+
+    constexpr Vec<T, 3> vec() const {
+        return Vec<T, 3>(x, y, z);
+    }
+
+    constexpr T dot(const Quaternion& q) const {
+        return w * q.w + x * q.x + y * q.y + z * q.z;
+    }
+
+    T norm() const {
+        return std::sqrt(dot(*this));
+    }
+
+    Quaternion normalize() const {
+        const T n = norm();
+        return Quaternion(w / n, x / n, y / n, z / n);
+    }
+
+    // 共轭, 对单位四元数就是逆旋转
+    constexpr Quaternion conjugate() const {
+        return Quaternion(w, -x, -y, -z);
+    }
+
+    constexpr Quaternion inverse() const {
+        const T n = dot(*this);
+        return Quaternion(w / n, -x / n, -y / n, -z / n);
+    }
+
+    /**
+     * @brief 旋转向量 v, 要求 *this 是单位四元数. v' = v + w t + q_v x t, t = 2 q_v x v
+     */
+    constexpr Vec<T, 3> rotate(const Vec<T, 3>& v) const {
+        const Vec<T, 3> u = vec();
+        const Vec<T, 3> t = T(2) * u.cross(v);
+        return v + w * t + u.cross(t);
+    }
+
+    // Hamilton 乘积, (a * b) 表示先做 b 再做 a 的旋转
+    friend constexpr Quaternion operator*(const Quaternion& a, const Quaternion& b) {
+        return Quaternion(a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+                          a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+                          a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+                          a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w);
+    }
+
+    friend constexpr Vec<T, 3> operator*(const Quaternion& q, const Vec<T, 3>& v) {
+        return q.rotate(v);
+    }
+
+    friend constexpr Quaternion operator-(const Quaternion& q) {
+        return Quaternion(-q.w, -q.x, -q.y, -q.z);
+    }
+
+    // q 和 -q 表示同一个旋转
+    bool operator==(const Quaternion& rhs) const {
+        const T d = dot(rhs);
+        return zmath::eq(std::abs(d), 1.0);
+    }
+
+    bool operator!=(const Quaternion& rhs) const {
+        return !(*this == rhs);
+    }
+
+    std::string to_string() const {
+        return fmt::format("Quat ( {:.3f}, {:.3f}, {:.3f}, {:.3f} )", w, x, y, z);
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const Quaternion& q) {
+        os << q.to_string();
+        return os;
+    }
+
+    void print() const {
+        std::cout << *this << std::endl;
+    }
+};
+
+using Quat = Quaternion<double>;
+using Quatf = Quaternion<float>;
+
+/**
+ * @brief 归一化线性插值, 比 slerp 便宜, 角速度不均匀. 走较短的一侧
+ */
+template <typename T>
+Quaternion<T> nlerp(const Quaternion<T>& a, const Quaternion<T>& b, T t) {
+    const T s = a.dot(b) < 0 ? T(-1) : T(1);
+    return Quaternion<T>(a.w + (s * b.w - a.w) * t, a.x + (s * b.x - a.x) * t,
+                         a.y + (s * b.y - a.y) * t, a.z + (s * b.z - a.z) * t).normalize();
+}
+
+/**
+ * @brief 球面线性插值, 匀角速度. 走较短的一侧, 两者非常接近时退化为 nlerp
+ */
+template <typename T>
+Quaternion<T> slerp(const Quaternion<T>& a, const Quaternion<T>& b, T t) {
+    T d = a.dot(b);
+    Quaternion<T> c = b;
+    if (d < 0) {
+        d = -d;
+        c = -b;
+    }
+    if (d > T(0.9995)) return nlerp(a, c, t);
+    const T theta = std::acos(d);
+    const T s = std::sin(theta);
+    const T wa = std::sin((1 - t) * theta) / s;
+    const T wb = std::sin(t * theta) / s;
+    return Quaternion<T>(wa * a.w + wb * c.w, wa * a.x + wb * c.x, wa * a.y + wb * c.y, wa * a.z + wb * c.z);
+}
+
+// 齐次仿射矩阵 [R t; 0 1]
+
+template <typename T>
+constexpr Mat<T, 4, 4> affine(const Mat<T, 3, 3>& linear, const Vec<T, 3>& translation) {
+    Mat<T, 4, 4> m = Mat<T, 4, 4>::identity();
+    for (size_t i = 0; i < 3; i++) {
+        for (size_t j = 0; j < 3; j++) {
+            m(i, j) = linear(i, j);
+        }
+        m(i, 3) = translation[i];
+    }
+    return m;
+}
+
+template <typename T>
+constexpr Mat<T, 4, 4> affine(const Quaternion<T>& rotation, const Vec<T, 3>& translation) {
+    return affine(rotation.to_matrix(), translation);
+}
+
+template <typename T>
+constexpr Mat<T, 4, 4> translation(const Vec<T, 3>& t) {
+    return affine(Mat<T, 3, 3>::identity(), t);
+}
+
+template <typename T>
+constexpr Mat<T, 4, 4> scaling(const Vec<T, 3>& s) {
+    Mat<T, 4, 4> m = Mat<T, 4, 4>::identity();
+    for (size_t i = 0; i < 3; i++) m(i, i) = s[i];
+    return m;
+}
+
+/**
+ * @brief 仿射变换点 (齐次坐标 w = 1), 只使用 m 的前三行
+ */
+template <typename T>
+constexpr Vec<T, 3> transform_point(const Mat<T, 4, 4>& m, const Vec<T, 3>& p) {
+    Vec<T, 3> r;
+    for (size_t i = 0; i < 3; i++) {
+        r[i] = m(i, 0) * p.x + m(i, 1) * p.y + m(i, 2) * p.z + m(i, 3);
+    }
+    return r;
+}
+
+/**
+ * @brief 仿射变换方向 (w = 0), 不受平移影响
+ */
+template <typename T>
+constexpr Vec<T, 3> transform_vector(const Mat<T, 4, 4>& m, const Vec<T, 3>& v) {
+    Vec<T, 3> r;
+    for (size_t i = 0; i < 3; i++) {
+        r[i] = m(i, 0) * v.x + m(i, 1) * v.y + m(i, 2) * v.z;
+    }
+    return r;
+}
+
+/**
+ * @brief 仿射变换的逆, 要求前三列是可逆的线性变换: [A t]^-1 = [A^-1, -A^-1 t]
+ */
+template <typename T>
+Mat<T, 4, 4> affine_inverse(const Mat<T, 4, 4>& m) {
+    Mat<T, 3, 3> a;
+    for (size_t i = 0; i < 3; i++) {
+        for (size_t j = 0; j < 3; j++) {
+            a(i, j) = m(i, j);
+        }
+    }
+    const Mat<T, 3, 3> ai = a.inv();
+    return affine(ai, -(ai * Vec<T, 3>(m(0, 3), m(1, 3), m(2, 3))));
+}
+
+namespace detail {
+
+// 每块至少这么多个点时才分给线程池
+constexpr size_t transform_grain = size_t(1) << 13;
+
+// 3 x 4 的 [R | t], 行主序
+template <typename T>
+struct Affine34 {
+    T m[3][4];
+};
+
+template <typename T>
+constexpr Affine34<T> to_affine34(const Mat<T, 4, 4>& m) {
+    Affine34<T> a {};
+    for (size_t i = 0; i < 3; i++) {
+        for (size_t j = 0; j < 4; j++) {
+            a.m[i][j] = m(i, j);
+        }
+    }
+    return a;
+}
+
+template <typename T>
+constexpr Affine34<T> to_affine34(const Mat<T, 3, 3>& m) {
+    return to_affine34(affine(m, Vec<T, 3>()));
+}
+
+template <typename T>
+constexpr Affine34<T> to_affine34(const Quaternion<T>& q) {
+    return to_affine34(q.to_matrix());
+}
+
+template <typename T>
+void transform_points_scalar(const Affine34<T>& a, const Vec<T, 3>* in, size_t n, Vec<T, 3>* out) {
+    for (size_t i = 0; i < n; i++) {
+        const T x = in[i].x, y = in[i].y, z = in[i].z;
+        out[i].x = a.m[0][0] * x + a.m[0][1] * y + a.m[0][2] * z + a.m[0][3];
+        out[i].y = a.m[1][0] * x + a.m[1][1] * y + a.m[1][2] * z + a.m[1][3];
+        out[i].z = a.m[2][0] * x + a.m[2][1] * y + a.m[2][2] * z + a.m[2][3];
+    }
+}
+
+inline void transform_points_soa_scalar(const Affine34<double>& a, Vec3Span in, size_t n, Vec3MutSpan out) {
+    for (size_t i = 0; i < n; i++) {
+        const double x = in.x[i], y = in.y[i], z = in.z[i];
+        out.x[i] = a.m[0][0] * x + a.m[0][1] * y + a.m[0][2] * z + a.m[0][3];
+        out.y[i] = a.m[1][0] * x + a.m[1][1] * y + a.m[1][2] * z + a.m[1][3];
+        out.z[i] = a.m[2][0] * x + a.m[2][1] * y + a.m[2][2] * z + a.m[2][3];
+    }
+}
+
+#ifdef ZMATH_X86_SIMD
+
+// AoS: 每个点的 (x, y, z) 连续存放. 把矩阵的列放进寄存器 (第 4 个分量为 0),
+// p' = c0 x + c1 y + c2 z + t, 每个点 3 次 FMA, 只写回前 3 个分量
+__attribute__((target("avx2,fma")))
+inline void transform_points_avx2(const Affine34<double>& a, const Vec3* in, size_t n, Vec3* out) {
+    const __m256d c0 = _mm256_setr_pd(a.m[0][0], a.m[1][0], a.m[2][0], 0.0);
+    const __m256d c1 = _mm256_setr_pd(a.m[0][1], a.m[1][1], a.m[2][1], 0.0);
+    const __m256d c2 = _mm256_setr_pd(a.m[0][2], a.m[1][2], a.m[2][2], 0.0);
+    const __m256d t = _mm256_setr_pd(a.m[0][3], a.m[1][3], a.m[2][3], 0.0);
+    const __m256i mask = _mm256_setr_epi64x(-1, -1, -1, 0);
+    for (size_t i = 0; i < n; i++) {
+        const double* p = &in[i].x;
+        __m256d r = _mm256_fmadd_pd(c0, _mm256_broadcast_sd(p), t);
+        r = _mm256_fmadd_pd(c1, _mm256_broadcast_sd(p + 1), r);
+        r = _mm256_fmadd_pd(c2, _mm256_broadcast_sd(p + 2), r);
+        _mm256_maskstore_pd(&out[i].x, mask, r);
+    }
+}
+
+// SoA: 4 个点一组, 矩阵元素广播到寄存器
+__attribute__((target("avx2,fma")))
+inline void transform_points_soa_avx2(const Affine34<double>& a, Vec3Span in, size_t n, Vec3MutSpan out) {
+    __m256d m[3][4];
+    for (size_t r = 0; r < 3; r++) {
+        for (size_t c = 0; c < 4; c++) {
+            m[r][c] = _mm256_set1_pd(a.m[r][c]);
+        }
+    }
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d x = _mm256_loadu_pd(in.x + i), y = _mm256_loadu_pd(in.y + i), z = _mm256_loadu_pd(in.z + i);
+        double* dst[3] = { out.x + i, out.y + i, out.z + i };
+        for (size_t r = 0; r < 3; r++) {
+            const __m256d v = _mm256_fmadd_pd(m[r][2], z, _mm256_fmadd_pd(m[r][1], y, _mm256_fmadd_pd(m[r][0], x, m[r][3])));
+            _mm256_storeu_pd(dst[r], v);
+        }
+    }
+    transform_points_soa_scalar(a, in.offset(i), n - i, out.offset(i));
+}
+
+#endif
+
+template <typename T>
+void transform_points_impl(const Affine34<T>& a, const Vec<T, 3>* in, size_t n, Vec<T, 3>* out) {
+#ifdef ZMATH_X86_SIMD
+    if constexpr (std::is_same_v<T, double> && sizeof(Vec3) == 3 * sizeof(double)) {
+        if (cpu_simd_level() >= SimdLevel::AVX2) {
+            parallel_for(0, n, transform_grain, [&](size_t lo, size_t hi) {
+                transform_points_avx2(a, in + lo, hi - lo, out + lo);
+            });
+            return;
+        }
+    }
+#endif
+    parallel_for(0, n, transform_grain, [&](size_t lo, size_t hi) {
+        transform_points_scalar(a, in + lo, hi - lo, out + lo);
+    });
+}
+
+inline void transform_points_impl(const Affine34<double>& a, const Vec3Batch& in, Vec3Batch& out) {
+    out.resize(in.size());
+    const Vec3Span src { in.x(), in.y(), in.z() };
+    const Vec3MutSpan dst { out.x(), out.y(), out.z() };
+#ifdef ZMATH_X86_SIMD
+    if (cpu_simd_level() >= SimdLevel::AVX2) {
+        parallel_for(0, in.size(), transform_grain, [&](size_t lo, size_t hi) {
+            transform_points_soa_avx2(a, src.offset(lo), hi - lo, dst.offset(lo));
+        });
+        return;
+    }
+#endif
+    parallel_for(0, in.size(), transform_grain, [&](size_t lo, size_t hi) {
+        transform_points_soa_scalar(a, src.offset(lo), hi - lo, dst.offset(lo));
+    });
+}
+
+}
+
+/**
+ * @brief 成批变换点: out[i] = X(in[i]), X 是 Quaternion (旋转), Mat3 (线性变换) 或 Mat4 (仿射变换).
+ *
+ * 变换只在开始时转换一次, 点之间并行, double 时使用 AVX2. in 和 out 可以是同一个数组
+ */
+template <typename T, typename X>
+void transform_points(const X& transform, const Vec<T, 3>* in, size_t n, Vec<T, 3>* out) {
+    detail::transform_points_impl(detail::to_affine34(transform), in, n, out);
+}
+
+template <typename T, typename X>
+std::vector<Vec<T, 3>> transform_points(const X& transform, const std::vector<Vec<T, 3>>& in) {
+    std::vector<Vec<T, 3>> out(in.size());
+    transform_points(transform, in.data(), in.size(), out.data());
+    return out;
+}
+
+/**
+ * @brief SoA 版本, out 的大小调整为 in.size(), 可以与 in 是同一个对象
+ */
+template <typename X>
+void transform_points(const X& transform, const Vec3Batch& in, Vec3Batch& out) {
+    detail::transform_points_impl(detail::to_affine34(transform), in, out);
+}
+
+}
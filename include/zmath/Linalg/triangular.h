@@ -0,0 +1,261 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+
+#include <zmath/utils/thread_pool.h>
+#include "linalg.h"
+#include "gemm.h"
+
+// 三角方程组 (BLAS 的 trsv / trsm). 所有情形先化成 "左乘一个下三角或上三角矩阵" 的统一形式:
+// T Y = B, T 和 Y 都用 (行步长, 列步长) 描述, 转置和右乘只是换了步长.
+// 按 64 行分块: 对角块逐行代入, 其余部分用 GEMM 更新, 大部分计算量在 GEMM 里
+
+namespace zmath {
+
+/**
+ * @brief 三角矩阵在方程的哪一侧: Left 解 op(A) X = alpha B, Right 解 X op(A) = alpha B
+ */
+enum class Side {
+    Left,
+    Right
+};
+
+/**
+ * @brief 使用 A 的下三角还是上三角部分, 另一半不读取
+ */
+enum class Uplo {
+    Lower,
+    Upper
+};
+
+/**
+ * @brief op(A) 是 A 还是 A^T
+ */
+enum class Trans {
+    No,
+    Yes
+};
+
+/**
+ * @brief Unit 时对角线视为 1, 不读取 (例如 LU 分解中 L 的对角线)
+ */
+enum class Diag {
+    NonUnit,
+    Unit
+};
+
+namespace detail {
+
+constexpr size_t trsm_block = 64;
+
+// 至少这么多个右端项时, 对角块按行做 axpy (每行对所有右端项向量化); 更少时逐个右端项做内积
+constexpr size_t trsm_axpy_min_rhs = 8;
+
+// 编译器不会重排浮点加法, 单个累加器的内积无法向量化, 这里用 4 个独立的累加器
+inline double tri_dot(const double* a, const double* b, size_t n) {
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        s0 += a[i] * b[i];
+        s1 += a[i + 1] * b[i + 1];
+        s2 += a[i + 2] * b[i + 2];
+        s3 += a[i + 3] * b[i + 3];
+    }
+    for (; i < n; i++) s0 += a[i] * b[i];
+    return (s0 + s1) + (s2 + s3);
+}
+
+// T 的 (i, r) 元素位于 t[i * rs + r * cs]
+struct TriOperand {
+    const double* t;
+    size_t rs, cs;
+
+    double operator()(size_t i, size_t r) const {
+        return t[i * rs + r * cs];
+    }
+
+    const double* ptr(size_t i, size_t r) const {
+        return t + i * rs + r * cs;
+    }
+};
+
+// Y 是 n x m, (i, j) 元素位于 y[i * rs + j * cs], 且 rs 和 cs 中有一个为 1
+struct TriRhs {
+    double* y;
+    size_t rs, cs;
+    size_t n, m;
+
+    double& operator()(size_t i, size_t j) const {
+        return y[i * rs + j * cs];
+    }
+
+    // 第 j0 ~ j0+cnt 个右端项
+    TriRhs slice(size_t j0, size_t cnt) const {
+        return { y + j0 * cs, rs, cs, n, cnt };
+    }
+};
+
+// 对角块 i0 ~ i1 内的代入, 块外的贡献已经减掉. lower 时从上往下, 否则从下往上
+inline void trsm_diagonal_block(TriOperand T, TriRhs Y, size_t i0, size_t i1, bool lower, bool unit) {
+    const size_t m = Y.m;
+    if (Y.cs == 1 && m >= trsm_axpy_min_rhs) {
+        // Y 的一行是连续的: 每一步是整行的 axpy, 对所有右端项同时向量化
+        for (size_t k = 0; k < i1 - i0; k++) {
+            const size_t i = lower ? i0 + k : i1 - 1 - k;
+            double* yi = &Y(i, 0);
+            const size_t r0 = lower ? i0 : i + 1, r1 = lower ? i : i1;
+            for (size_t r = r0; r < r1; r++) {
+                const double t = T(i, r);
+                const double* yr = &Y(r, 0);
+                for (size_t j = 0; j < m; j++) yi[j] -= t * yr[j];
+            }
+            if (!unit) {
+                const double d = 1.0 / T(i, i);
+                for (size_t j = 0; j < m; j++) yi[j] *= d;
+            }
+        }
+        return;
+    }
+    // 逐个右端项代入, 内层是 T 的一行与 Y 的一列的内积
+    for (size_t j = 0; j < m; j++) {
+        for (size_t k = 0; k < i1 - i0; k++) {
+            const size_t i = lower ? i0 + k : i1 - 1 - k;
+            const size_t r0 = lower ? i0 : i + 1, r1 = lower ? i : i1;
+            double s = Y(i, j);
+            if (T.cs == 1 && Y.rs == 1) {
+                s -= tri_dot(T.ptr(i, r0), &Y(r0, j), r1 - r0);
+            } else {
+                for (size_t r = r0; r < r1; r++) s -= T(i, r) * Y(r, j);
+            }
+            Y(i, j) = unit ? s : s / T(i, i);
+        }
+    }
+}
+
+// Y(d0:d1, :) -= T(d0:d1, s0:s1) Y(s0:s1, :)
+inline void trsm_update(TriOperand T, TriRhs Y, size_t d0, size_t d1, size_t s0, size_t s1) {
+    const size_t rows = d1 - d0, k = s1 - s0, m = Y.m;
+    if (rows == 0 || k == 0) return;
+    if (m == 1) {
+        // 单个右端项是矩阵乘向量, 不值得为它打包
+        const size_t grain = std::max<size_t>(1, expr_parallel_grain / k);
+        parallel_for(d0, d1, grain, [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; i++) {
+                double s = 0.0;
+                if (T.cs == 1 && Y.rs == 1) {
+                    s = tri_dot(T.ptr(i, s0), &Y(s0, 0), k);
+                } else {
+                    for (size_t r = s0; r < s1; r++) s += T(i, r) * Y(r, 0);
+                }
+                Y(i, 0) -= s;
+            }
+        });
+        return;
+    }
+    if (Y.cs == 1) {
+        gemm_strided(rows, m, k, -1.0, T.ptr(d0, s0), T.rs, T.cs, &Y(s0, 0), Y.rs, 1,
+                     1.0, &Y(d0, 0), Y.rs);
+    } else {
+        // Y 按列连续 (右乘时 Y = X^T): 算转置 Y^T(:, d0:d1) -= Y^T(:, s0:s1) T^T, 写入的仍是行主序的 X
+        gemm_strided(m, rows, k, -1.0, &Y(s0, 0), Y.cs, Y.rs, T.ptr(d0, s0), T.cs, T.rs,
+                     1.0, &Y(d0, 0), Y.cs);
+    }
+}
+
+// 单个连续的右端项 (trsv) 不分块: 按 T 在内存中的方向整行读取, 每个元素只读一次.
+// T 的行连续时每步是一次内积, 列连续时每解出一个分量做一次 axpy
+inline void trsv_unblocked(TriOperand T, double* y, size_t n, bool lower, bool unit) {
+    for (size_t k = 0; k < n; k++) {
+        const size_t i = lower ? k : n - 1 - k;
+        if (T.cs == 1) {
+            const size_t r0 = lower ? 0 : i + 1, r1 = lower ? i : n;
+            const double s = y[i] - tri_dot(T.ptr(i, r0), y + r0, r1 - r0);
+            y[i] = unit ? s : s / T(i, i);
+        } else {
+            if (!unit) y[i] /= T(i, i);
+            const double yi = y[i];
+            const double* ti = T.ptr(0, i);
+            const size_t r0 = lower ? i + 1 : 0, r1 = lower ? n : i;
+            for (size_t r = r0; r < r1; r++) y[r] -= ti[r] * yi;
+        }
+    }
+}
+
+// 解 T X = Y, X 覆盖 Y. T 是 n x n 的下三角 (lower) 或上三角
+inline void trsm_blocked(TriOperand T, TriRhs Y, bool lower, bool unit) {
+    const size_t n = Y.n;
+    if (Y.m == 1 && Y.rs == 1 && (T.cs == 1 || T.rs == 1)) {
+        trsv_unblocked(T, Y.y, n, lower, unit);
+        return;
+    }
+    if (lower) {
+        for (size_t i0 = 0; i0 < n; i0 += trsm_block) {
+            const size_t i1 = std::min(n, i0 + trsm_block);
+            trsm_diagonal_block(T, Y, i0, i1, true, unit);
+            trsm_update(T, Y, i1, n, i0, i1);
+        }
+    } else {
+        for (size_t i1 = n; i1 > 0; ) {
+            const size_t i0 = i1 - std::min(trsm_block, i1);
+            trsm_diagonal_block(T, Y, i0, i1, false, unit);
+            trsm_update(T, Y, 0, i0, i0, i1);
+            i1 = i0;
+        }
+    }
+}
+
+// 右端项足够多时按右端项切片, 每片独立求解. 片内的 GEMM 嵌套在工作线程里串行执行
+inline void trsm_parallel(TriOperand T, TriRhs Y, bool lower, bool unit) {
+    if (Y.m >= 2 * trsm_block && num_threads() > 1) {
+        parallel_for(0, Y.m, trsm_block, [&](size_t lo, size_t hi) {
+            trsm_blocked(T, Y.slice(lo, hi - lo), lower, unit);
+        });
+    } else {
+        trsm_blocked(T, Y, lower, unit);
+    }
+}
+
+}
+
+/**
+ * @brief 三角方程组的多右端项求解, 结果覆盖 B
+ *
+ * Left: op(A) X = alpha B, A 是 B.rows() 阶; Right: X op(A) = alpha B, A 是 B.cols() 阶.
+ * 只读取 A 中 uplo 指定的一半. 对角块逐行代入, 其余部分交给 GEMM; 右端项足够多时按列块 (Right 时按行块) 并行
+ */
+inline void trsm(Side side, Uplo uplo, Trans trans, Diag diag, double alpha, ConstMatrixView A, MatrixView B) {
+    assert(A.rows() == A.cols() && A.rows() == (side == Side::Left ? B.rows() : B.cols()));
+    if (alpha != 1.0) {
+        for (size_t i = 0; i < B.rows(); i++) {
+            double* bi = B.row_ptr(i);
+            for (size_t j = 0; j < B.cols(); j++) bi[j] *= alpha;
+        }
+    }
+    // 化成左乘: Right 时 X op(A) = B 等价于 op(A)^T X^T = B^T
+    const bool transposed = (trans == Trans::Yes) != (side == Side::Right);
+    const detail::TriOperand T = transposed ? detail::TriOperand { A.data(), 1, A.ld() }
+                                            : detail::TriOperand { A.data(), A.ld(), 1 };
+    const bool lower = (uplo == Uplo::Lower) != transposed;
+    const detail::TriRhs Y = side == Side::Left ? detail::TriRhs { B.data(), B.ld(), 1, B.rows(), B.cols() }
+                                                : detail::TriRhs { B.data(), 1, B.ld(), B.cols(), B.rows() };
+    detail::trsm_parallel(T, Y, lower, diag == Diag::Unit);
+}
+
+inline void trsm(Side side, Uplo uplo, Trans trans, Diag diag, double alpha, const Matrix& A, Matrix& B) {
+    trsm(side, uplo, trans, diag, alpha, A.view(), B.view());
+}
+
+/**
+ * @brief 单个右端项的三角方程组 op(A) x = b, 结果覆盖 x
+ */
+inline void trsv(Uplo uplo, Trans trans, Diag diag, ConstMatrixView A, VectorView x) {
+    assert(A.rows() == x.size());
+    trsm(Side::Left, uplo, trans, diag, 1.0, A, MatrixView(x.data(), x.size(), 1, x.stride()));
+}
+
+inline void trsv(Uplo uplo, Trans trans, Diag diag, const Matrix& A, Vector& x) {
+    trsv(uplo, trans, diag, A.view(), x.view());
+}
+
+}
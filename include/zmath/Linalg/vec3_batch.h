@@ -0,0 +1,514 @@
+#pragma once
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <zmath/utils/memory.h>
+#include <zmath/utils/simd.h>
+#include <zmath/utils/thread_pool.h>
+#include "fixed.h"
+
+// 成批的三维向量, 按分量分开存放 (SoA): x, y, z 各是一个对齐的数组. 逐点运算沿数组连续访问,
+// 一次处理 4 个点 (AVX2). 这些运算受内存带宽限制, AVX-512 没有明显收益, 所以只有 AVX2 和标量两种核
+
+namespace zmath {
+
+namespace detail {
+
+// 每块至少这么多个点时才分给线程池
+constexpr size_t vec3_batch_grain = size_t(1) << 14;
+
+struct Vec3Span {
+    const double* x;
+    const double* y;
+    const double* z;
+
+    Vec3Span offset(size_t i) const {
+        return { x + i, y + i, z + i };
+    }
+};
+
+struct Vec3MutSpan {
+    double* x;
+    double* y;
+    double* z;
+
+    Vec3MutSpan offset(size_t i) const {
+        return { x + i, y + i, z + i };
+    }
+};
+
+inline double vec3_norm_scalar(double x, double y, double z, NormMode mode) {
+    if (mode == NormMode::Fast) {
+        return std::sqrt(x * x + y * y + z * z);
+    }
+    // m == 0 时三个分量都是 0, 用 DBL_MIN 代替避免 0 / 0
+    const double m = std::max({ std::abs(x), std::abs(y), std::abs(z), DBL_MIN });
+    // 有分量为 inf 时范数就是 inf, 继续缩放会得到 inf / inf = NaN
+    if (std::isinf(m)) return m;
+    x /= m;
+    y /= m;
+    z /= m;
+    return m * std::sqrt(x * x + y * y + z * z);
+}
+
+inline void vec3_dot_scalar(Vec3Span a, Vec3Span b, size_t n, double* out) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = a.x[i] * b.x[i] + a.y[i] * b.y[i] + a.z[i] * b.z[i];
+    }
+}
+
+inline void vec3_cross_scalar(Vec3Span a, Vec3Span b, size_t n, Vec3MutSpan out) {
+    for (size_t i = 0; i < n; i++) {
+        const double x = a.y[i] * b.z[i] - a.z[i] * b.y[i];
+        const double y = a.z[i] * b.x[i] - a.x[i] * b.z[i];
+        const double z = a.x[i] * b.y[i] - a.y[i] * b.x[i];
+        out.x[i] = x;
+        out.y[i] = y;
+        out.z[i] = z;
+    }
+}
+
+inline void vec3_norm_scalar(Vec3Span a, size_t n, double* out, NormMode mode) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = vec3_norm_scalar(a.x[i], a.y[i], a.z[i], mode);
+    }
+}
+
+inline void vec3_normalize_scalar(Vec3Span a, size_t n, Vec3MutSpan out, NormMode mode) {
+    for (size_t i = 0; i < n; i++) {
+        const double inv = 1.0 / vec3_norm_scalar(a.x[i], a.y[i], a.z[i], mode);
+        out.x[i] = a.x[i] * inv;
+        out.y[i] = a.y[i] * inv;
+        out.z[i] = a.z[i] * inv;
+    }
+}
+
+inline void vec3_distance_scalar(Vec3Span a, Vec3Span b, size_t n, double* out, NormMode mode) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = vec3_norm_scalar(a.x[i] - b.x[i], a.y[i] - b.y[i], a.z[i] - b.z[i], mode);
+    }
+}
+
+// 夹角的余弦, 限制在 [-1, 1]. acos 没有对应的 SIMD 指令, 由调用者逐个计算
+inline void vec3_cos_angle_scalar(Vec3Span a, Vec3Span b, size_t n, double* out, NormMode mode) {
+    for (size_t i = 0; i < n; i++) {
+        double c;
+        if (mode == NormMode::Fast) {
+            const double d = a.x[i] * b.x[i] + a.y[i] * b.y[i] + a.z[i] * b.z[i];
+            const double aa = a.x[i] * a.x[i] + a.y[i] * a.y[i] + a.z[i] * a.z[i];
+            const double bb = b.x[i] * b.x[i] + b.y[i] * b.y[i] + b.z[i] * b.z[i];
+            c = d / std::sqrt(aa * bb);
+        } else {
+            // 与 Vec::angle 相同, 先单位化再点乘, 点乘本身也不会上溢
+            const double ia = 1.0 / vec3_norm_scalar(a.x[i], a.y[i], a.z[i], mode);
+            const double ib = 1.0 / vec3_norm_scalar(b.x[i], b.y[i], b.z[i], mode);
+            c = (a.x[i] * ia) * (b.x[i] * ib) + (a.y[i] * ia) * (b.y[i] * ib) + (a.z[i] * ia) * (b.z[i] * ib);
+        }
+        out[i] = std::max(std::min(c, 1.0), -1.0);
+    }
+}
+
+// a 在 b 方向上的投影 b (a . b) / (b . b)
+inline void vec3_project_scalar(Vec3Span a, Vec3Span b, size_t n, Vec3MutSpan out) {
+    for (size_t i = 0; i < n; i++) {
+        const double d = a.x[i] * b.x[i] + a.y[i] * b.y[i] + a.z[i] * b.z[i];
+        const double bb = b.x[i] * b.x[i] + b.y[i] * b.y[i] + b.z[i] * b.z[i];
+        const double s = d / bb;
+        out.x[i] = b.x[i] * s;
+        out.y[i] = b.y[i] * s;
+        out.z[i] = b.z[i] * s;
+    }
+}
+
+#ifdef ZMATH_X86_SIMD
+
+__attribute__((target("avx2,fma")))
+inline __m256d vec3_dot_avx2(__m256d ax, __m256d ay, __m256d az, __m256d bx, __m256d by, __m256d bz) {
+    return _mm256_fmadd_pd(az, bz, _mm256_fmadd_pd(ay, by, _mm256_mul_pd(ax, bx)));
+}
+
+__attribute__((target("avx2,fma")))
+inline __m256d vec3_norm_avx2(__m256d x, __m256d y, __m256d z, NormMode mode) {
+    if (mode == NormMode::Fast) {
+        return _mm256_sqrt_pd(vec3_dot_avx2(x, y, z, x, y, z));
+    }
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    __m256d m = _mm256_max_pd(_mm256_andnot_pd(sign, x), _mm256_andnot_pd(sign, y));
+    m = _mm256_max_pd(m, _mm256_andnot_pd(sign, z));
+    m = _mm256_max_pd(m, _mm256_set1_pd(DBL_MIN));
+    const __m256d inv = _mm256_div_pd(_mm256_set1_pd(1.0), m);
+    x = _mm256_mul_pd(x, inv);
+    y = _mm256_mul_pd(y, inv);
+    z = _mm256_mul_pd(z, inv);
+    const __m256d r = _mm256_mul_pd(m, _mm256_sqrt_pd(vec3_dot_avx2(x, y, z, x, y, z)));
+    // m 为 inf 的通道直接取 m, 否则是 inf * 0 = NaN
+    return _mm256_blendv_pd(r, m, _mm256_cmp_pd(m, _mm256_set1_pd(HUGE_VAL), _CMP_EQ_OQ));
+}
+
+__attribute__((target("avx2,fma")))
+inline void vec3_dot_avx2(Vec3Span a, Vec3Span b, size_t n, double* out) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d d = vec3_dot_avx2(_mm256_loadu_pd(a.x + i), _mm256_loadu_pd(a.y + i), _mm256_loadu_pd(a.z + i),
+                                        _mm256_loadu_pd(b.x + i), _mm256_loadu_pd(b.y + i), _mm256_loadu_pd(b.z + i));
+        _mm256_storeu_pd(out + i, d);
+    }
+    vec3_dot_scalar(a.offset(i), b.offset(i), n - i, out + i);
+}
+
+__attribute__((target("avx2,fma")))
+inline void vec3_cross_avx2(Vec3Span a, Vec3Span b, size_t n, Vec3MutSpan out) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d ax = _mm256_loadu_pd(a.x + i), ay = _mm256_loadu_pd(a.y + i), az = _mm256_loadu_pd(a.z + i);
+        const __m256d bx = _mm256_loadu_pd(b.x + i), by = _mm256_loadu_pd(b.y + i), bz = _mm256_loadu_pd(b.z + i);
+        const __m256d x = _mm256_fmsub_pd(ay, bz, _mm256_mul_pd(az, by));
+        const __m256d y = _mm256_fmsub_pd(az, bx, _mm256_mul_pd(ax, bz));
+        const __m256d z = _mm256_fmsub_pd(ax, by, _mm256_mul_pd(ay, bx));
+        _mm256_storeu_pd(out.x + i, x);
+        _mm256_storeu_pd(out.y + i, y);
+        _mm256_storeu_pd(out.z + i, z);
+    }
+    vec3_cross_scalar(a.offset(i), b.offset(i), n - i, out.offset(i));
+}
+
+__attribute__((target("avx2,fma")))
+inline void vec3_norm_avx2(Vec3Span a, size_t n, double* out, NormMode mode) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d r = vec3_norm_avx2(_mm256_loadu_pd(a.x + i), _mm256_loadu_pd(a.y + i), _mm256_loadu_pd(a.z + i), mode);
+        _mm256_storeu_pd(out + i, r);
+    }
+    vec3_norm_scalar(a.offset(i), n - i, out + i, mode);
+}
+
+__attribute__((target("avx2,fma")))
+inline void vec3_normalize_avx2(Vec3Span a, size_t n, Vec3MutSpan out, NormMode mode) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d x = _mm256_loadu_pd(a.x + i), y = _mm256_loadu_pd(a.y + i), z = _mm256_loadu_pd(a.z + i);
+        const __m256d inv = _mm256_div_pd(_mm256_set1_pd(1.0), vec3_norm_avx2(x, y, z, mode));
+        _mm256_storeu_pd(out.x + i, _mm256_mul_pd(x, inv));
+        _mm256_storeu_pd(out.y + i, _mm256_mul_pd(y, inv));
+        _mm256_storeu_pd(out.z + i, _mm256_mul_pd(z, inv));
+    }
+    vec3_normalize_scalar(a.offset(i), n - i, out.offset(i), mode);
+}
+
+__attribute__((target("avx2,fma")))
+inline void vec3_distance_avx2(Vec3Span a, Vec3Span b, size_t n, double* out, NormMode mode) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d x = _mm256_sub_pd(_mm256_loadu_pd(a.x + i), _mm256_loadu_pd(b.x + i));
+        const __m256d y = _mm256_sub_pd(_mm256_loadu_pd(a.y + i), _mm256_loadu_pd(b.y + i));
+        const __m256d z = _mm256_sub_pd(_mm256_loadu_pd(a.z + i), _mm256_loadu_pd(b.z + i));
+        _mm256_storeu_pd(out + i, vec3_norm_avx2(x, y, z, mode));
+    }
+    vec3_distance_scalar(a.offset(i), b.offset(i), n - i, out + i, mode);
+}
+
+__attribute__((target("avx2,fma")))
+inline void vec3_cos_angle_avx2(Vec3Span a, Vec3Span b, size_t n, double* out, NormMode mode) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d ax = _mm256_loadu_pd(a.x + i), ay = _mm256_loadu_pd(a.y + i), az = _mm256_loadu_pd(a.z + i);
+        const __m256d bx = _mm256_loadu_pd(b.x + i), by = _mm256_loadu_pd(b.y + i), bz = _mm256_loadu_pd(b.z + i);
+        __m256d c;
+        if (mode == NormMode::Fast) {
+            const __m256d d = vec3_dot_avx2(ax, ay, az, bx, by, bz);
+            const __m256d aa = vec3_dot_avx2(ax, ay, az, ax, ay, az);
+            const __m256d bb = vec3_dot_avx2(bx, by, bz, bx, by, bz);
+            c = _mm256_div_pd(d, _mm256_sqrt_pd(_mm256_mul_pd(aa, bb)));
+        } else {
+            const __m256d one = _mm256_set1_pd(1.0);
+            const __m256d ia = _mm256_div_pd(one, vec3_norm_avx2(ax, ay, az, mode));
+            const __m256d ib = _mm256_div_pd(one, vec3_norm_avx2(bx, by, bz, mode));
+            c = vec3_dot_avx2(_mm256_mul_pd(ax, ia), _mm256_mul_pd(ay, ia), _mm256_mul_pd(az, ia),
+                              _mm256_mul_pd(bx, ib), _mm256_mul_pd(by, ib), _mm256_mul_pd(bz, ib));
+        }
+        c = _mm256_max_pd(_mm256_min_pd(c, _mm256_set1_pd(1.0)), _mm256_set1_pd(-1.0));
+        _mm256_storeu_pd(out + i, c);
+    }
+    vec3_cos_angle_scalar(a.offset(i), b.offset(i), n - i, out + i, mode);
+}
+
+__attribute__((target("avx2,fma")))
+inline void vec3_project_avx2(Vec3Span a, Vec3Span b, size_t n, Vec3MutSpan out) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d ax = _mm256_loadu_pd(a.x + i), ay = _mm256_loadu_pd(a.y + i), az = _mm256_loadu_pd(a.z + i);
+        const __m256d bx = _mm256_loadu_pd(b.x + i), by = _mm256_loadu_pd(b.y + i), bz = _mm256_loadu_pd(b.z + i);
+        const __m256d s = _mm256_div_pd(vec3_dot_avx2(ax, ay, az, bx, by, bz), vec3_dot_avx2(bx, by, bz, bx, by, bz));
+        _mm256_storeu_pd(out.x + i, _mm256_mul_pd(bx, s));
+        _mm256_storeu_pd(out.y + i, _mm256_mul_pd(by, s));
+        _mm256_storeu_pd(out.z + i, _mm256_mul_pd(bz, s));
+    }
+    vec3_project_scalar(a.offset(i), b.offset(i), n - i, out.offset(i));
+}
+
+#endif
+
+inline bool vec3_use_avx2() {
+#ifdef ZMATH_X86_SIMD
+    return cpu_simd_level() >= SimdLevel::AVX2;
+#else
+    return false;
+#endif
+}
+
+}
+
+/**
+ * @brief 成批的三维向量, x, y, z 分量各存一个对齐数组
+ *
+ * 两个 batch 之间的运算逐点进行, 两者大小必须相同. 运算按块分给线程池, 块内按 CPU 选择 AVX2 或标量核
+ */
+class Vec3Batch {
+public:
+    explicit Vec3Batch(size_t n = 0) : x_(n, 0.0), y_(n, 0.0), z_(n, 0.0) { }
+
+    Vec3Batch(const std::vector<Vec3>& v) : x_(v.size()), y_(v.size()), z_(v.size()) {
+        for (size_t i = 0; i < v.size(); i++) {
+            x_[i] = v[i].x;
+            y_[i] = v[i].y;
+            z_[i] = v[i].z;
+        }
+    }
+
+    std::vector<Vec3> to_vector() const {
+        std::vector<Vec3> ret(size());
+        for (size_t i = 0; i < size(); i++) {
+            ret[i] = Vec3(x_[i], y_[i], z_[i]);
+        }
+        return ret;
+    }
+
+    size_t size() const {
+        return x_.size();
+    }
+
+    void resize(size_t n) {
+        x_.resize(n, 0.0);
+        y_.resize(n, 0.0);
+        z_.resize(n, 0.0);
+    }
+
+    void push_back(const Vec3& v) {
+        x_.push_back(v.x);
+        y_.push_back(v.y);
+        z_.push_back(v.z);
+    }
+
+    Vec3 operator[](size_t i) const {
+        return Vec3(x_[i], y_[i], z_[i]);
+    }
+
+    void set(size_t i, const Vec3& v) {
+        x_[i] = v.x;
+        y_[i] = v.y;
+        z_[i] = v.z;
+    }
+
+    double* x() { return x_.data(); }
+    double* y() { return y_.data(); }
+    double* z() { return z_.data(); }
+    const double* x() const { return x_.data(); }
+    const double* y() const { return y_.data(); }
+    const double* z() const { return z_.data(); }
+
+    // 以下运算都有两种形式: 返回新的结果, 或者写入调用者提供的 out (长度为 size(), 可以反复使用, 不分配内存).
+    // 两个 batch 之间的运算 TODO if (rhs.size() != size()) error
+
+    // 逐点点乘
+    void dot(const Vec3Batch& rhs, double* out) const {
+        const bool avx2 = detail::vec3_use_avx2();
+        for_blocks([&](size_t lo, size_t hi) {
+#ifdef ZMATH_X86_SIMD
+            if (avx2) {
+                detail::vec3_dot_avx2(span().offset(lo), rhs.span().offset(lo), hi - lo, out + lo);
+                return;
+            }
+#endif
+            detail::vec3_dot_scalar(span().offset(lo), rhs.span().offset(lo), hi - lo, out + lo);
+        });
+    }
+
+    aligned_vector<double> dot(const Vec3Batch& rhs) const {
+        aligned_vector<double> out(size());
+        dot(rhs, out.data());
+        return out;
+    }
+
+    // 逐点叉乘, out 可以是自己或 rhs
+    void cross(const Vec3Batch& rhs, Vec3Batch& out) const {
+        out.resize(size());
+        const bool avx2 = detail::vec3_use_avx2();
+        for_blocks([&](size_t lo, size_t hi) {
+#ifdef ZMATH_X86_SIMD
+            if (avx2) {
+                detail::vec3_cross_avx2(span().offset(lo), rhs.span().offset(lo), hi - lo, out.mut_span().offset(lo));
+                return;
+            }
+#endif
+            detail::vec3_cross_scalar(span().offset(lo), rhs.span().offset(lo), hi - lo, out.mut_span().offset(lo));
+        });
+    }
+
+    Vec3Batch cross(const Vec3Batch& rhs) const {
+        Vec3Batch out;
+        cross(rhs, out);
+        return out;
+    }
+
+    // 范数
+    void norm(double* out, NormMode mode = NormMode::Safe) const {
+        const bool avx2 = detail::vec3_use_avx2();
+        for_blocks([&](size_t lo, size_t hi) {
+#ifdef ZMATH_X86_SIMD
+            if (avx2) {
+                detail::vec3_norm_avx2(span().offset(lo), hi - lo, out + lo, mode);
+                return;
+            }
+#endif
+            detail::vec3_norm_scalar(span().offset(lo), hi - lo, out + lo, mode);
+        });
+    }
+
+    aligned_vector<double> norm(NormMode mode = NormMode::Safe) const {
+        aligned_vector<double> out(size());
+        norm(out.data(), mode);
+        return out;
+    }
+
+    // 单位化, 零向量的结果为 nan. out 可以是自己
+    void normalize(Vec3Batch& out, NormMode mode = NormMode::Safe) const {
+        out.resize(size());
+        const bool avx2 = detail::vec3_use_avx2();
+        for_blocks([&](size_t lo, size_t hi) {
+#ifdef ZMATH_X86_SIMD
+            if (avx2) {
+                detail::vec3_normalize_avx2(span().offset(lo), hi - lo, out.mut_span().offset(lo), mode);
+                return;
+            }
+#endif
+            detail::vec3_normalize_scalar(span().offset(lo), hi - lo, out.mut_span().offset(lo), mode);
+        });
+    }
+
+    Vec3Batch normalize(NormMode mode = NormMode::Safe) const {
+        Vec3Batch out;
+        normalize(out, mode);
+        return out;
+    }
+
+    // 逐点距离
+    void distance(const Vec3Batch& rhs, double* out, NormMode mode = NormMode::Safe) const {
+        const bool avx2 = detail::vec3_use_avx2();
+        for_blocks([&](size_t lo, size_t hi) {
+#ifdef ZMATH_X86_SIMD
+            if (avx2) {
+                detail::vec3_distance_avx2(span().offset(lo), rhs.span().offset(lo), hi - lo, out + lo, mode);
+                return;
+            }
+#endif
+            detail::vec3_distance_scalar(span().offset(lo), rhs.span().offset(lo), hi - lo, out + lo, mode);
+        });
+    }
+
+    aligned_vector<double> distance(const Vec3Batch& rhs, NormMode mode = NormMode::Safe) const {
+        aligned_vector<double> out(size());
+        distance(rhs, out.data(), mode);
+        return out;
+    }
+
+    // 逐点夹角, 返回弧度
+    void angle(const Vec3Batch& rhs, double* out, NormMode mode = NormMode::Safe) const {
+        const bool avx2 = detail::vec3_use_avx2();
+        for_blocks([&](size_t lo, size_t hi) {
+#ifdef ZMATH_X86_SIMD
+            if (avx2) {
+                detail::vec3_cos_angle_avx2(span().offset(lo), rhs.span().offset(lo), hi - lo, out + lo, mode);
+            } else
+#endif
+            detail::vec3_cos_angle_scalar(span().offset(lo), rhs.span().offset(lo), hi - lo, out + lo, mode);
+            for (size_t i = lo; i < hi; i++) {
+                out[i] = std::acos(out[i]);
+            }
+        });
+    }
+
+    aligned_vector<double> angle(const Vec3Batch& rhs, NormMode mode = NormMode::Safe) const {
+        aligned_vector<double> out(size());
+        angle(rhs, out.data(), mode);
+        return out;
+    }
+
+    // 逐点求自己在 rhs 方向上的投影, out 可以是自己或 rhs
+    void project(const Vec3Batch& rhs, Vec3Batch& out) const {
+        out.resize(size());
+        const bool avx2 = detail::vec3_use_avx2();
+        for_blocks([&](size_t lo, size_t hi) {
+#ifdef ZMATH_X86_SIMD
+            if (avx2) {
+                detail::vec3_project_avx2(span().offset(lo), rhs.span().offset(lo), hi - lo, out.mut_span().offset(lo));
+                return;
+            }
+#endif
+            detail::vec3_project_scalar(span().offset(lo), rhs.span().offset(lo), hi - lo, out.mut_span().offset(lo));
+        });
+    }
+
+    Vec3Batch project(const Vec3Batch& rhs) const {
+        Vec3Batch out;
+        project(rhs, out);
+        return out;
+    }
+
+    std::string to_string() const {
+        std::string str = "Vec3Batch [ ";
+        for (size_t i = 0; i < size(); i++) {
+            str += fmt::format("( {:.3f}, {:.3f}, {:.3f} )", x_[i], y_[i], z_[i]);
+            if (i + 1 != size()) {
+                str += ", ";
+            }
+        }
+        str += " ]";
+        return str;
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const Vec3Batch& v) {
+        os << v.to_string();
+        return os;
+    }
+
+    void print() const {
+        std::cout << *this << std::endl;
+    }
+
+private:
+    aligned_vector<double> x_;
+    aligned_vector<double> y_;
+    aligned_vector<double> z_;
+
+    detail::Vec3Span span() const {
+        return { x_.data(), y_.data(), z_.data() };
+    }
+
+    detail::Vec3MutSpan mut_span() {
+        return { x_.data(), y_.data(), z_.data() };
+    }
+
+    template <typename F>
+    void for_blocks(F f) const {
+        parallel_for(0, size(), detail::vec3_batch_grain, f);
+    }
+};
+
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+
+namespace zmath {
+
+/**
+ * @brief 不拥有数据的向量视图, 相邻元素在内存中相隔 stride 个元素
+ * 
+ * 矩阵的行 (stride = 1) 和列 (stride = ld) 都可以用它表示, 不发生拷贝
+ */
+template <typename T>
+class BasicVectorView {
+public:
+    BasicVectorView() = default;
+    BasicVectorView(T* data, size_t size, size_t stride = 1)
+        : data_(data), size_(size), stride_(stride) { }
+
+    // 非 const 视图可以隐式转换为 const 视图
+    template <typename U, typename = std::enable_if_t<std::is_same_v<const U, T>>>
+    BasicVectorView(const BasicVectorView<U>& v)
+        : data_(v.data()), size_(v.size()), stride_(v.stride()) { }
+
+    T* data() const { return data_; }
+    size_t size() const { return size_; }
+    size_t stride() const { return stride_; }
+
+    T& operator()(size_t i) const {
+        return data_[i * stride_];
+    }
+
+    // 子向量 [begin, begin + n)
+    BasicVectorView segment(size_t begin, size_t n) const {
+        return BasicVectorView(data_ + begin * stride_, n, stride_);
+    }
+
+private:
+    T* data_ {nullptr};
+    size_t size_ {0};
+    size_t stride_ {1};
+};
+
+using VectorView = BasicVectorView<double>;
+using ConstVectorView = BasicVectorView<const double>;
+
+/**
+ * @brief 不拥有数据的行主序矩阵视图
+ * 
+ * (i, j) 元素位于 data[i * ld + j], ld (leading dimension) >= cols.
+ * 子矩阵视图与原矩阵共享 ld, 因此取子块不需要拷贝
+ */
+template <typename T>
+class BasicMatrixView {
+public:
+    BasicMatrixView() = default;
+    BasicMatrixView(T* data, size_t rows, size_t cols, size_t ld)
+        : data_(data), rows_(rows), cols_(cols), ld_(ld) { }
+
+    template <typename U, typename = std::enable_if_t<std::is_same_v<const U, T>>>
+    BasicMatrixView(const BasicMatrixView<U>& m)
+        : data_(m.data()), rows_(m.rows()), cols_(m.cols()), ld_(m.ld()) { }
+
+    T* data() const { return data_; }
+    size_t rows() const { return rows_; }
+    size_t cols() const { return cols_; }
+    size_t ld() const { return ld_; }
+
+    T& operator()(size_t i, size_t j) const {
+        return data_[i * ld_ + j];
+    }
+
+    T* row_ptr(size_t i) const {
+        return data_ + i * ld_;
+    }
+
+    BasicVectorView<T> row(size_t i) const {
+        return BasicVectorView<T>(data_ + i * ld_, cols_, 1);
+    }
+
+    BasicVectorView<T> col(size_t j) const {
+        return BasicVectorView<T>(data_ + j, rows_, ld_);
+    }
+
+    // 从 (i, j) 开始的 r x c 子矩阵
+    BasicMatrixView block(size_t i, size_t j, size_t r, size_t c) const {
+        return BasicMatrixView(data_ + i * ld_ + j, r, c, ld_);
+    }
+
+private:
+    T* data_ {nullptr};
+    size_t rows_ {0};
+    size_t cols_ {0};
+    size_t ld_ {0};
+};
+
+using MatrixView = BasicMatrixView<double>;
+using ConstMatrixView = BasicMatrixView<const double>;
+
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <vector>
+
+#include "multiply.h"
+
+// 多项式的带余除法. 本文件中的系数都按低次在前排列, T 可以是 double 或 ModInt<P>,
+// mul 是该系数类型上的卷积 (double 用 poly_mul, ModInt 用 NTT)
+
+namespace zmath {
+
+namespace detail {
+
+// 商和除式都不少于此长度时用 Newton 迭代求逆做除法, 否则用长除法
+constexpr size_t poly_div_newton_threshold = 128;
+
+// double 系数的 Newton 除法允许的后向误差 |p - q m| / (|p| + |q| |m|) (只看高 nq 项, 取最大模), 超过时改用长除法
+constexpr double poly_div_newton_tol = 1e-12;
+
+// 形式幂级数的逆: 返回 g, 使 f * g = 1 mod x^n, 要求 f[0] 可逆. Newton 迭代 g <- g (2 - f g),
+// 每一步精度翻倍, 总代价是 O(M(n))
+template <typename T, typename Mul>
+std::vector<T> poly_inv_series(const std::vector<T>& f, size_t n, const Mul& mul) {
+    std::vector<T> g { T(1) / f[0] };
+    for (size_t k = 1; k < n; ) {
+        const size_t k2 = std::min(2 * k, n);
+        std::vector<T> fk(f.begin(), f.begin() + std::min(f.size(), k2));
+        std::vector<T> e = mul(fk, g);
+        e.resize(k2, T(0));
+        for (auto& v : e) v = -v;
+        e[0] += T(2);
+        g = mul(g, e);
+        g.resize(k2, T(0));
+        k = k2;
+    }
+    g.resize(n, T(0));
+    return g;
+}
+
+// 长除法 p = q m + r, O(deg q * deg m)
+template <typename T>
+void poly_divmod_naive(const std::vector<T>& p, const std::vector<T>& m, std::vector<T>& q, std::vector<T>& r) {
+    const size_t dm = m.size() - 1;
+    r = p;
+    if (p.size() <= dm) {
+        q.clear();
+        return;
+    }
+    q.assign(p.size() - dm, T(0));
+    const T inv_lead = T(1) / m[dm];
+    for (size_t i = q.size(); i-- > 0; ) {
+        const T c = r[i + dm] * inv_lead;
+        q[i] = c;
+        for (size_t j = 0; j < dm; j++) {
+            r[i + j] -= c * m[j];
+        }
+    }
+    r.resize(dm);
+}
+
+// rev(q) = rev(p) * rev(m)^{-1} mod x^{deg q + 1}, r = p - q m, 代价是 O(M(n)).
+// 浮点系数时, rev(m) 的逆级数增长很快 (m 的条件数差) 会把卷积的舍入误差放大到商的全部有效数字;
+// 此时 q m 的高 nq 项与 p 不再相符, 返回 false, q 和 r 的内容无意义
+template <typename T, typename Mul>
+bool poly_divmod_newton(const std::vector<T>& p, const std::vector<T>& m, std::vector<T>& q, std::vector<T>& r,
+                        const Mul& mul) {
+    const size_t dm = m.size() - 1;
+    const size_t nq = p.size() - dm;
+    std::vector<T> rp(p.rbegin(), p.rbegin() + nq);
+    std::vector<T> rm(m.rbegin(), m.rbegin() + std::min(m.size(), nq));
+    q = mul(rp, poly_inv_series(rm, nq, mul));
+    q.resize(nq);
+    std::reverse(q.begin(), q.end());
+    std::vector<T> qm;
+    if constexpr (std::is_floating_point_v<T>) {
+        // 乘上完整的 m, 高 nq 项用来检查后向误差. NaN 时比较不成立, 同样返回 false
+        qm = mul(q, m);
+        T err = 0, pmax = 0, qmax = 0, mmax = 0;
+        for (size_t i = dm; i < p.size(); i++) err = std::max(err, std::abs(p[i] - qm[i]));
+        for (const T& v : p) pmax = std::max(pmax, std::abs(v));
+        for (const T& v : q) qmax = std::max(qmax, std::abs(v));
+        for (const T& v : m) mmax = std::max(mmax, std::abs(v));
+        if (!(err <= poly_div_newton_tol * (pmax + qmax * mmax))) {
+            return false;
+        }
+    } else {
+        // r 只有低 dm 项, 只需要 m 的低 dm 项
+        qm = mul(q, std::vector<T>(m.begin(), m.begin() + dm));
+    }
+    r.assign(p.begin(), p.begin() + dm);
+    for (size_t i = 0; i < dm; i++) r[i] -= qm[i];
+    return true;
+}
+
+/**
+ * @brief p = q m + r, deg r < deg m. m 的首项系数 (最后一个) 必须非 0, 结果不去掉高次的 0
+ *
+ * 商和除式都足够长时用 Newton 迭代. double 系数的 Newton 结果后向误差过大 (除式条件数差) 时改用长除法,
+ * 这种情况下代价退回 O(deg q * deg m)
+ */
+template <typename T, typename Mul>
+void poly_divmod(const std::vector<T>& p, const std::vector<T>& m, std::vector<T>& q, std::vector<T>& r,
+                 const Mul& mul) {
+    const size_t dm = m.size() - 1;
+    if (p.size() <= dm) {
+        q.clear();
+        r = p;
+    } else if (std::min(p.size() - dm, dm) < poly_div_newton_threshold || !poly_divmod_newton(p, m, q, r, mul)) {
+        poly_divmod_naive(p, m, q, r);
+    }
+}
+
+struct PolyMulDouble {
+    std::vector<double> operator()(const std::vector<double>& a, const std::vector<double>& b) const {
+        return poly_mul(a, b);
+    }
+};
+
+inline std::vector<double> poly_rem(const std::vector<double>& p, const std::vector<double>& m) {
+    std::vector<double> q, r;
+    poly_divmod(p, m, q, r, PolyMulDouble());
+    return r;
+}
+
+}
+
+}
@@ -0,0 +1,243 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <zmath/utils/simd.h>
+#include <zmath/utils/thread_pool.h>
+#include "multiply.h"
+#include "division.h"
+
+// 多项式的多点求值. 系数按高次在前排列 (与 Polynomial 一致).
+// Horner: 每个点 O(n), 多个点同时放在 SIMD 寄存器里计算, 点数组按线程切分;
+// 子乘积树 (subproduct tree): 对 m 个点总共 O(m log^2 m), 适合次数和点数都很大的情况
+
+namespace zmath {
+
+enum class PolyEvalMode {
+    Auto,
+    Horner,
+    SubproductTree
+};
+
+/**
+ * @brief 自动选择算法时使用的阈值, 可以直接修改 poly_eval_thresholds() 覆盖
+ *
+ * 子乘积树在 double 下不稳定: 树上结点 prod (t - x_i) 的系数随点数指数增长, 对 [-1, 1] 中
+ * 随机的 256 个点误差就已经不可接受. bench 中 SIMD Horner 在 65536 个系数 x 65536 个点时仍与子乘积树持平,
+ * 所以默认不自动切换到子乘积树, 只在点的分布已知良好时手动选择
+ */
+struct PolyEvalThresholds {
+    size_t subproduct_tree = SIZE_MAX; // 系数个数和点数都不少于此值时使用子乘积树
+    size_t leaf = 64;              // 子乘积树中不再细分, 直接用 Horner 求值的点数
+};
+
+inline PolyEvalThresholds& poly_eval_thresholds() {
+    static PolyEvalThresholds thresholds;
+    return thresholds;
+}
+
+namespace detail {
+
+inline void poly_eval_horner_scalar(const double* c, size_t nc, const double* x, size_t n, double* out) {
+    for (size_t i = 0; i < n; i++) {
+        const double xi = x[i];
+        double acc = c[0];
+        for (size_t k = 1; k < nc; k++) {
+            acc = acc * xi + c[k];
+        }
+        out[i] = acc;
+    }
+}
+
+#ifdef ZMATH_X86_SIMD
+
+// 16 个点一组, 4 条独立的 FMA 依赖链掩盖延迟
+__attribute__((target("avx2,fma")))
+inline void poly_eval_horner_avx2(const double* c, size_t nc, const double* x, size_t n, double* out) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m256d x0 = _mm256_loadu_pd(x + i), x1 = _mm256_loadu_pd(x + i + 4);
+        const __m256d x2 = _mm256_loadu_pd(x + i + 8), x3 = _mm256_loadu_pd(x + i + 12);
+        __m256d a0 = _mm256_set1_pd(c[0]), a1 = a0, a2 = a0, a3 = a0;
+        for (size_t k = 1; k < nc; k++) {
+            const __m256d ck = _mm256_set1_pd(c[k]);
+            a0 = _mm256_fmadd_pd(a0, x0, ck);
+            a1 = _mm256_fmadd_pd(a1, x1, ck);
+            a2 = _mm256_fmadd_pd(a2, x2, ck);
+            a3 = _mm256_fmadd_pd(a3, x3, ck);
+        }
+        _mm256_storeu_pd(out + i, a0);
+        _mm256_storeu_pd(out + i + 4, a1);
+        _mm256_storeu_pd(out + i + 8, a2);
+        _mm256_storeu_pd(out + i + 12, a3);
+    }
+    for (; i + 4 <= n; i += 4) {
+        const __m256d x0 = _mm256_loadu_pd(x + i);
+        __m256d a0 = _mm256_set1_pd(c[0]);
+        for (size_t k = 1; k < nc; k++) {
+            a0 = _mm256_fmadd_pd(a0, x0, _mm256_set1_pd(c[k]));
+        }
+        _mm256_storeu_pd(out + i, a0);
+    }
+    poly_eval_horner_scalar(c, nc, x + i, n - i, out + i);
+}
+
+__attribute__((target("avx512f")))
+inline void poly_eval_horner_avx512(const double* c, size_t nc, const double* x, size_t n, double* out) {
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const __m512d x0 = _mm512_loadu_pd(x + i), x1 = _mm512_loadu_pd(x + i + 8);
+        const __m512d x2 = _mm512_loadu_pd(x + i + 16), x3 = _mm512_loadu_pd(x + i + 24);
+        __m512d a0 = _mm512_set1_pd(c[0]), a1 = a0, a2 = a0, a3 = a0;
+        for (size_t k = 1; k < nc; k++) {
+            const __m512d ck = _mm512_set1_pd(c[k]);
+            a0 = _mm512_fmadd_pd(a0, x0, ck);
+            a1 = _mm512_fmadd_pd(a1, x1, ck);
+            a2 = _mm512_fmadd_pd(a2, x2, ck);
+            a3 = _mm512_fmadd_pd(a3, x3, ck);
+        }
+        _mm512_storeu_pd(out + i, a0);
+        _mm512_storeu_pd(out + i + 8, a1);
+        _mm512_storeu_pd(out + i + 16, a2);
+        _mm512_storeu_pd(out + i + 24, a3);
+    }
+    for (; i + 8 <= n; i += 8) {
+        const __m512d x0 = _mm512_loadu_pd(x + i);
+        __m512d a0 = _mm512_set1_pd(c[0]);
+        for (size_t k = 1; k < nc; k++) {
+            a0 = _mm512_fmadd_pd(a0, x0, _mm512_set1_pd(c[k]));
+        }
+        _mm512_storeu_pd(out + i, a0);
+    }
+    poly_eval_horner_scalar(c, nc, x + i, n - i, out + i);
+}
+
+#endif
+
+// 单线程 Horner, 按 CPU 选择计算核
+inline void poly_eval_horner_serial(const double* c, size_t nc, const double* x, size_t n, double* out) {
+#ifdef ZMATH_X86_SIMD
+    const SimdLevel level = cpu_simd_level();
+    if (level >= SimdLevel::AVX512) {
+        poly_eval_horner_avx512(c, nc, x, n, out);
+        return;
+    }
+    if (level >= SimdLevel::AVX2) {
+        poly_eval_horner_avx2(c, nc, x, n, out);
+        return;
+    }
+#endif
+    poly_eval_horner_scalar(c, nc, x, n, out);
+}
+
+inline void poly_eval_horner(const double* c, size_t nc, const double* x, size_t n, double* out) {
+    // 每块至少约 2^16 次乘加
+    const size_t grain = std::max<size_t>(64, (size_t(1) << 16) / nc);
+    parallel_for(0, n, grain, [=](size_t lo, size_t hi) {
+        poly_eval_horner_serial(c, nc, x + lo, hi - lo, out + lo);
+    });
+}
+
+// 点 x[0, n) 上的子乘积树. 结点 v 存 prod (t - x_i), 低次在前, 叶结点最多 leaf 个点
+class SubproductTree {
+public:
+    SubproductTree(const double* x, size_t n, size_t leaf) : x_(x), n_(n), leaf_(std::max<size_t>(leaf, 1)) {
+        size_t nodes = 1;
+        while (nodes * leaf_ < n_) nodes *= 2;
+        tree_.resize(2 * nodes);
+        build(1, 0, n_);
+    }
+
+    // out[i] = p(x_i), p 低次在前
+    void evaluate(const std::vector<double>& p, double* out) const {
+        evaluate(1, 0, n_, poly_rem(p, tree_[1]), out);
+    }
+
+private:
+    const double* x_;
+    size_t n_;
+    size_t leaf_;
+    std::vector<std::vector<double>> tree_;
+
+    void build(size_t v, size_t lo, size_t hi) {
+        if (hi - lo <= leaf_) {
+            std::vector<double>& m = tree_[v];
+            m.assign(1, 1.0);
+            for (size_t i = lo; i < hi; i++) {
+                // m <- m * (t - x_i)
+                m.push_back(0.0);
+                for (size_t k = m.size() - 1; k > 0; k--) {
+                    m[k] = m[k - 1] - x_[i] * m[k];
+                }
+                m[0] = -x_[i] * m[0];
+            }
+            return;
+        }
+        const size_t mid = lo + (hi - lo) / 2;
+        build(2 * v, lo, mid);
+        build(2 * v + 1, mid, hi);
+        tree_[v] = poly_mul(tree_[2 * v], tree_[2 * v + 1]);
+    }
+
+    void evaluate(size_t v, size_t lo, size_t hi, const std::vector<double>& r, double* out) const {
+        if (hi - lo <= leaf_) {
+            std::vector<double> c(r.rbegin(), r.rend());
+            if (c.empty()) c.push_back(0.0);
+            poly_eval_horner_serial(c.data(), c.size(), x_ + lo, hi - lo, out + lo);
+            return;
+        }
+        const size_t mid = lo + (hi - lo) / 2;
+        evaluate(2 * v, lo, mid, poly_rem(r, tree_[2 * v]), out);
+        evaluate(2 * v + 1, mid, hi, poly_rem(r, tree_[2 * v + 1]), out);
+    }
+};
+
+inline void poly_eval_subproduct_tree(const double* c, size_t nc, const double* x, size_t n, double* out) {
+    // 点数远多于次数时按约 nc 个点分块, 每块一棵树, 各块并行
+    const std::vector<double> p(std::make_reverse_iterator(c + nc), std::make_reverse_iterator(c));
+    const size_t leaf = poly_eval_thresholds().leaf;
+    const size_t block = std::max(nc, leaf);
+    parallel_for(0, (n + block - 1) / block, 1, [&](size_t lo, size_t hi) {
+        for (size_t b = lo; b < hi; b++) {
+            const size_t s = b * block, len = std::min(block, n - s);
+            SubproductTree(x + s, len, leaf).evaluate(p, out + s);
+        }
+    });
+}
+
+}
+
+/**
+ * @brief 返回 Auto 时会使用的算法
+ *
+ * @param nc 系数个数
+ * @param n 点数
+ */
+inline PolyEvalMode poly_eval_select(size_t nc, size_t n) {
+    const size_t t = poly_eval_thresholds().subproduct_tree;
+    return std::min(nc, n) >= t ? PolyEvalMode::SubproductTree : PolyEvalMode::Horner;
+}
+
+/**
+ * @brief out[i] = p(x[i]), p 的系数按高次在前排列
+ *
+ * @param out 长度至少为 n
+ */
+inline void poly_eval(const double* coef, size_t nc, const double* x, size_t n, double* out,
+                      PolyEvalMode mode = PolyEvalMode::Auto) {
+    if (n == 0) return;
+    if (nc == 0) {
+        std::fill(out, out + n, 0.0);
+        return;
+    }
+    if (mode == PolyEvalMode::Auto) mode = poly_eval_select(nc, n);
+    if (mode == PolyEvalMode::SubproductTree) {
+        detail::poly_eval_subproduct_tree(coef, nc, x, n, out);
+    } else {
+        detail::poly_eval_horner(coef, nc, x, n, out);
+    }
+}
+
+}
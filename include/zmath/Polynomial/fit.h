@@ -0,0 +1,211 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <zmath/utils/thread_pool.h>
+#include "polynomial.h"
+
+// 多项式最小二乘拟合. 用 Householder QR 逐块消去样本, 只保存 (order + 1) 阶的上三角 R 和 Q^T y,
+// 不形成法方程 (法方程会把条件数平方). x 先平移缩放到 t = (x - center) / scale, 在 t 的幂次基下拟合
+
+namespace zmath {
+
+/**
+ * @brief 流式的多项式最小二乘拟合, 内存 O(order^2), 与样本数无关
+ *
+ * 样本可以分多次加入, 多个 fitter 的结果可以合并 (每个线程一个 fitter, 最后 merge)
+ */
+class PolynomialFitter {
+public:
+    /**
+     * @param order 拟合的多项式的度
+     * @param x_center, x_scale 拟合在 t = (x - x_center) / x_scale 上进行, 应使 t 大致落在 [-1, 1]
+     */
+    explicit PolynomialFitter(int order, double x_center = 0.0, double x_scale = 1.0)
+        : k_(std::max(order, 0) + 1), center_(x_center), scale_(x_scale),
+          r_(k_ * (k_ + 1), 0.0), buf_(chunk_rows * (k_ + 1)) { }
+
+    int order() const {
+        return static_cast<int>(k_) - 1;
+    }
+
+    /**
+     * @brief 已加入的样本数
+     */
+    size_t count() const {
+        return count_;
+    }
+
+    void add(double x, double y) {
+        double* row = buf_.data() + pending_ * (k_ + 1);
+        const double t = (x - center_) / scale_;
+        double p = 1.0;
+        for (size_t j = 0; j < k_; j++) {
+            row[j] = p;
+            p *= t;
+        }
+        row[k_] = y;
+        count_++;
+        if (++pending_ == chunk_rows) flush();
+    }
+
+    void add(const double* x, const double* y, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            add(x[i], y[i]);
+        }
+    }
+
+    /**
+     * @brief 合并另一个 fitter 的样本, 两者的 order, x_center, x_scale 必须相同
+     */
+    void merge(const PolynomialFitter& other) {
+        // TODO if (other.k_ != k_ || other.center_ != center_ || other.scale_ != scale_) error
+        other.flush();
+        flush();
+        // 对方的 [R | Q^T y] 就是等价的 k 个样本
+        std::vector<double> rows = other.r_;
+        eliminate(rows.data(), k_);
+        rss_ += other.rss_;
+        count_ += other.count_;
+    }
+
+    /**
+     * @brief 残差平方和
+     */
+    double rss() const {
+        flush();
+        return rss_;
+    }
+
+    /**
+     * @brief t 的幂次基下的系数, 低次在前. R 奇异 (不同的样本点不够) 时对应的系数为 0
+     */
+    std::vector<double> scaled_coef() const {
+        flush();
+        std::vector<double> b(k_, 0.0);
+        for (size_t i = k_; i-- > 0; ) {
+            const double* ri = r_.data() + i * (k_ + 1);
+            if (ri[i] == 0.0) continue;
+            double s = ri[k_];
+            for (size_t j = i + 1; j < k_; j++) s -= ri[j] * b[j];
+            b[i] = s / ri[i];
+        }
+        return b;
+    }
+
+    /**
+     * @brief 在 t 的基下直接求拟合值, 不经过 x 的系数, x 的范围很大时更精确
+     */
+    double operator()(double x) const {
+        const std::vector<double> b = scaled_coef();
+        const double t = (x - center_) / scale_;
+        double ret = 0.0;
+        for (size_t j = k_; j-- > 0; ) {
+            ret = ret * t + b[j];
+        }
+        return ret;
+    }
+
+    /**
+     * @brief 拟合结果换回 x 的多项式
+     *
+     * x 的范围很大时高次系数可能非常小, Polynomial 会把绝对值小于 epsilon 的首项当作 0,
+     * 这时应使用 operator() 或 scaled_coef()
+     */
+    Polynomial polynomial() const {
+        const std::vector<double> b = scaled_coef();
+        // Horner: a <- a * (x - c) / s + b_j, a 低次在前
+        std::vector<double> a { b[k_ - 1] };
+        for (size_t j = k_ - 1; j-- > 0; ) {
+            std::vector<double> na(a.size() + 1, 0.0);
+            for (size_t i = 0; i < a.size(); i++) {
+                na[i + 1] += a[i] / scale_;
+                na[i] -= a[i] * center_ / scale_;
+            }
+            na[0] += b[j];
+            a.swap(na);
+        }
+        std::reverse(a.begin(), a.end());
+        return Polynomial(a);
+    }
+
+private:
+    static constexpr size_t chunk_rows = 64;
+
+    size_t k_;
+    double center_;
+    double scale_;
+    // 增广的上三角 [R | Q^T y], k x (k + 1), 行优先
+    mutable std::vector<double> r_;
+    // 还没有消去的样本, 每行 [1, t, ..., t^order, y]
+    mutable std::vector<double> buf_;
+    mutable size_t pending_ {0};
+    mutable double rss_ {0.0};
+    size_t count_ {0};
+
+    // 消去缓冲区里的样本, 缓冲区不影响拟合结果, 所以 const 的查询函数也可以调用
+    void flush() const {
+        if (pending_ == 0) return;
+        eliminate(buf_.data(), pending_);
+        pending_ = 0;
+    }
+
+    // 对 [R; C] 做 Householder QR, C 是 m 行增广样本. 结果写回 R, C 中剩下的右端项是残差
+    void eliminate(double* C, size_t m) const {
+        const size_t w = k_ + 1;
+        for (size_t j = 0; j < k_; j++) {
+            double* rj = r_.data() + j * w;
+            const double alpha = rj[j];
+            double sigma = 0.0;
+            for (size_t i = 0; i < m; i++) sigma += C[i * w + j] * C[i * w + j];
+            if (sigma == 0.0) continue;
+
+            // 反射 H = I - tau v v^T, v = [1; C(:, j) / (alpha - beta)], 把 [alpha; C(:, j)] 变为 [beta; 0]
+            const double norm = std::sqrt(alpha * alpha + sigma);
+            const double beta = alpha > 0 ? -norm : norm;
+            const double tau = (beta - alpha) / beta;
+            const double inv_v0 = 1.0 / (alpha - beta);
+            for (size_t i = 0; i < m; i++) C[i * w + j] *= inv_v0;
+
+            for (size_t l = j + 1; l < w; l++) {
+                double s = rj[l];
+                for (size_t i = 0; i < m; i++) s += C[i * w + j] * C[i * w + l];
+                s *= tau;
+                rj[l] -= s;
+                for (size_t i = 0; i < m; i++) C[i * w + l] -= s * C[i * w + j];
+            }
+            rj[j] = beta;
+        }
+        for (size_t i = 0; i < m; i++) rss_ += C[i * w + k_] * C[i * w + k_];
+    }
+};
+
+inline Polynomial Polynomial::fit(const std::vector<double>& x, const std::vector<double>& y, int order) {
+    // TODO if (x.size() != y.size() || order < 0) error
+    const size_t n = std::min(x.size(), y.size());
+    if (n == 0 || order < 0) return Polynomial();
+
+    // 把 x 缩放到 [-1, 1], 幂次基在这个区间上条件数较好
+    const auto [lo, hi] = std::minmax_element(x.begin(), x.begin() + n);
+    const double center = (*lo + *hi) / 2;
+    const double scale = *hi > *lo ? (*hi - *lo) / 2 : 1.0;
+
+    // 每块独立消去, 再按固定顺序合并, 结果与线程数无关
+    constexpr size_t block = 1 << 16;
+    const size_t nb = (n + block - 1) / block;
+    std::vector<PolynomialFitter> parts(nb, PolynomialFitter(order, center, scale));
+    parallel_for(0, nb, 1, [&](size_t b0, size_t b1) {
+        for (size_t b = b0; b < b1; b++) {
+            const size_t s = b * block;
+            parts[b].add(x.data() + s, y.data() + s, std::min(block, n - s));
+        }
+    });
+    for (size_t b = 1; b < nb; b++) {
+        parts[0].merge(parts[b]);
+    }
+    return parts[0].polynomial();
+}
+
+}
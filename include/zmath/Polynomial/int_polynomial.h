@@ -0,0 +1,467 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <zmath/utils/constant.h>
+#include <zmath/utils/modint.h>
+#include <zmath/utils/ntt.h>
+#include "division.h"
+
+// 系数为整数 (int64_t) 或模 P 整数 (ModInt<P>) 的多项式. 运算都是精确的, 乘法用 NTT,
+// 不会像 double 的 FFT 那样引入舍入误差
+
+namespace zmath {
+
+namespace detail {
+
+// 较短因子的系数个数小于此值时用朴素乘法
+constexpr size_t exact_mul_naive_threshold = 64;
+
+template <uint32_t P>
+std::vector<ModInt<P>> exact_mul(const std::vector<ModInt<P>>& a, const std::vector<ModInt<P>>& b) {
+    if (a.empty() || b.empty()) return {};
+    const size_t len = a.size() + b.size() - 1;
+    if (std::min(a.size(), b.size()) < exact_mul_naive_threshold) {
+        std::vector<ModInt<P>> out(len);
+        for (size_t i = 0; i < a.size(); i++) {
+            for (size_t j = 0; j < b.size(); j++) {
+                out[i + j] += a[i] * b[j];
+            }
+        }
+        return out;
+    }
+
+    size_t n = 1;
+    while (n < len) n *= 2;
+    if (n <= NTTPlan<P>::max_size()) {
+        return ntt_convolve(a.data(), a.size(), b.data(), b.size());
+    }
+
+    // P 不支持这么长的 NTT: 按 [0, P) 中的整数做精确卷积, 再取模.
+    // 结果不超过 len * P^2 < 2^86, 在三素数 CRT 的范围内
+    std::vector<int64_t> ia(a.size()), ib(b.size());
+    for (size_t i = 0; i < a.size(); i++) ia[i] = a[i].value();
+    for (size_t i = 0; i < b.size(); i++) ib[i] = b[i].value();
+    const auto c = crt_convolve(ia.data(), ia.size(), ib.data(), ib.size());
+    std::vector<ModInt<P>> out(len);
+    for (size_t i = 0; i < len; i++) {
+        out[i] = ModInt<P>(static_cast<uint64_t>(c[i] % P));
+    }
+    return out;
+}
+
+// int64_t 的乘法与 C++ 的整数运算一致: 结果溢出 int64_t 时按 2^64 回绕.
+// 只要真实结果的绝对值小于 2.9e25, NTT 路径与朴素乘法给出相同的结果
+inline std::vector<int64_t> exact_mul(const std::vector<int64_t>& a, const std::vector<int64_t>& b) {
+    if (a.empty() || b.empty()) return {};
+    const size_t len = a.size() + b.size() - 1;
+    std::vector<int64_t> out(len);
+    if (std::min(a.size(), b.size()) < exact_mul_naive_threshold) {
+        // 用无符号数运算, 回绕是良定义的
+        std::vector<uint64_t> acc(len, 0);
+        for (size_t i = 0; i < a.size(); i++) {
+            for (size_t j = 0; j < b.size(); j++) {
+                acc[i + j] += static_cast<uint64_t>(a[i]) * static_cast<uint64_t>(b[j]);
+            }
+        }
+        for (size_t i = 0; i < len; i++) out[i] = static_cast<int64_t>(acc[i]);
+        return out;
+    }
+    const auto c = crt_convolve(a.data(), a.size(), b.data(), b.size());
+    for (size_t i = 0; i < len; i++) out[i] = static_cast<int64_t>(c[i]);
+    return out;
+}
+
+struct ExactMul {
+    template <typename T>
+    std::vector<T> operator()(const std::vector<T>& a, const std::vector<T>& b) const {
+        return exact_mul(a, b);
+    }
+};
+
+template <typename T>
+bool is_negative_coef(const T& c) {
+    if constexpr (std::is_signed_v<T>) {
+        return c < 0;
+    } else {
+        return false;
+    }
+}
+
+template <typename T>
+std::string coef_to_string(const T& c) {
+    if constexpr (is_modint_v<T>) {
+        return c.to_string();
+    } else {
+        return std::to_string(c);
+    }
+}
+
+}
+
+/**
+ * @brief 精确系数的多项式, T 是 int64_t 或 ModInt<P>
+ *
+ * 接口与 Polynomial 一致, 系数按高次到低次存储. 系数是精确的, 所以去掉首项的 0 时直接与 0 比较
+ */
+template <typename T>
+class IntPolynomial {
+public:
+    static_assert(std::is_same_v<T, int64_t> || is_modint_v<T>, "T must be int64_t or ModInt<P>");
+
+    IntPolynomial() {
+        coef_.push_back(T(0));
+    }
+
+    /**
+     * @brief 构造一个多项式
+     *
+     * @param coef 多项式的系数. 例如: 多项式是  3x^2 - 2x + 1, 则 coef 是 { 3, -2, 1 }
+     */
+    IntPolynomial(const std::vector<T>& coef) : coef_(coef) {
+        trim();
+    }
+
+    /**
+     * @brief 设置多项式的系数
+     *
+     * @param deg 对应项的次数
+     * @param val 对应项的值
+     */
+    void set_coef(int deg, const T& val) {
+        if (deg < 0) return ;
+        if (deg > this->deg()) return ;
+        coef_[this->deg() - deg] = val;
+        trim();
+    }
+
+    /**
+     * @brief 返回多项式的度, 0 多项式返回 nzinf
+     */
+    int deg() const {
+        if (coef_.size() == 1 && coef_[0] == T(0))
+            return zmath::nzinf;
+        return coef_.size() - 1;
+    }
+
+    /**
+     * @brief 返回多项式的系数
+     */
+    std::vector<T> coef() const {
+        return coef_;
+    }
+
+    /**
+     * @brief 返回多项式的导数
+     */
+    IntPolynomial derivative() const {
+        const int n = deg();
+        if (n < 1) return IntPolynomial();
+
+        std::vector<T> deriv(coef_.begin(), coef_.end() - 1);
+        for (int i = 0; i < n; i++) {
+            deriv[i] *= T(n - i);
+        }
+        return IntPolynomial(deriv);
+    }
+
+    T operator()(const T& x) const {
+        // Horner
+        T ret(0);
+        for (const auto& co : coef_) {
+            ret = ret * x + co;
+        }
+        return ret;
+    }
+
+    IntPolynomial operator+(const IntPolynomial& rhs) const {
+        const std::vector<T>& a = coef_.size() >= rhs.coef_.size() ? coef_ : rhs.coef_;
+        const std::vector<T>& b = coef_.size() >= rhs.coef_.size() ? rhs.coef_ : coef_;
+        std::vector<T> ret = a;
+        const size_t off = a.size() - b.size();
+        for (size_t i = 0; i < b.size(); i++) {
+            ret[off + i] += b[i];
+        }
+        return IntPolynomial(ret);
+    }
+
+    IntPolynomial operator-() const {
+        IntPolynomial ret = *this;
+        for (auto& co : ret.coef_) {
+            co = -co;
+        }
+        return ret;
+    }
+
+    IntPolynomial operator-(const IntPolynomial& rhs) const {
+        return *this + (-rhs);
+    }
+
+    friend IntPolynomial operator*(const T& k, const IntPolynomial& rhs) {
+        return rhs * k;
+    }
+
+    IntPolynomial operator*(const T& k) const {
+        std::vector<T> ret = coef_;
+        for (auto& co : ret) {
+            co *= k;
+        }
+        return IntPolynomial(ret);
+    }
+
+    IntPolynomial operator*(const IntPolynomial& rhs) const {
+        if (deg() == zmath::nzinf || rhs.deg() == zmath::nzinf) {
+            return IntPolynomial();
+        }
+        // 小规模朴素乘法, 否则 NTT (int64_t 用三素数 NTT + 中国剩余定理)
+        return IntPolynomial(detail::exact_mul(coef_, rhs.coef_));
+    }
+
+    /**
+     * @brief 返回首一多项式, 只对 ModInt 系数可用
+     */
+    IntPolynomial monic() const {
+        static_assert(is_modint_v<T>, "monic requires ModInt coefficients");
+        return *this * (T(1) / coef_[0]);
+    }
+
+    /**
+     * @brief 带余除法, 返回 { 商, 余式 }, 只对 ModInt 系数可用
+     *
+     * 规模较大时用 Newton 迭代求逆, 代价与一次 NTT 乘法同阶, 见 division.h. d 是 0 多项式时抛出 std::domain_error
+     */
+    std::pair<IntPolynomial, IntPolynomial> divmod(const IntPolynomial& d) const {
+        static_assert(is_modint_v<T>, "divmod requires ModInt coefficients");
+        if (d.deg() == zmath::nzinf) {
+            throw std::domain_error("zmath: polynomial division by zero");
+        }
+        std::vector<T> p(coef_.rbegin(), coef_.rend()), m(d.coef_.rbegin(), d.coef_.rend()), q, r;
+        detail::poly_divmod(p, m, q, r, detail::ExactMul());
+        std::reverse(q.begin(), q.end());
+        std::reverse(r.begin(), r.end());
+        return { IntPolynomial(q), IntPolynomial(r) };
+    }
+
+    IntPolynomial operator/(const IntPolynomial& rhs) const {
+        return divmod(rhs).first;
+    }
+
+    IntPolynomial operator%(const IntPolynomial& rhs) const {
+        return divmod(rhs).second;
+    }
+
+    /**
+     * @brief (*this)^t mod m, 每一步都取模, 中间结果的度不超过 2 deg m
+     */
+    IntPolynomial pow_mod(size_t t, const IntPolynomial& m) const {
+        IntPolynomial ret = IntPolynomial(std::vector<T>{ T(1) }) % m, a = *this % m;
+        while (t) {
+            if (t & 1)
+                ret = (ret * a) % m;
+            t >>= 1;
+            if (t)
+                a = (a * a) % m;
+        }
+        return ret;
+    }
+
+    /**
+     * @brief 整除 x^k, 即去掉次数低于 k 的项
+     */
+    IntPolynomial shift_down(size_t k) const {
+        if (deg() < static_cast<int>(k)) return IntPolynomial();
+        return IntPolynomial(std::vector<T>(coef_.begin(), coef_.end() - k));
+    }
+
+    IntPolynomial operator^(size_t t) const {
+        IntPolynomial ret(std::vector<T>{ T(1) }), a = *this;
+        while (t) {
+            if (t & 1)
+                ret *= a;
+            t >>= 1;
+            if (t)
+                a *= a;
+        }
+        return ret;
+    }
+
+    bool operator==(const IntPolynomial& rhs) const {
+        return coef_ == rhs.coef_;
+    }
+
+    bool operator!=(const IntPolynomial& rhs) const {
+        return coef_ != rhs.coef_;
+    }
+
+    IntPolynomial& operator+=(const IntPolynomial& rhs) {
+        *this = *this + rhs;
+        return *this;
+    }
+
+    IntPolynomial& operator-=(const IntPolynomial& rhs) {
+        *this = *this - rhs;
+        return *this;
+    }
+
+    IntPolynomial& operator*=(const T& k) {
+        *this = *this * k;
+        return *this;
+    }
+
+    IntPolynomial& operator*=(const IntPolynomial& rhs) {
+        *this = *this * rhs;
+        return *this;
+    }
+
+    IntPolynomial& operator/=(const IntPolynomial& rhs) {
+        *this = *this / rhs;
+        return *this;
+    }
+
+    IntPolynomial& operator%=(const IntPolynomial& rhs) {
+        *this = *this % rhs;
+        return *this;
+    }
+
+    IntPolynomial& operator^=(size_t t) {
+        *this = *this ^ t;
+        return *this;
+    }
+
+    std::string to_string() const {
+        const int n = deg();
+
+        if (n == zmath::nzinf) return "0"; // 0
+        if (n == 0) return detail::coef_to_string(coef_[0]); // 常数
+
+        std::string str = detail::coef_to_string(coef_[0]) + " x^" + std::to_string(n); // 首项
+        for (int i = 1; i <= n; i++) {
+            T current_coef = coef_[i];
+            if (current_coef == T(0))
+                continue;
+
+            if (detail::is_negative_coef(current_coef)) {
+                str += " - ";
+                current_coef = -current_coef;
+            } else {
+                str += " + ";
+            }
+            str += detail::coef_to_string(current_coef);
+            if (i < n - 1) {
+                str += " x^" + std::to_string(n - i);
+            } else if (i == n - 1) {
+                str += " x";
+            }
+        }
+        return str;
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const IntPolynomial& poly) {
+        os << poly.to_string();
+        return os;
+    }
+
+    void print() const {
+        std::cout << *this << std::endl;
+    }
+
+private:
+    std::vector<T> coef_;
+
+    // 去掉前面的 0, 全为 0 时保留一个 0
+    void trim() {
+        auto first_not_zero = std::find_if(coef_.begin(), coef_.end(), [](const T& c) {
+            return c != T(0);
+        });
+        if (first_not_zero == coef_.end()) {
+            coef_.assign(1, T(0));
+        } else {
+            coef_.erase(coef_.begin(), first_not_zero);
+        }
+    }
+};
+
+namespace detail {
+
+// 度不超过此值时 gcd 直接用 Euclid 算法
+constexpr int half_gcd_threshold = 64;
+
+// 2x2 多项式矩阵, 作用在 (a, b) 上
+template <typename T>
+struct PolyMatrix2 {
+    IntPolynomial<T> m00, m01, m10, m11;
+
+    static PolyMatrix2 identity() {
+        const IntPolynomial<T> one(std::vector<T>{ T(1) });
+        return { one, IntPolynomial<T>(), IntPolynomial<T>(), one };
+    }
+
+    PolyMatrix2 operator*(const PolyMatrix2& r) const {
+        return { m00 * r.m00 + m01 * r.m10, m00 * r.m01 + m01 * r.m11,
+                 m10 * r.m00 + m11 * r.m10, m10 * r.m01 + m11 * r.m11 };
+    }
+
+    std::pair<IntPolynomial<T>, IntPolynomial<T>> apply(const IntPolynomial<T>& a, const IntPolynomial<T>& b) const {
+        return { m00 * a + m01 * b, m10 * a + m11 * b };
+    }
+};
+
+// half-GCD: 返回若干步 Euclid 的复合 M, 使 M (a, b) = (c, d), deg c >= m > deg d, m = ceil(deg a / 2).
+// 递归只看高一半的系数, 总代价 O(M(n) log n). 要求 deg a > deg b
+template <typename T>
+PolyMatrix2<T> half_gcd(const IntPolynomial<T>& a, const IntPolynomial<T>& b) {
+    const int m = (a.deg() + 1) / 2;
+    if (a.deg() <= half_gcd_threshold || b.deg() < m) return PolyMatrix2<T>::identity();
+
+    const PolyMatrix2<T> R = half_gcd(a.shift_down(m), b.shift_down(m));
+    auto [c, d] = R.apply(a, b);
+    if (d.deg() < m) return R;
+
+    auto [q, e] = c.divmod(d);
+    const PolyMatrix2<T> Q { IntPolynomial<T>(), IntPolynomial<T>(std::vector<T>{ T(1) }),
+                             IntPolynomial<T>(std::vector<T>{ T(1) }), -q };
+    const int k = std::max(2 * m - d.deg(), 0);
+    const PolyMatrix2<T> S = half_gcd(d.shift_down(k), e.shift_down(k));
+    return S * (Q * R);
+}
+
+}
+
+/**
+ * @brief 首一的最大公因式, 只对 ModInt 系数可用
+ *
+ * 度较大时用 half-GCD, 代价 O(M(n) log n), 否则用 Euclid 算法
+ */
+template <typename T>
+IntPolynomial<T> gcd(IntPolynomial<T> a, IntPolynomial<T> b) {
+    static_assert(is_modint_v<T>, "gcd requires ModInt coefficients");
+    if (a.deg() < b.deg()) std::swap(a, b);
+    while (b.deg() != zmath::nzinf) {
+        if (b.deg() > detail::half_gcd_threshold) {
+            if (a.deg() == b.deg()) {
+                a = a % b;
+                std::swap(a, b);
+                continue;
+            }
+            std::tie(a, b) = detail::half_gcd(a, b).apply(a, b);
+            if (b.deg() == zmath::nzinf) break;
+        }
+        a = a % b;
+        std::swap(a, b);
+    }
+    if (a.deg() == zmath::nzinf) return a;
+    return a.monic();
+}
+
+template <uint32_t P>
+using ModPolynomial = IntPolynomial<ModInt<P>>;
+
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include <zmath/utils/fft.h>
+#include <zmath/utils/memory.h>
+
+// 多项式乘法 (系数的卷积). 卷积与系数的排列方向无关, 高次在前或低次在前都可以直接使用.
+// 按规模选择算法: 朴素 O(nm), Karatsuba O(n^1.585), 实数 FFT O(n log n)
+
+namespace zmath {
+
+enum class PolyMulAlgo {
+    Auto,
+    Naive,
+    Karatsuba,
+    FFT
+};
+
+/**
+ * @brief 自动选择算法时使用的阈值, 按较短一个因子的系数个数比较
+ *
+ * 默认值由 bench polymul 测得, 可以直接修改 poly_mul_thresholds() 覆盖
+ */
+struct PolyMulThresholds {
+    size_t karatsuba = 64; // 不少于此值时使用 Karatsuba, 也是 Karatsuba 递归到朴素乘法的规模
+    size_t fft = 128;      // 不少于此值时使用 FFT
+};
+
+inline PolyMulThresholds& poly_mul_thresholds() {
+    static PolyMulThresholds thresholds;
+    return thresholds;
+}
+
+namespace detail {
+
+// out[0 .. na+nb-1) = a * b
+inline void poly_mul_naive(const double* a, size_t na, const double* b, size_t nb, double* out) {
+    std::fill(out, out + na + nb - 1, 0.0);
+    for (size_t i = 0; i < na; i++) {
+        const double ai = a[i];
+        double* o = out + i;
+        for (size_t j = 0; j < nb; j++) {
+            o[j] += ai * b[j];
+        }
+    }
+}
+
+// 两个长度都为 n 的序列相乘, out 长 2n-1, scratch 至少 4n
+inline void poly_mul_karatsuba_equal(const double* a, const double* b, size_t n,
+                                     double* out, double* scratch, size_t base) {
+    if (n < std::max<size_t>(base, 2)) {
+        poly_mul_naive(a, n, b, n, out);
+        return;
+    }
+    // a = a0 + x^h a1, a0 长 h, a1 长 n - h >= h
+    const size_t h = n / 2, k = n - h;
+    double* sa = scratch;
+    double* sb = sa + k;
+    double* z1 = sb + k;
+    double* rest = z1 + 2 * k - 1;
+
+    for (size_t i = 0; i < k; i++) {
+        sa[i] = a[h + i] + (i < h ? a[i] : 0.0);
+        sb[i] = b[h + i] + (i < h ? b[i] : 0.0);
+    }
+    poly_mul_karatsuba_equal(sa, sb, k, z1, rest, base);
+
+    // z0 = a0 b0 放在 out[0, 2h-1), z2 = a1 b1 放在 out[2h, 2n-1)
+    poly_mul_karatsuba_equal(a, b, h, out, rest, base);
+    out[2 * h - 1] = 0.0;
+    poly_mul_karatsuba_equal(a + h, b + h, k, out + 2 * h, rest, base);
+
+    // z1 - z0 - z2, 加到 out[h, ...)
+    for (size_t i = 0; i < 2 * h - 1; i++) z1[i] -= out[i];
+    for (size_t i = 0; i < 2 * k - 1; i++) z1[i] -= out[2 * h + i];
+    for (size_t i = 0; i < 2 * k - 1; i++) out[h + i] += z1[i];
+}
+
+inline void poly_mul_karatsuba(const double* a, size_t na, const double* b, size_t nb,
+                               double* out, size_t base, Workspace& ws) {
+    if (na < nb) {
+        std::swap(a, b);
+        std::swap(na, nb);
+    }
+    // 长的因子按短的长度分段, 每段与短因子做等长的 Karatsuba
+    Workspace::Scope scope(ws);
+    double* scratch = ws.allocate<double>(4 * nb + 256);
+    double* part = ws.allocate<double>(2 * nb - 1);
+    double* seg = ws.allocate<double>(nb);
+    std::fill(out, out + na + nb - 1, 0.0);
+    for (size_t s = 0; s < na; s += nb) {
+        const size_t len = std::min(nb, na - s);
+        std::fill(seg, seg + nb, 0.0);
+        std::copy(a + s, a + s + len, seg);
+        poly_mul_karatsuba_equal(seg, b, nb, part, scratch, base);
+        const size_t m = std::min(2 * nb - 1, na + nb - 1 - s);
+        for (size_t i = 0; i < m; i++) out[s + i] += part[i];
+    }
+}
+
+inline void poly_mul_fft(const double* a, size_t na, const double* b, size_t nb, double* out, Workspace& ws) {
+    // 实数 FFT 的长度 n = 2m, m 取不小于 new_deg / 2 的最便宜的 FFT 长度,
+    // 不必像基 2 FFT 那样补齐到 2^t
+    const size_t new_deg = na + nb - 1;
+    const size_t n = 2 * cheapest_fft_size((new_deg + 1) / 2);
+
+    // 实数 FFT 只需要 n/2 + 1 个复数, 计算量和内存都是复数 FFT 的一半
+    auto plan = rfft_plan(n);
+    Workspace::Scope scope(ws);
+    double* buf = ws.allocate<double>(n);
+    complex* c1 = ws.allocate<complex>(n / 2 + 1);
+    complex* c2 = ws.allocate<complex>(n / 2 + 1);
+    std::fill(buf, buf + n, 0.0);
+    std::copy(a, a + na, buf);
+    plan->forward(buf, c1);
+    std::fill(buf, buf + n, 0.0);
+    std::copy(b, b + nb, buf);
+    plan->forward(buf, c2);
+    for (size_t i = 0; i < n / 2 + 1; i++) {
+        c1[i] = cmul(c1[i], c2[i]);
+    }
+    plan->inverse(c1, buf);
+    std::copy(buf, buf + new_deg, out);
+}
+
+}
+
+/**
+ * @brief 返回 Auto 时会使用的算法
+ */
+inline PolyMulAlgo poly_mul_select(size_t na, size_t nb) {
+    const auto& t = poly_mul_thresholds();
+    const size_t m = std::min(na, nb);
+    if (m >= t.fft) return PolyMulAlgo::FFT;
+    if (m >= t.karatsuba) return PolyMulAlgo::Karatsuba;
+    return PolyMulAlgo::Naive;
+}
+
+/**
+ * @brief 计算两个系数序列的卷积, 临时存储从 ws 中切出. ws 的容量足够后不分配内存
+ *
+ * @param out 长度至少为 na + nb - 1
+ */
+inline void poly_mul(const double* a, size_t na, const double* b, size_t nb, double* out,
+                     Workspace& ws, PolyMulAlgo algo = PolyMulAlgo::Auto) {
+    if (na == 0 || nb == 0) return;
+    if (algo == PolyMulAlgo::Auto) algo = poly_mul_select(na, nb);
+    switch (algo) {
+    case PolyMulAlgo::FFT:
+        detail::poly_mul_fft(a, na, b, nb, out, ws);
+        break;
+    case PolyMulAlgo::Karatsuba:
+        detail::poly_mul_karatsuba(a, na, b, nb, out, poly_mul_thresholds().karatsuba, ws);
+        break;
+    default:
+        detail::poly_mul_naive(a, na, b, nb, out);
+        break;
+    }
+}
+
+/**
+ * @brief 计算两个系数序列的卷积, 临时数组取自调用线程的工作区
+ *
+ * @param out 长度至少为 na + nb - 1
+ */
+inline void poly_mul(const double* a, size_t na, const double* b, size_t nb, double* out,
+                     PolyMulAlgo algo = PolyMulAlgo::Auto) {
+    poly_mul(a, na, b, nb, out, detail::thread_workspace(), algo);
+}
+
+inline std::vector<double> poly_mul(const std::vector<double>& a, const std::vector<double>& b,
+                                    PolyMulAlgo algo = PolyMulAlgo::Auto) {
+    if (a.empty() || b.empty()) return {};
+    std::vector<double> out(a.size() + b.size() - 1);
+    poly_mul(a.data(), a.size(), b.data(), b.size(), out.data(), algo);
+    return out;
+}
+
+}
@@ -1,11 +1,16 @@
 #pragma once
 
 #include <iostream>
+#include <stdexcept>
 #include <vector>
 #include <float.h>
 #include <algorithm>
+#include <utility>
 
 #include <zmath/utils/fft.h>
+#include "multiply.h"
+#include "division.h"
+#include "evaluate.h"
 
 namespace zmath {
 
@@ -133,16 +138,31 @@ public:
     }
 
     double operator()(double x) const {
+        // Horner
         double ret = 0.0;
-        const int n = coef_.size();
-        double pow = 1.0;
-        for (int i = n - 1; i >= 0; i--) {
-            ret += pow * coef_[i];
-            pow *= x;
+        for (const auto& co : coef_) {
+            ret = ret * x + co;
         }
         return ret;
     }
 
+    /**
+     * @brief 在多个点上求值, 大量点时应优先使用它而不是逐点调用 operator()
+     *
+     * @param xs 点, 长度为 n
+     * @param out 结果, 长度至少为 n
+     * @param mode 求值算法, 见 evaluate.h
+     */
+    void evaluate(const double* xs, size_t n, double* out, PolyEvalMode mode = PolyEvalMode::Auto) const {
+        poly_eval(coef_.data(), coef_.size(), xs, n, out, mode);
+    }
+
+    std::vector<double> evaluate(const std::vector<double>& xs, PolyEvalMode mode = PolyEvalMode::Auto) const {
+        std::vector<double> out(xs.size());
+        evaluate(xs.data(), xs.size(), out.data(), mode);
+        return out;
+    }
+
     Polynomial operator+(const Polynomial& rhs) const {
         int deg = std::max(this->deg(), rhs.deg());
         std::vector<double> ret_coef; // 逆序的相加结果系数
@@ -191,42 +211,45 @@ public:
     }
 
     Polynomial operator*(const Polynomial& rhs) const {
-        // 计算 n=2^t 使得 n >= new_deg  刚好是2^t是因为fft.h里的fft只能运行于2^t次单位根群上
-        int new_deg = deg() + rhs.deg() + 1;
-        int n = 1;
-        while (n < new_deg) {
-            n *= 2;
+        if (deg() == zmath::nzinf || rhs.deg() == zmath::nzinf) {
+            return Polynomial({0});
         }
 
-        // 将系数反转, 同时增长到n
-        std::vector<double> coef1 = this->coef_;
-        std::vector<double> coef2 = rhs.coef_;
-        std::reverse(coef1.begin(), coef1.end()); 
-        std::reverse(coef2.begin(), coef2.end());
-        while (coef1.size() < n)
-            coef1.push_back(0);
-        while (coef2.size() < n)
-            coef2.push_back(0);
-
-        // 将系数转为 complex array, 进行 fft
-        complex_array c1(n), c2(n);
-        for (int i = 0; i < n; i++) {
-            c1[i] = complex(coef1[i]);
-            c2[i] = complex(coef2[i]);
-        }
-        fft(c1); fft(c2);
-        for (int i = 0; i < n; i++) {
-            c1[i] = c1[i] * c2[i];
-        }
-        ifft(c1);
+        // 按规模选择朴素乘法, Karatsuba 或 FFT, 见 multiply.h
+        return Polynomial(poly_mul(coef_, rhs.coef_));
+    }
 
-        // 转化为结果多项式的系数的vector
-        std::vector<double> ret_coef(c1.size());
-        for (int i = 0; i < n; i++) {
-            ret_coef[i] = c1[n - 1 - i].real();
+    /**
+     * @brief 全部复根 (计重数), 用 Aberth-Ehrlich 迭代, 定义在 roots.h
+     *
+     * @param max_iter 最大迭代次数
+     */
+    std::vector<complex> roots(size_t max_iter = 100) const;
+
+    /**
+     * @brief 带余除法, 返回 { 商, 余式 }, 满足 *this = 商 * d + 余式, deg 余式 < deg d
+     *
+     * 规模较大时用 Newton 迭代求逆, 代价与一次 FFT 乘法同阶. 除式的条件数很差时 FFT 的舍入误差会被放大,
+     * 这时检查到 Newton 的结果不可信, 改用长除法 (代价 O(deg 商 * deg d)), 见 division.h.
+     * d 是 0 多项式时抛出 std::domain_error
+     */
+    std::pair<Polynomial, Polynomial> divmod(const Polynomial& d) const {
+        if (d.deg() == zmath::nzinf) {
+            throw std::domain_error("zmath: polynomial division by zero");
         }
+        std::vector<double> p(coef_.rbegin(), coef_.rend()), m(d.coef_.rbegin(), d.coef_.rend()), q, r;
+        detail::poly_divmod(p, m, q, r, detail::PolyMulDouble());
+        std::reverse(q.begin(), q.end());
+        std::reverse(r.begin(), r.end());
+        return { Polynomial(q), Polynomial(r) };
+    }
 
-        return Polynomial(ret_coef);
+    Polynomial operator/(const Polynomial& rhs) const {
+        return divmod(rhs).first;
+    }
+
+    Polynomial operator%(const Polynomial& rhs) const {
+        return divmod(rhs).second;
     }
 
     Polynomial operator^(size_t t) const {
@@ -265,6 +288,31 @@ public:
         return *this;
     }
 
+    Polynomial& operator/=(const Polynomial& rhs) {
+        *this = *this / rhs;
+        return *this;
+    }
+
+    Polynomial& operator%=(const Polynomial& rhs) {
+        *this = *this % rhs;
+        return *this;
+    }
+
+    /**
+     * @brief (*this)^t mod m, 每一步都取模, 中间结果的度不超过 2 deg m
+     */
+    Polynomial pow_mod(size_t t, const Polynomial& m) const {
+        Polynomial ret = Polynomial(std::vector<double>{ 1 }) % m, a = *this % m;
+        while (t) {
+            if (t & 1)
+                ret = (ret * a) % m;
+            t >>= 1;
+            if (t)
+                a = (a * a) % m;
+        }
+        return ret;
+    }
+
     Polynomial& operator^=(double t) {
         *this = *this^t;
         return *this;
@@ -329,9 +377,10 @@ public:
         std::cout << *this << std::endl;
     }
 
-    // TODO: 最小二乘法需要解线性方程组, 等linalg写完再回来补
     /**
-     * @brief 最小二乘法拟合多项式
+     * @brief 最小二乘法拟合多项式, 用 Householder QR 求解, 定义在 fit.h
+     *
+     * 样本不能一次放进内存时使用 PolynomialFitter
      * @param x 横坐标
      * @param y 纵坐标
      * @param order 拟合的多项式的度
@@ -343,4 +392,26 @@ private:
     std::vector<double> coef_;
 };
 
+/**
+ * @brief 首一的最大公因式, 用 Euclid 算法
+ *
+ * 系数是浮点数, 每一步余式中绝对值不超过 tol 倍被除式最大系数的项视为 0.
+ * 浮点数上的 half-GCD 依赖精确的降次, 没有意义, 精确系数的 half-GCD 见 IntPolynomial
+ */
+inline Polynomial gcd(Polynomial a, Polynomial b, double tol = 1e-9) {
+    if (a.deg() < b.deg()) std::swap(a, b);
+    while (b.deg() != zmath::nzinf) {
+        b = b.monic();
+        double scale = 0.0;
+        for (auto c : a.coef()) scale = std::max(scale, std::abs(c));
+        auto r = (a % b).coef();
+        for (auto& c : r) {
+            if (std::abs(c) <= tol * scale) c = 0;
+        }
+        a = std::move(b);
+        b = Polynomial(r);
+    }
+    return a.monic();
+}
+
 }
\ No newline at end of file
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <zmath/utils/constant.h>
+#include <zmath/utils/fft.h>
+#include <zmath/utils/thread_pool.h>
+#include "polynomial.h"
+
+// 多项式的全部复根, 用 Aberth-Ehrlich 同时迭代: 所有根一起更新, 三阶收敛, 不需要逐个收缩 (deflation).
+// 根按实部/虚部分开存放 (SoA), Horner 和 Aberth 求和的内层循环都沿着根的方向, 可以自动向量化
+
+namespace zmath {
+
+namespace detail {
+
+// 一次处理的根的个数, Horner 的累加器放在栈上
+constexpr size_t aberth_chunk = 64;
+
+// 初值: 以 0 为圆心, 半径 max |a_i / a_0|^(1/i) 的圆上均匀分布, 加一个偏角打破对称
+inline void aberth_init(const double* a, size_t n, double* zr, double* zi) {
+    double r = 0.0;
+    for (size_t i = 1; i <= n; i++) {
+        r = std::max(r, std::pow(std::abs(a[i] / a[0]), 1.0 / i));
+    }
+    if (r == 0.0) r = 1.0;
+    for (size_t k = 0; k < n; k++) {
+        const double t = 2 * pi * k / n + 0.4;
+        zr[k] = r * std::cos(t);
+        zi[k] = r * std::sin(t);
+    }
+}
+
+// 第 [lo, hi) 个根的修正量 w = N / (1 - N sum_j 1 / (z_k - z_j)), N = p / p'.
+// 已收敛 (|p(z)| 不超过舍入误差的界) 的根修正量为 0, 并记入 done
+inline void aberth_corrections(const double* a, size_t n, const double* zr, const double* zi,
+                               size_t lo, size_t hi, double* wr, double* wi, unsigned char* done) {
+    constexpr double eps = 4 * std::numeric_limits<double>::epsilon();
+    for (size_t c0 = lo; c0 < hi; c0 += aberth_chunk) {
+        const size_t m = std::min(aberth_chunk, hi - c0);
+        const double* xr = zr + c0;
+        const double* xi = zi + c0;
+        double pr[aberth_chunk], pi_[aberth_chunk], dr[aberth_chunk], di[aberth_chunk];
+        double az[aberth_chunk], bound[aberth_chunk];
+        for (size_t k = 0; k < m; k++) {
+            pr[k] = a[0];
+            pi_[k] = 0.0;
+            dr[k] = di[k] = 0.0;
+            az[k] = std::sqrt(xr[k] * xr[k] + xi[k] * xi[k]);
+            bound[k] = std::abs(a[0]);
+        }
+        // p' <- p' z + p, p <- p z + a_i, bound <- bound |z| + |a_i|
+        for (size_t i = 1; i <= n; i++) {
+            const double ai = a[i], abs_ai = std::abs(ai);
+            for (size_t k = 0; k < m; k++) {
+                const double ndr = dr[k] * xr[k] - di[k] * xi[k] + pr[k];
+                const double ndi = dr[k] * xi[k] + di[k] * xr[k] + pi_[k];
+                const double npr = pr[k] * xr[k] - pi_[k] * xi[k] + ai;
+                const double npi = pr[k] * xi[k] + pi_[k] * xr[k];
+                dr[k] = ndr;
+                di[k] = ndi;
+                pr[k] = npr;
+                pi_[k] = npi;
+                bound[k] = bound[k] * az[k] + abs_ai;
+            }
+        }
+
+        for (size_t k = 0; k < m; k++) {
+            const size_t g = c0 + k;
+            wr[g] = wi[g] = 0.0;
+            if (std::sqrt(pr[k] * pr[k] + pi_[k] * pi_[k]) <= eps * bound[k]) {
+                done[g] = 1;
+                continue;
+            }
+            done[g] = 0;
+            const double dd = dr[k] * dr[k] + di[k] * di[k];
+            if (dd == 0.0) continue;
+            // N = p / p'
+            const double nr = (pr[k] * dr[k] + pi_[k] * di[k]) / dd;
+            const double ni = (pi_[k] * dr[k] - pr[k] * di[k]) / dd;
+
+            // s = sum_{j != g} 1 / (z_g - z_j), 分成 j < g 和 j > g 两段, 避免循环内的分支
+            double sr = 0.0, si = 0.0;
+            const double gr = zr[g], gi = zi[g];
+            for (size_t j = 0; j < g; j++) {
+                const double ur = gr - zr[j], ui = gi - zi[j];
+                const double inv = 1.0 / (ur * ur + ui * ui);
+                sr += ur * inv;
+                si -= ui * inv;
+            }
+            for (size_t j = g + 1; j < n; j++) {
+                const double ur = gr - zr[j], ui = gi - zi[j];
+                const double inv = 1.0 / (ur * ur + ui * ui);
+                sr += ur * inv;
+                si -= ui * inv;
+            }
+
+            // w = N / (1 - N s)
+            const double er = 1.0 - (nr * sr - ni * si);
+            const double ei = -(nr * si + ni * sr);
+            const double ee = er * er + ei * ei;
+            wr[g] = (nr * er + ni * ei) / ee;
+            wi[g] = (ni * er - nr * ei) / ee;
+        }
+    }
+}
+
+// a[0, n] 高次在前, a[0] != 0, a[n] != 0. 结果写入 out[0, n), 返回迭代次数
+inline size_t aberth_solve(const double* a, size_t n, complex* out, size_t max_iter, bool parallel) {
+    std::vector<double> zr(n), zi(n), wr(n), wi(n);
+    std::vector<unsigned char> done(n, 0);
+    aberth_init(a, n, zr.data(), zi.data());
+    // 每个根的代价是 O(n), 每块至少约 2^14 次运算
+    const size_t grain = std::max<size_t>(aberth_chunk, (size_t(1) << 14) / n);
+
+    size_t it = 0;
+    for (; it < max_iter; it++) {
+        if (parallel) {
+            parallel_for(0, n, grain, [&](size_t lo, size_t hi) {
+                aberth_corrections(a, n, zr.data(), zi.data(), lo, hi, wr.data(), wi.data(), done.data());
+            });
+        } else {
+            aberth_corrections(a, n, zr.data(), zi.data(), 0, n, wr.data(), wi.data(), done.data());
+        }
+        // Jacobi 式更新: 所有修正量都用旧的 z 计算, 各根之间没有依赖
+        bool all_done = true;
+        for (size_t k = 0; k < n; k++) {
+            zr[k] -= wr[k];
+            zi[k] -= wi[k];
+            all_done = all_done && done[k];
+        }
+        if (all_done) break;
+    }
+    for (size_t k = 0; k < n; k++) {
+        out[k] = complex(zr[k], zi[k]);
+    }
+    return it;
+}
+
+// 去掉首项的 0 和 0 根后求解, out 长度为 nc - 1
+inline void poly_roots_impl(const double* coef, size_t nc, complex* out, size_t max_iter, bool parallel) {
+    size_t first = 0;
+    while (first + 1 < nc && coef[first] == 0.0) first++;
+    size_t last = nc;
+    while (last > first + 1 && coef[last - 1] == 0.0) last--;
+    const size_t n = last - first - 1;
+    if (n > 0) aberth_solve(coef + first, n, out, max_iter, parallel);
+    // 末尾的 0 系数对应 0 根, 首项的 0 系数对应无穷远处的根
+    for (size_t k = n; k < n + (nc - last); k++) {
+        out[k] = complex(0.0, 0.0);
+    }
+    for (size_t k = n + (nc - last); k + 1 < nc; k++) {
+        out[k] = complex(inf, 0.0);
+    }
+}
+
+}
+
+/**
+ * @brief 多项式的全部复根 (计重数)
+ *
+ * @param coef 系数, 高次在前, 共 nc 个
+ * @param out 长度为 nc - 1. 首项系数为 0 时, 降掉的次数对应的根为 inf
+ * @param max_iter Aberth 迭代的最大次数
+ */
+inline void poly_roots(const double* coef, size_t nc, complex* out, size_t max_iter = 100) {
+    if (nc < 2) return;
+    detail::poly_roots_impl(coef, nc, out, max_iter, true);
+}
+
+/**
+ * @brief 同时求 count 个同次多项式的全部根, 多项式之间并行
+ *
+ * @param coefs count 个多项式的系数依次排列, 每个 nc 个, 高次在前
+ * @param out count * (nc - 1) 个根, 第 i 个多项式的根在 out[i * (nc - 1), (i + 1) * (nc - 1))
+ */
+inline void poly_roots_batch(const double* coefs, size_t count, size_t nc, complex* out, size_t max_iter = 100) {
+    if (nc < 2) return;
+    const size_t n = nc - 1;
+    parallel_for(0, count, std::max<size_t>(1, 4096 / (n * n)), [=](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; i++) {
+            detail::poly_roots_impl(coefs + i * nc, nc, out + i * n, max_iter, false);
+        }
+    });
+}
+
+inline std::vector<complex> Polynomial::roots(size_t max_iter) const {
+    if (deg() < 1) return {};
+    std::vector<complex> ret(coef_.size() - 1);
+    poly_roots(coef_.data(), coef_.size(), ret.data(), max_iter);
+    return ret;
+}
+
+}
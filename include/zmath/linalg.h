@@ -1,5 +1,15 @@
 #pragma once
 
 #include "Linalg/linalg.h"
+#include "Linalg/gemm.h"
+#include "Linalg/triangular.h"
+#include "Linalg/lu.h"
+#include "Linalg/cholesky.h"
+#include "Linalg/eigen.h"
+#include "Linalg/sparse.h"
+#include "Linalg/krylov.h"
+#include "Linalg/fixed.h"
 #include "Linalg/vec2.h"
 #include "Linalg/vec3.h"
+#include "Linalg/vec3_batch.h"
+#include "Linalg/transform.h"
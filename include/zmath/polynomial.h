@@ -1,3 +1,6 @@
 #pragma once
 
 #include "Polynomial/polynomial.h"
+#include "Polynomial/roots.h"
+#include "Polynomial/fit.h"
+#include "Polynomial/int_polynomial.h"
@@ -1,4 +1,9 @@
 #pragma once
 
 #include "utils/constant.h"
+#include "utils/memory.h"
+#include "utils/simd.h"
+#include "utils/thread_pool.h"
 #include "utils/fft.h"
+#include "utils/modint.h"
+#include "utils/ntt.h"
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cmath>
 #include <limits>
 
 namespace zmath {
@@ -14,7 +15,7 @@ const int zinf = std::numeric_limits<int>::max(); // z 代表 整数Z
 
 const int nzinf = std::numeric_limits<int>::min();
 
-const double pi = 3.14159265358979323846;
+constexpr double pi = 3.14159265358979323846;
 
 const double exp = 2.71828182845904523536;
 
@@ -1,7 +1,15 @@
 #pragma once
+#include <algorithm>
 #include <complex>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <valarray>
+#include <vector>
 #include <zmath/utils/constant.h>
+#include <zmath/utils/memory.h>
+#include <zmath/utils/simd.h>
 
 // fft 用于计算多项式乘积
 
@@ -11,34 +19,649 @@ using complex = std::complex<double>;
 using complex_array = std::valarray<complex>;
 using zmath::pi;
 
+namespace detail {
+
+// 不处理 inf / NaN 的复数乘法, 避免 std::complex 乘法里的特殊值检查
+inline complex cmul(const complex& a, const complex& b) {
+    return complex(a.real() * b.real() - a.imag() * b.imag(),
+                   a.real() * b.imag() + a.imag() * b.real());
+}
+
+// 一层蝶形运算: 对每个长为 2h 的块, (a, b) -> (a + w b, a - w b)
+inline void fft_butterfly_scalar(complex* data, size_t n, size_t h, const complex* w) {
+    double* d = reinterpret_cast<double*>(data);
+    const double* t = reinterpret_cast<const double*>(w);
+    for (size_t s = 0; s < n; s += 2 * h) {
+        double* a = d + 2 * s;
+        double* b = a + 2 * h;
+        for (size_t k = 0; k < h; k++) {
+            const double wr = t[2 * k], wi = t[2 * k + 1];
+            const double br = b[2 * k], bi = b[2 * k + 1];
+            const double xr = br * wr - bi * wi;
+            const double xi = br * wi + bi * wr;
+            const double ar = a[2 * k], ai = a[2 * k + 1];
+            a[2 * k] = ar + xr;
+            a[2 * k + 1] = ai + xi;
+            b[2 * k] = ar - xr;
+            b[2 * k + 1] = ai - xi;
+        }
+    }
+}
+
+#ifdef ZMATH_X86_SIMD
+// 每个 __m256d 装两个复数, 复数乘法用 fmaddsub 完成
+__attribute__((target("avx2,fma")))
+inline void fft_butterfly_avx2(complex* data, size_t n, size_t h, const complex* w) {
+    double* d = reinterpret_cast<double*>(data);
+    const double* t = reinterpret_cast<const double*>(w);
+    for (size_t s = 0; s < n; s += 2 * h) {
+        double* a = d + 2 * s;
+        double* b = a + 2 * h;
+        for (size_t k = 0; k < 2 * h; k += 4) {
+            const __m256d vw = _mm256_loadu_pd(t + k);
+            const __m256d vb = _mm256_loadu_pd(b + k);
+            const __m256d wr = _mm256_movedup_pd(vw);
+            const __m256d wi = _mm256_permute_pd(vw, 0xF);
+            const __m256d bs = _mm256_permute_pd(vb, 0x5);
+            const __m256d x = _mm256_fmaddsub_pd(vb, wr, _mm256_mul_pd(bs, wi));
+            const __m256d va = _mm256_loadu_pd(a + k);
+            _mm256_storeu_pd(a + k, _mm256_add_pd(va, x));
+            _mm256_storeu_pd(b + k, _mm256_sub_pd(va, x));
+        }
+    }
+}
+#endif
+
+}
+
+namespace detail {
+
+/**
+ * @brief 按长度缓存的只读计划, 每种计划类型各有一个缓存, 同一长度只构造一次. 线程安全
+ */
+template <typename Plan>
+std::shared_ptr<const Plan> cached_plan(size_t n) {
+    static std::mutex mutex;
+    static std::unordered_map<size_t, std::shared_ptr<const Plan>> cache;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& plan = cache[n];
+    if (!plan) plan = std::make_shared<const Plan>(n);
+    return plan;
+}
+
+/**
+ * @brief 长度为 2^t 的位反转置换表, FFT 和 NTT 共用
+ */
+struct BitReverseTable {
+    explicit BitReverseTable(size_t n) : perm(n) {
+        size_t bits = 0;
+        while ((size_t(1) << bits) < n) bits++;
+        for (size_t i = 0; i < n; i++) {
+            size_t r = 0;
+            for (size_t b = 0; b < bits; b++) {
+                if (i & (size_t(1) << b)) r |= size_t(1) << (bits - 1 - b);
+            }
+            perm[i] = static_cast<uint32_t>(r);
+        }
+    }
+
+    template <typename T>
+    void apply(T* data) const {
+        for (size_t i = 0; i < perm.size(); i++) {
+            const size_t j = perm[i];
+            if (i < j) std::swap(data[i], data[j]);
+        }
+    }
+
+    std::vector<uint32_t> perm;
+};
+
+}
+
+/**
+ * @brief 返回不小于 n 的最小的 2^a 3^b 5^c 7^d, 这些长度可以直接用混合基 FFT 计算
+ */
+inline size_t good_fft_size(size_t n) {
+    if (n <= 1) return 1;
+    size_t best = 1;
+    while (best < n) best *= 2;
+    for (size_t p7 = 1; p7 < best; p7 *= 7) {
+        for (size_t p5 = p7; p5 < best; p5 *= 5) {
+            for (size_t p3 = p5; p3 < best; p3 *= 3) {
+                size_t m = p3;
+                while (m < n) m *= 2;
+                best = std::min(best, m);
+            }
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief 返回不小于 n 且估计耗时最少的 FFT 长度 (2^t 或 2^a 3^b 5^c 7^d)
+ *
+ * 按 n log n 估计, 实测混合基每 n log n 比原地基 2 慢约 25%
+ */
+inline size_t cheapest_fft_size(size_t n) {
+    size_t pow2 = 1;
+    while (pow2 < n) pow2 *= 2;
+    const size_t smooth = good_fft_size(n);
+    if (smooth == pow2) return pow2;
+    auto cost = [](size_t m, double factor) {
+        return factor * double(m) * std::log2(double(m));
+    };
+    return cost(smooth, 1.25) < cost(pow2, 1.0) ? smooth : pow2;
+}
+
+namespace detail {
+
+// Stockham 自排序 FFT 的基 p 蝶形: 读 in[s q] (q < p), 乘旋转因子 w[q-1] 后做 p 点 DFT, 写 out[step k].
+// 奇数基利用 W^j 与 W^(p-j) 共轭, 每对输入只需 (p-1)/2 次实数乘加: cs[k][j] = (cos, sin)(2 pi jk / p)
+template <size_t p>
+inline void fft_stockham_butterfly(const complex* in, complex* out, size_t s, size_t step,
+                                   const complex* w, const double (*cs)[4][2]) {
+    complex a[p];
+    a[0] = in[0];
+    for (size_t q = 1; q < p; q++) a[q] = cmul(in[s * q], w[q - 1]);
+    if constexpr (p == 2) {
+        out[0] = a[0] + a[1];
+        out[step] = a[0] - a[1];
+    } else if constexpr (p == 4) {
+        const complex t0 = a[0] + a[2], t1 = a[0] - a[2];
+        const complex t2 = a[1] + a[3], t3 = a[1] - a[3];
+        const complex t3i(t3.imag(), -t3.real()); // -i * t3
+        out[0] = t0 + t2;
+        out[step] = t1 + t3i;
+        out[2 * step] = t0 - t2;
+        out[3 * step] = t1 - t3i;
+    } else {
+        constexpr size_t h = p / 2;
+        complex b[h], d[h];
+        complex y0 = a[0];
+        for (size_t j = 1; j <= h; j++) {
+            b[j - 1] = a[j] + a[p - j];
+            d[j - 1] = a[j] - a[p - j];
+            y0 += b[j - 1];
+        }
+        out[0] = y0;
+        for (size_t k = 1; k <= h; k++) {
+            double tr = a[0].real(), ti = a[0].imag(), ur = 0.0, ui = 0.0;
+            for (size_t j = 0; j < h; j++) {
+                const double c = cs[k][j][0], sn = cs[k][j][1];
+                tr += c * b[j].real();
+                ti += c * b[j].imag();
+                ur += sn * d[j].real();
+                ui += sn * d[j].imag();
+            }
+            // y[k] = t - i u, y[p-k] = t + i u
+            out[k * step] = complex(tr + ui, ti - ur);
+            out[(p - k) * step] = complex(tr - ui, ti + ur);
+        }
+    }
+}
+
+#ifdef ZMATH_X86_SIMD
+__attribute__((target("avx2,fma")))
+inline __m256d load2(const complex* c) {
+    return _mm256_loadu_pd(reinterpret_cast<const double*>(c));
+}
+
+__attribute__((target("avx2,fma")))
+inline void store2(complex* c, __m256d v) {
+    _mm256_storeu_pd(reinterpret_cast<double*>(c), v);
+}
+
+// -i * v
+__attribute__((target("avx2,fma")))
+inline __m256d mul_neg_i(__m256d v) {
+    return _mm256_xor_pd(_mm256_permute_pd(v, 0x5), _mm256_set_pd(-0.0, 0.0, -0.0, 0.0));
+}
+
+// 同上, 一次处理相邻的两个 r (两个复数装在一个 __m256d 里)
+template <size_t p>
+__attribute__((target("avx2,fma")))
+inline void fft_stockham_butterfly_avx2(const complex* in, complex* out, size_t s, size_t step,
+                                        const complex* w, const double (*cs)[4][2]) {
+    __m256d a[p];
+    a[0] = load2(in);
+    for (size_t q = 1; q < p; q++) {
+        const __m256d x = load2(in + s * q);
+        const __m256d wr = _mm256_set1_pd(w[q - 1].real());
+        const __m256d wi = _mm256_set1_pd(w[q - 1].imag());
+        a[q] = _mm256_fmaddsub_pd(x, wr, _mm256_mul_pd(_mm256_permute_pd(x, 0x5), wi));
+    }
+    if constexpr (p == 2) {
+        store2(out, _mm256_add_pd(a[0], a[1]));
+        store2(out + step, _mm256_sub_pd(a[0], a[1]));
+    } else if constexpr (p == 4) {
+        const __m256d t0 = _mm256_add_pd(a[0], a[2]), t1 = _mm256_sub_pd(a[0], a[2]);
+        const __m256d t2 = _mm256_add_pd(a[1], a[3]);
+        const __m256d t3i = mul_neg_i(_mm256_sub_pd(a[1], a[3]));
+        store2(out, _mm256_add_pd(t0, t2));
+        store2(out + step, _mm256_add_pd(t1, t3i));
+        store2(out + 2 * step, _mm256_sub_pd(t0, t2));
+        store2(out + 3 * step, _mm256_sub_pd(t1, t3i));
+    } else {
+        constexpr size_t h = p / 2;
+        __m256d b[h], d[h];
+        __m256d y0 = a[0];
+        for (size_t j = 1; j <= h; j++) {
+            b[j - 1] = _mm256_add_pd(a[j], a[p - j]);
+            d[j - 1] = _mm256_sub_pd(a[j], a[p - j]);
+            y0 = _mm256_add_pd(y0, b[j - 1]);
+        }
+        store2(out, y0);
+        for (size_t k = 1; k <= h; k++) {
+            __m256d t = a[0], u = _mm256_setzero_pd();
+            for (size_t j = 0; j < h; j++) {
+                t = _mm256_fmadd_pd(_mm256_set1_pd(cs[k][j][0]), b[j], t);
+                u = _mm256_fmadd_pd(_mm256_set1_pd(cs[k][j][1]), d[j], u);
+            }
+            const __m256d iu = mul_neg_i(u);
+            store2(out + k * step, _mm256_add_pd(t, iu));
+            store2(out + (p - k) * step, _mm256_sub_pd(t, iu));
+        }
+    }
+}
+#endif
+
+// Stockham 自排序 FFT 的一层, 基为 p.
+// 输入中长度为 len, 步长为 S 的 S 个子序列的 DFT 按 x[r + S k] 存放,
+// 合并成 S / p 个长度为 len * p 的子序列的 DFT, 按同样的方式存到 y. 最内层循环沿 r 连续访问
+template <size_t p>
+void fft_stockham_stage(const complex* x, complex* y, size_t n, size_t len,
+                        const complex* tw, const double (*cs)[4][2]) {
+    const size_t S = n / len;
+    const size_t s = S / p;
+    const size_t step = s * len; // 输出中相邻 k 的距离
+#ifdef ZMATH_X86_SIMD
+    const bool avx2 = cpu_simd_level() >= SimdLevel::AVX2;
+#endif
+    for (size_t k1 = 0; k1 < len; k1++) {
+        const complex* w = tw + k1 * (p - 1);
+        const complex* in = x + S * k1;
+        complex* out = y + s * k1;
+        size_t r = 0;
+#ifdef ZMATH_X86_SIMD
+        if (avx2) {
+            for (; r + 2 <= s; r += 2) {
+                fft_stockham_butterfly_avx2<p>(in + r, out + r, s, step, w, cs);
+            }
+        }
+#endif
+        for (; r < s; r++) {
+            fft_stockham_butterfly<p>(in + r, out + r, s, step, w, cs);
+        }
+    }
+}
+
+}
+
+/**
+ * @brief 长度为 n 的 FFT 计划
+ *
+ * 构造时预先计算位反转表和每一层的旋转因子, 之后的变换原地, 迭代进行, 不再分配内存或计算三角函数.
+ * 按长度选择算法:
+ *   - 2^t: 原地迭代的基 2 FFT
+ *   - 2^a 3^b 5^c 7^d: Stockham 自排序的混合基 (4/2/3/5/7) FFT, 需要一个长为 n 的线程私有缓冲区
+ *   - 其他长度: Bluestein 算法, 转化为长度为 2 的幂的循环卷积
+ * 计划构造后只读, 可以被多个线程同时使用
+ */
+class FFTPlan {
+public:
+    enum class Kind {
+        Radix2,
+        MixedRadix,
+        Bluestein
+    };
+
+    explicit FFTPlan(size_t n) : n_(n) {
+        if ((n & (n - 1)) == 0) {
+            init_radix2();
+        } else if (good_fft_size(n) == n) {
+            init_mixed_radix();
+        } else {
+            init_bluestein();
+        }
+    }
+
+    size_t size() const {
+        return n_;
+    }
+
+    Kind kind() const {
+        return kind_;
+    }
+
+    /**
+     * @brief 原地正变换 X[k] = sum x[j] exp(-2 pi i jk / n)
+     */
+    void forward(complex* data) const {
+        switch (kind_) {
+        case Kind::Radix2:
+            forward_radix2(data);
+            break;
+        case Kind::MixedRadix:
+            forward_mixed_radix(data);
+            break;
+        case Kind::Bluestein:
+            forward_bluestein(data);
+            break;
+        }
+    }
+
+    /**
+     * @brief 原地逆变换, 包含 1/n 的缩放
+     */
+    void inverse(complex* data) const {
+        // ifft(x) = swap(fft(swap(x))) / n, swap 交换实部和虚部
+        swap_re_im(data);
+        forward(data);
+        swap_re_im(data);
+        const double s = 1.0 / double(n_);
+        double* d = reinterpret_cast<double*>(data);
+        for (size_t i = 0; i < 2 * n_; i++) {
+            d[i] *= s;
+        }
+    }
+
+private:
+    struct Stage {
+        size_t p;
+        size_t len;
+        size_t offset; // 在 twiddle_ 中的起始位置
+    };
+
+    size_t n_;
+    Kind kind_ {Kind::Radix2};
+    std::shared_ptr<const detail::BitReverseTable> bitrev_;
+    aligned_vector<complex> twiddle_;
+    // 混合基
+    std::vector<Stage> stages_;
+    double cs_[8][4][4][2] {}; // 奇数基 p 的 (cos, sin)(2 pi jk / p)
+    // Bluestein
+    std::shared_ptr<const FFTPlan> inner_;
+    aligned_vector<complex> chirp_;
+    aligned_vector<complex> chirp_fft_;
+
+    void init_radix2() {
+        kind_ = Kind::Radix2;
+        bitrev_ = detail::cached_plan<detail::BitReverseTable>(n_);
+
+        // 半长为 h 的那一层的旋转因子 exp(-2 pi i k / 2h), k < h, 存在 twiddle_[h - 1 ...]
+        twiddle_.resize(n_ > 1 ? n_ - 1 : 0);
+        for (size_t h = 1; h < n_; h *= 2) {
+            for (size_t k = 0; k < h; k++) {
+                twiddle_[h - 1 + k] = std::polar(1.0, -pi * double(k) / double(h));
+            }
+        }
+    }
+
+    void init_mixed_radix() {
+        kind_ = Kind::MixedRadix;
+        size_t m = n_, len = 1;
+        for (size_t p : { 4, 2, 3, 5, 7 }) {
+            while (m % p == 0) {
+                // 第 k1 组旋转因子 exp(-2 pi i q k1 / (len p)), q = 1 ~ p-1
+                stages_.push_back({ p, len, twiddle_.size() });
+                for (size_t k1 = 0; k1 < len; k1++) {
+                    for (size_t q = 1; q < p; q++) {
+                        twiddle_.push_back(std::polar(1.0, -2 * pi * double(q * k1) / double(len * p)));
+                    }
+                }
+                m /= p;
+                len *= p;
+            }
+        }
+        for (size_t p : { 3, 5, 7 }) {
+            for (size_t k = 1; k <= p / 2; k++) {
+                for (size_t j = 1; j <= p / 2; j++) {
+                    const double t = 2 * pi * double(j * k % p) / double(p);
+                    cs_[p][k][j - 1][0] = std::cos(t);
+                    cs_[p][k][j - 1][1] = std::sin(t);
+                }
+            }
+        }
+    }
+
+    void init_bluestein() {
+        kind_ = Kind::Bluestein;
+        size_t m = 1;
+        while (m < 2 * n_ - 1) m *= 2;
+        // 内部计划不经过缓存, 避免在 fft_plan 持锁时重入
+        inner_ = std::make_shared<const FFTPlan>(m);
+
+        // jk = (j^2 + k^2 - (k-j)^2) / 2, chirp[j] = exp(-pi i j^2 / n)
+        chirp_.resize(n_);
+        for (size_t j = 0; j < n_; j++) {
+            const size_t j2 = (j * j) % (2 * n_); // 取模保证角度的精度
+            chirp_[j] = std::polar(1.0, -pi * double(j2) / double(n_));
+        }
+        // b[j] = conj(chirp[|j|]), 循环卷积的核. 预先做好 FFT 并包含逆变换的 1/m
+        chirp_fft_.assign(m, complex(0.0));
+        chirp_fft_[0] = std::conj(chirp_[0]);
+        for (size_t j = 1; j < n_; j++) {
+            chirp_fft_[j] = chirp_fft_[m - j] = std::conj(chirp_[j]);
+        }
+        inner_->forward(chirp_fft_.data());
+        for (auto& c : chirp_fft_) c /= double(m);
+    }
+
+    void forward_radix2(complex* data) const {
+        bitrev_->apply(data);
+#ifdef ZMATH_X86_SIMD
+        const bool avx2 = cpu_simd_level() >= SimdLevel::AVX2;
+#endif
+        for (size_t h = 1; h < n_; h *= 2) {
+            const complex* w = twiddle_.data() + h - 1;
+#ifdef ZMATH_X86_SIMD
+            if (avx2 && h >= 2) {
+                detail::fft_butterfly_avx2(data, n_, h, w);
+                continue;
+            }
+#endif
+            detail::fft_butterfly_scalar(data, n_, h, w);
+        }
+    }
+
+    void forward_mixed_radix(complex* data) const {
+        thread_local aligned_vector<complex> scratch;
+        if (scratch.size() < n_) scratch.resize(n_);
+        complex* x = data;
+        complex* y = scratch.data();
+        for (const auto& st : stages_) {
+            const complex* tw = twiddle_.data() + st.offset;
+            switch (st.p) {
+            case 2: detail::fft_stockham_stage<2>(x, y, n_, st.len, tw, cs_[2]); break;
+            case 3: detail::fft_stockham_stage<3>(x, y, n_, st.len, tw, cs_[3]); break;
+            case 4: detail::fft_stockham_stage<4>(x, y, n_, st.len, tw, cs_[4]); break;
+            case 5: detail::fft_stockham_stage<5>(x, y, n_, st.len, tw, cs_[5]); break;
+            case 7: detail::fft_stockham_stage<7>(x, y, n_, st.len, tw, cs_[7]); break;
+            }
+            std::swap(x, y);
+        }
+        if (x != data) {
+            std::copy(x, x + n_, data);
+        }
+    }
+
+    void forward_bluestein(complex* data) const {
+        const size_t m = inner_->size();
+        thread_local aligned_vector<complex> scratch;
+        if (scratch.size() < m) scratch.resize(m);
+        complex* a = scratch.data();
+        for (size_t j = 0; j < n_; j++) {
+            a[j] = detail::cmul(data[j], chirp_[j]);
+        }
+        std::fill(a + n_, a + m, complex(0.0));
+        inner_->forward(a);
+        for (size_t k = 0; k < m; k++) {
+            a[k] = detail::cmul(a[k], chirp_fft_[k]);
+        }
+        inner_->inverse_unscaled(a);
+        for (size_t k = 0; k < n_; k++) {
+            data[k] = detail::cmul(a[k], chirp_[k]);
+        }
+    }
+
+    void inverse_unscaled(complex* data) const {
+        swap_re_im(data);
+        forward(data);
+        swap_re_im(data);
+    }
+
+    void swap_re_im(complex* data) const {
+        double* d = reinterpret_cast<double*>(data);
+        for (size_t i = 0; i < n_; i++) {
+            std::swap(d[2 * i], d[2 * i + 1]);
+        }
+    }
+};
+
 /**
- * @brief 
- * 
- * @param coef 多项式的系数. 例如, 如果多项式是 1 - 2x + 3x^2, 则 coef 是 { 1, -2, 3 } 
+ * @brief 返回长度为 n 的 FFT 计划, 同一长度的计划只构造一次. 线程安全
  */
-void fft(complex_array& coef) {
-    const int N = coef.size(); // degree of 
+inline std::shared_ptr<const FFTPlan> fft_plan(size_t n) {
+    return detail::cached_plan<FFTPlan>(n);
+}
+
+/**
+ * @brief 长度为 n 的实数序列的 FFT 计划
+ *
+ * n 为偶数时利用 Hermite 对称性, 把 x 的偶数项和奇数项分别作为实部和虚部, 只做一次 n/2 点的复数 FFT,
+ * 计算量和内存都约为复数 FFT 的一半. n 为奇数时退化为 n 点的复数 FFT.
+ * 输出只保存 X[0] ~ X[n/2], 其余部分是它们的共轭
+ */
+class RealFFTPlan {
+public:
+    explicit RealFFTPlan(size_t n) : n_(n) {
+        if (n % 2 != 0) {
+            full_ = fft_plan(n);
+            return;
+        }
+        half_ = fft_plan(n / 2);
+        const size_t m = n / 2;
+        twiddle_.resize(m);
+        for (size_t k = 0; k < m; k++) {
+            twiddle_[k] = std::polar(1.0, -2 * pi * double(k) / double(n));
+        }
+    }
 
-    if (N <= 1) return;
+    size_t size() const {
+        return n_;
+    }
 
-    complex_array even = coef[std::slice(0, N / 2, 2)];
-    complex_array odd  = coef[std::slice(1, N / 2, 2)];
+    /**
+     * @param in  n 个实数
+     * @param out n/2 + 1 个复数, X[k] = sum x[j] exp(-2 pi i jk / n)
+     */
+    void forward(const double* in, complex* out) const {
+        if (full_) {
+            complex* z = odd_scratch();
+            std::copy(in, in + n_, z);
+            full_->forward(z);
+            std::copy(z, z + n_ / 2 + 1, out);
+            return;
+        }
+        const size_t m = n_ / 2;
+        // z[j] = x[2j] + i x[2j+1]
+        std::copy(in, in + n_, reinterpret_cast<double*>(out));
+        half_->forward(out);
 
-    fft(even);
-    fft(odd);
+        // X[k] = E[k] + W^k O[k], E[k] = (Z[k] + conj(Z[m-k])) / 2, O[k] = (Z[k] - conj(Z[m-k])) / 2i
+        // k 和 m - k 一起处理, 可以原地完成
+        const complex z0 = out[0];
+        out[0] = complex(z0.real() + z0.imag(), 0.0);
+        out[m] = complex(z0.real() - z0.imag(), 0.0);
+        for (size_t k = 1; 2 * k <= m; k++) {
+            const complex zk = out[k], zmk = out[m - k];
+            const complex ek = 0.5 * (zk + std::conj(zmk));
+            const complex d = zk - std::conj(zmk);
+            const complex ok(0.5 * d.imag(), -0.5 * d.real()); // d / 2i
+            const complex wok = detail::cmul(twiddle_[k], ok);
+            out[k] = ek + wok;
+            // X[m-k] = conj(E[k] - W^k O[k])
+            out[m - k] = std::conj(ek - wok);
+        }
+    }
 
-    for (size_t k = 0; k < N / 2; k++) {
-        complex t = std::polar(1.0, -2 * pi * k / N) * odd[k];
-        coef[k] = even[k] + t;
-        coef[k + N / 2] = even[k] - t;
+    /**
+     * @param in  n/2 + 1 个复数 (X[0] ~ X[n/2])
+     * @param out n 个实数, 包含 1/n 的缩放
+     */
+    void inverse(const complex* in, double* out) const {
+        if (full_) {
+            // 由共轭对称补全另一半频谱
+            complex* z = odd_scratch();
+            std::copy(in, in + n_ / 2 + 1, z);
+            for (size_t k = n_ / 2 + 1; k < n_; k++) z[k] = std::conj(in[n_ - k]);
+            full_->inverse(z);
+            for (size_t i = 0; i < n_; i++) out[i] = z[i].real();
+            return;
+        }
+        const size_t m = n_ / 2;
+        complex* z = reinterpret_cast<complex*>(out);
+        // E[k] = (X[k] + conj(X[m-k])) / 2, O[k] = (X[k] - conj(X[m-k])) / (2 W^k), Z[k] = E[k] + i O[k]
+        for (size_t k = 0; k < m; k++) {
+            const complex xk = in[k], xmk = std::conj(in[m - k]);
+            const complex ek = 0.5 * (xk + xmk);
+            const complex ok = detail::cmul(0.5 * (xk - xmk), std::conj(twiddle_[k]));
+            z[k] = ek + complex(-ok.imag(), ok.real()); // E + i O
+        }
+        half_->inverse(z);
     }
+
+private:
+    size_t n_;
+    std::shared_ptr<const FFTPlan> half_;
+    std::shared_ptr<const FFTPlan> full_;  // 仅 n 为奇数时使用
+    aligned_vector<complex> twiddle_;
+
+    complex* odd_scratch() const {
+        thread_local aligned_vector<complex> scratch;
+        if (scratch.size() < n_) scratch.resize(n_);
+        return scratch.data();
+    }
+};
+
+/**
+ * @brief 返回长度为 n 的实数 FFT 计划, 线程安全
+ */
+inline std::shared_ptr<const RealFFTPlan> rfft_plan(size_t n) {
+    return detail::cached_plan<RealFFTPlan>(n);
+}
+
+/**
+ * @brief
+ *
+ * @param coef 多项式的系数. 例如, 如果多项式是 1 - 2x + 3x^2, 则 coef 是 { 1, -2, 3 }
+ */
+inline void fft(complex_array& coef) {
+    if (coef.size() <= 1) return;
+    fft_plan(coef.size())->forward(&coef[0]);
+}
+
+inline void ifft(complex_array& coef) {
+    if (coef.size() <= 1) return;
+    fft_plan(coef.size())->inverse(&coef[0]);
 }
 
-void ifft(complex_array& coef) {
-    coef = coef.apply(std::conj);
-    fft(coef);
-    coef = coef.apply(std::conj);
-    coef /= coef.size();
+/**
+ * @brief 实数序列的 FFT, 返回 X[0] ~ X[n/2] (n/2 向下取整)
+ */
+inline std::vector<complex> rfft(const std::vector<double>& x) {
+    std::vector<complex> out(x.size() / 2 + 1);
+    rfft_plan(x.size())->forward(x.data(), out.data());
+    return out;
 }
 
-}
\ No newline at end of file
+/**
+ * @brief rfft 的逆变换, n 是原序列的长度
+ */
+inline std::vector<double> irfft(const std::vector<complex>& spec, size_t n) {
+    std::vector<double> out(n);
+    rfft_plan(n)->inverse(spec.data(), out.data());
+    return out;
+}
+
+}
@@ -0,0 +1,238 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#ifdef ZMATH_TRACK_ALLOCATIONS
+#include <atomic>
+#endif
+
+namespace zmath {
+
+// 默认按 cache line (64 字节) 对齐, 同时满足 AVX / AVX-512 的对齐要求
+constexpr size_t default_alignment = 64;
+
+#ifdef ZMATH_TRACK_ALLOCATIONS
+namespace detail {
+
+inline std::atomic<size_t>& allocation_counter() {
+    static std::atomic<size_t> counter { 0 };
+    return counter;
+}
+
+}
+#endif
+
+/**
+ * @brief aligned_allocator 累计分配的次数, 用于确认稳态下没有堆分配
+ *
+ * 矩阵, 向量, Workspace 和 GEMM 的打包缓冲区都经过 aligned_allocator.
+ * 只有定义了 ZMATH_TRACK_ALLOCATIONS 时才统计 (每次分配多一次原子加), 否则总是返回 0
+ */
+inline size_t allocation_count() {
+#ifdef ZMATH_TRACK_ALLOCATIONS
+    return detail::allocation_counter().load(std::memory_order_relaxed);
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief 对齐的分配器, 用于矩阵和向量的连续存储
+ */
+template <typename T, size_t Align = default_alignment>
+class aligned_allocator {
+public:
+    using value_type = T;
+
+    template <typename U>
+    struct rebind {
+        using other = aligned_allocator<U, Align>;
+    };
+
+    aligned_allocator() noexcept = default;
+
+    template <typename U>
+    aligned_allocator(const aligned_allocator<U, Align>&) noexcept { }
+
+    T* allocate(size_t n) {
+        if (n == 0) return nullptr;
+        // aligned_alloc 要求大小是对齐的整数倍
+        size_t bytes = (n * sizeof(T) + Align - 1) / Align * Align;
+        void* p = std::aligned_alloc(Align, bytes);
+        if (p == nullptr) throw std::bad_alloc();
+#ifdef ZMATH_TRACK_ALLOCATIONS
+        detail::allocation_counter().fetch_add(1, std::memory_order_relaxed);
+#endif
+        return static_cast<T*>(p);
+    }
+
+    void deallocate(T* p, size_t) noexcept {
+        std::free(p);
+    }
+
+    template <typename U>
+    bool operator==(const aligned_allocator<U, Align>&) const noexcept {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const aligned_allocator<U, Align>&) const noexcept {
+        return false;
+    }
+};
+
+template <typename T>
+using aligned_vector = std::vector<T, aligned_allocator<T>>;
+
+/**
+ * @brief 求解器的工作区: 从预先分配的大块内存中顺序切出临时数组 (bump allocator), 不逐个释放
+ *
+ * 空间不够时新增一块. 全部归还后多块会合并成一块, 大小为用量的峰值, 之后同样规模的计算不再分配内存.
+ * 接受 Workspace 的函数在返回前用 Workspace::Scope 归还自己切出的部分, 调用者不必手动 reset.
+ * 不是线程安全的, 每个线程应使用自己的 Workspace
+ */
+class Workspace {
+public:
+    struct Mark {
+        size_t block;
+        size_t offset;
+    };
+
+    /**
+     * @brief 析构时归还构造之后切出的全部内存
+     */
+    class Scope {
+    public:
+        explicit Scope(Workspace& ws) : ws_(ws), mark_(ws.mark()) { }
+        ~Scope() {
+            ws_.release(mark_);
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Workspace& ws_;
+        Mark mark_;
+    };
+
+    Workspace() = default;
+
+    /**
+     * @brief 预留 bytes 字节, 用量不超过它时不再分配内存
+     */
+    explicit Workspace(size_t bytes) {
+        reserve(bytes);
+    }
+
+    /**
+     * @brief 预留 bytes 字节. 可能换掉现有的块, 调用时不能有未归还的内存
+     */
+    void reserve(size_t bytes) {
+        assert(used() == 0);
+        if (capacity() < bytes) {
+            blocks_.clear();
+            blocks_.emplace_back(round_up(bytes));
+            block_ = offset_ = 0;
+        }
+    }
+
+    /**
+     * @brief 切出 n 个 T, 按 64 字节对齐, 内容未初始化. T 必须可以按字节拷贝
+     */
+    template <typename T>
+    T* allocate(size_t n) {
+        static_assert(std::is_trivially_copyable_v<T> && alignof(T) <= default_alignment,
+                      "Workspace only holds trivially copyable types");
+        const size_t bytes = round_up(n * sizeof(T));
+        if (blocks_.empty() || offset_ + bytes > blocks_[block_].size()) {
+            next_block(bytes);
+        }
+        T* p = reinterpret_cast<T*>(blocks_[block_].data() + offset_);
+        offset_ += bytes;
+        peak_ = std::max(peak_, used());
+        return p;
+    }
+
+    Mark mark() const {
+        return { block_, offset_ };
+    }
+
+    /**
+     * @brief 归还 m 之后切出的全部内存
+     */
+    void release(Mark m) {
+        block_ = m.block;
+        offset_ = m.offset;
+        if (block_ == 0 && offset_ == 0 && blocks_.size() > 1) {
+            blocks_.clear();
+            blocks_.emplace_back(round_up(peak_));
+        }
+    }
+
+    void reset() {
+        release({ 0, 0 });
+    }
+
+    // 已切出的字节数, 前面各块剩下用不上的尾部也算在内
+    size_t used() const {
+        size_t s = offset_;
+        for (size_t b = 0; b < block_ && b < blocks_.size(); b++) s += blocks_[b].size();
+        return s;
+    }
+
+    size_t capacity() const {
+        size_t s = 0;
+        for (const auto& b : blocks_) s += b.size();
+        return s;
+    }
+
+    size_t peak() const {
+        return peak_;
+    }
+
+private:
+    std::vector<aligned_vector<unsigned char>> blocks_;
+    size_t block_ { 0 };
+    size_t offset_ { 0 };
+    size_t peak_ { 0 };
+
+    static size_t round_up(size_t bytes) {
+        return (bytes + default_alignment - 1) / default_alignment * default_alignment;
+    }
+
+    // 当前块放不下时换到下一块. 下一块之后的内存都已归还, 太小时可以直接换掉
+    void next_block(size_t bytes) {
+        if (blocks_.empty()) {
+            blocks_.emplace_back(std::max<size_t>(bytes, 4096));
+            block_ = offset_ = 0;
+            return;
+        }
+        const size_t grow = std::max(bytes, 2 * blocks_[block_].size());
+        block_++;
+        offset_ = 0;
+        if (block_ == blocks_.size()) {
+            blocks_.emplace_back(grow);
+        } else if (blocks_[block_].size() < bytes) {
+            blocks_[block_] = aligned_vector<unsigned char>(grow);
+        }
+    }
+};
+
+namespace detail {
+
+// 调用线程自己的工作区, 供不接受 Workspace 的 GEMM, ger, 稀疏 A^T x 和 poly_mul 存放临时数组. 增长到用量峰值后不再分配
+inline Workspace& thread_workspace() {
+    thread_local Workspace ws;
+    return ws;
+}
+
+}
+
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <type_traits>
+
+namespace zmath {
+
+/**
+ * @brief 模 P 的整数, P 是小于 2^31 的素数
+ */
+template <uint32_t P>
+class ModInt {
+public:
+    static_assert(P >= 2 && P < (1u << 31), "P must be a prime below 2^31");
+
+    static constexpr uint32_t mod() {
+        return P;
+    }
+
+    constexpr ModInt() = default;
+
+    template <typename I, typename = std::enable_if_t<std::is_integral_v<I>>>
+    constexpr ModInt(I v) {
+        if constexpr (std::is_signed_v<I>) {
+            int64_t r = static_cast<int64_t>(v) % static_cast<int64_t>(P);
+            v_ = static_cast<uint32_t>(r < 0 ? r + P : r);
+        } else {
+            v_ = static_cast<uint32_t>(static_cast<uint64_t>(v) % P);
+        }
+    }
+
+    constexpr uint32_t value() const {
+        return v_;
+    }
+
+    constexpr ModInt& operator+=(const ModInt& rhs) {
+        v_ += rhs.v_;
+        if (v_ >= P) v_ -= P;
+        return *this;
+    }
+
+    constexpr ModInt& operator-=(const ModInt& rhs) {
+        v_ += P - rhs.v_;
+        if (v_ >= P) v_ -= P;
+        return *this;
+    }
+
+    constexpr ModInt& operator*=(const ModInt& rhs) {
+        v_ = static_cast<uint32_t>(static_cast<uint64_t>(v_) * rhs.v_ % P);
+        return *this;
+    }
+
+    constexpr ModInt& operator/=(const ModInt& rhs) {
+        return *this *= rhs.inv();
+    }
+
+    constexpr ModInt operator-() const {
+        return ModInt() - *this;
+    }
+
+    friend constexpr ModInt operator+(ModInt lhs, const ModInt& rhs) {
+        return lhs += rhs;
+    }
+
+    friend constexpr ModInt operator-(ModInt lhs, const ModInt& rhs) {
+        return lhs -= rhs;
+    }
+
+    friend constexpr ModInt operator*(ModInt lhs, const ModInt& rhs) {
+        return lhs *= rhs;
+    }
+
+    friend constexpr ModInt operator/(ModInt lhs, const ModInt& rhs) {
+        return lhs /= rhs;
+    }
+
+    friend constexpr bool operator==(const ModInt& lhs, const ModInt& rhs) {
+        return lhs.v_ == rhs.v_;
+    }
+
+    friend constexpr bool operator!=(const ModInt& lhs, const ModInt& rhs) {
+        return lhs.v_ != rhs.v_;
+    }
+
+    constexpr ModInt pow(uint64_t e) const {
+        ModInt ret(1), a = *this;
+        while (e) {
+            if (e & 1) ret *= a;
+            a *= a;
+            e >>= 1;
+        }
+        return ret;
+    }
+
+    // 费马小定理求逆元, 0 没有逆元, 返回 0
+    constexpr ModInt inv() const {
+        return pow(P - 2);
+    }
+
+    std::string to_string() const {
+        return std::to_string(v_);
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const ModInt& m) {
+        os << m.v_;
+        return os;
+    }
+
+private:
+    uint32_t v_ {0};
+};
+
+template <typename T>
+struct is_modint : std::false_type { };
+
+template <uint32_t P>
+struct is_modint<ModInt<P>> : std::true_type { };
+
+template <typename T>
+constexpr bool is_modint_v = is_modint<T>::value;
+
+// 常用的 NTT 素数, 都是 c * 2^k + 1 的形式
+constexpr uint32_t ntt_prime = 998244353; // 119 * 2^23 + 1
+
+using ModInt998244353 = ModInt<998244353>;
+
+}
@@ -0,0 +1,216 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include <zmath/utils/fft.h>
+#include <zmath/utils/modint.h>
+#include <zmath/utils/thread_pool.h>
+
+// 数论变换 (NTT): 在 Z/PZ 上的 FFT, 没有舍入误差, 用于整数和模意义下的多项式乘法.
+// 与 FFT 共用位反转表和按长度缓存计划的机制
+
+namespace zmath {
+
+namespace detail {
+
+// P 的最小原根, 对 P - 1 的每个素因子 q 检查 g^((P-1)/q) != 1
+template <uint32_t P>
+uint32_t primitive_root() {
+    uint32_t factors[32];
+    size_t nf = 0;
+    uint32_t m = P - 1;
+    for (uint32_t q = 2; uint64_t(q) * q <= m; q++) {
+        if (m % q == 0) {
+            factors[nf++] = q;
+            while (m % q == 0) m /= q;
+        }
+    }
+    if (m > 1) factors[nf++] = m;
+    for (uint32_t g = 2;; g++) {
+        bool ok = true;
+        for (size_t i = 0; i < nf && ok; i++) {
+            ok = ModInt<P>(g).pow((P - 1) / factors[i]) != ModInt<P>(1);
+        }
+        if (ok) return g;
+    }
+}
+
+}
+
+/**
+ * @brief 长度为 2^t 的 NTT 计划, 要求 2^t 整除 P - 1, 否则构造时抛出异常
+ *
+ * 与 FFTPlan 相同: 构造时准备好位反转表和每一层的单位根, 变换原地, 迭代进行. 构造后只读, 线程安全
+ */
+template <uint32_t P>
+class NTTPlan {
+public:
+    using value_type = ModInt<P>;
+
+    /**
+     * @brief 该素数支持的最大变换长度 (整除 P - 1 的最大的 2 的幂)
+     */
+    static constexpr size_t max_size() {
+        return size_t(1) << __builtin_ctz(P - 1);
+    }
+
+    explicit NTTPlan(size_t n) : n_(checked_size(n)), bitrev_(detail::cached_plan<detail::BitReverseTable>(n)) {
+        const value_type g(detail::primitive_root<P>());
+        roots_.resize(n > 1 ? n - 1 : 0);
+        iroots_.resize(roots_.size());
+        // 半长为 h 的那一层的单位根 w^k, w 是 2h 次本原单位根, 存在 roots_[h - 1 ...]
+        for (size_t h = 1; h < n; h *= 2) {
+            const value_type w = g.pow((P - 1) / (2 * h));
+            const value_type iw = w.inv();
+            value_type x(1), ix(1);
+            for (size_t k = 0; k < h; k++) {
+                roots_[h - 1 + k] = x;
+                iroots_[h - 1 + k] = ix;
+                x *= w;
+                ix *= iw;
+            }
+        }
+        n_inv_ = value_type(static_cast<uint64_t>(n)).inv();
+    }
+
+    size_t size() const {
+        return n_;
+    }
+
+    void forward(value_type* data) const {
+        transform(data, roots_);
+    }
+
+    /**
+     * @brief 逆变换, 包含 1/n 的缩放
+     */
+    void inverse(value_type* data) const {
+        transform(data, iroots_);
+        for (size_t i = 0; i < n_; i++) {
+            data[i] *= n_inv_;
+        }
+    }
+
+private:
+    size_t n_;
+    std::shared_ptr<const detail::BitReverseTable> bitrev_;
+    aligned_vector<value_type> roots_;
+    aligned_vector<value_type> iroots_;
+    value_type n_inv_;
+
+    // 长度不是 2 的幂或超过 max_size() 时, (P - 1) / (2h) 不是整数, 选出的单位根是错的
+    static size_t checked_size(size_t n) {
+        if (n & (n - 1)) throw std::invalid_argument("zmath: NTT length must be a power of two");
+        if (n > max_size()) throw std::length_error("zmath: NTT length exceeds the limit of the prime");
+        return n;
+    }
+
+    void transform(value_type* data, const aligned_vector<value_type>& roots) const {
+        bitrev_->apply(data);
+        for (size_t h = 1; h < n_; h *= 2) {
+            const value_type* w = roots.data() + h - 1;
+            for (size_t s = 0; s < n_; s += 2 * h) {
+                value_type* a = data + s;
+                value_type* b = a + h;
+                for (size_t k = 0; k < h; k++) {
+                    const value_type t = b[k] * w[k];
+                    b[k] = a[k] - t;
+                    a[k] += t;
+                }
+            }
+        }
+    }
+};
+
+/**
+ * @brief 返回长度为 n 的 NTT 计划, 线程安全
+ */
+template <uint32_t P>
+std::shared_ptr<const NTTPlan<P>> ntt_plan(size_t n) {
+    return detail::cached_plan<NTTPlan<P>>(n);
+}
+
+/**
+ * @brief 模 P 的卷积, 要求结果长度不超过 NTTPlan<P>::max_size(), 否则抛出 std::length_error
+ */
+template <uint32_t P>
+std::vector<ModInt<P>> ntt_convolve(const ModInt<P>* a, size_t na, const ModInt<P>* b, size_t nb) {
+    if (na == 0 || nb == 0) return {};
+    const size_t len = na + nb - 1;
+    size_t n = 1;
+    while (n < len) n *= 2;
+    auto plan = ntt_plan<P>(n);
+    std::vector<ModInt<P>> fa(n), fb(n);
+    std::copy(a, a + na, fa.begin());
+    std::copy(b, b + nb, fb.begin());
+    plan->forward(fa.data());
+    plan->forward(fb.data());
+    for (size_t i = 0; i < n; i++) {
+        fa[i] *= fb[i];
+    }
+    plan->inverse(fa.data());
+    fa.resize(len);
+    return fa;
+}
+
+namespace detail {
+
+// 三个 NTT 素数, 乘积约为 5.8e25, 最大变换长度 2^24
+constexpr uint32_t crt_p1 = 167772161; // 5 * 2^25 + 1
+constexpr uint32_t crt_p2 = 469762049; // 7 * 2^26 + 1
+constexpr uint32_t crt_p3 = 754974721; // 45 * 2^24 + 1
+
+template <uint32_t P>
+std::vector<ModInt<P>> to_mod(const int64_t* a, size_t n) {
+    std::vector<ModInt<P>> r(n);
+    for (size_t i = 0; i < n; i++) r[i] = ModInt<P>(a[i]);
+    return r;
+}
+
+}
+
+/**
+ * @brief 整数序列的精确卷积, 用三个素数分别做 NTT 再用中国剩余定理合并
+ *
+ * 要求每个结果的绝对值小于 p1 p2 p3 / 2 (约 2.9e25), 结果长度不超过 2^24 (否则抛出 std::length_error).
+ * 三个 NTT 在线程池中并行
+ */
+inline std::vector<__int128> crt_convolve(const int64_t* a, size_t na, const int64_t* b, size_t nb) {
+    using namespace detail;
+    if (na == 0 || nb == 0) return {};
+    // 在分给线程池之前检查, 三个素数中 p3 的限制最小
+    if (na + nb - 1 > NTTPlan<crt_p3>::max_size()) {
+        throw std::length_error("zmath: crt_convolve result exceeds 2^24 coefficients");
+    }
+    std::vector<ModInt<crt_p1>> r1;
+    std::vector<ModInt<crt_p2>> r2;
+    std::vector<ModInt<crt_p3>> r3;
+    parallel_for(0, 3, 1, [&](size_t lo, size_t hi) {
+        for (size_t k = lo; k < hi; k++) {
+            if (k == 0) r1 = ntt_convolve(to_mod<crt_p1>(a, na).data(), na, to_mod<crt_p1>(b, nb).data(), nb);
+            if (k == 1) r2 = ntt_convolve(to_mod<crt_p2>(a, na).data(), na, to_mod<crt_p2>(b, nb).data(), nb);
+            if (k == 2) r3 = ntt_convolve(to_mod<crt_p3>(a, na).data(), na, to_mod<crt_p3>(b, nb).data(), nb);
+        }
+    });
+
+    // Garner: x = x1 + x2 p1 + x3 p1 p2, 0 <= xi < pi
+    const ModInt<crt_p2> inv_p1 = ModInt<crt_p2>(crt_p1).inv();
+    const ModInt<crt_p3> inv_p1p2 = (ModInt<crt_p3>(crt_p1) * ModInt<crt_p3>(crt_p2)).inv();
+    const __int128 p12 = __int128(crt_p1) * crt_p2;
+    const __int128 M = p12 * crt_p3;
+    std::vector<__int128> out(r1.size());
+    for (size_t i = 0; i < out.size(); i++) {
+        const uint32_t x1 = r1[i].value();
+        const uint32_t x2 = ((r2[i] - ModInt<crt_p2>(x1)) * inv_p1).value();
+        const uint32_t x3 = ((r3[i] - ModInt<crt_p3>(x1) - ModInt<crt_p3>(uint64_t(x2) * crt_p1)) * inv_p1p2).value();
+        __int128 x = __int128(x1) + __int128(x2) * crt_p1 + __int128(x3) * p12;
+        if (x > M / 2) x -= M;
+        out[i] = x;
+    }
+    return out;
+}
+
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+// 运行时检测 CPU 支持的 SIMD 指令集, 用于选择计算核
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define ZMATH_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace zmath {
+
+enum class SimdLevel {
+    Scalar = 0,
+    AVX2 = 1,   // AVX2 + FMA
+    AVX512 = 2  // AVX-512F
+};
+
+/**
+ * @brief 返回当前 CPU 支持的最高 SIMD 等级
+ */
+inline SimdLevel cpu_simd_level() {
+    static const SimdLevel level = [] {
+#ifdef ZMATH_X86_SIMD
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f"))
+            return SimdLevel::AVX512;
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+            return SimdLevel::AVX2;
+#endif
+        return SimdLevel::Scalar;
+    }();
+    return level;
+}
+
+}
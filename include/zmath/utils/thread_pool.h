@@ -0,0 +1,245 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// zmath 全局线程池. 每个工作线程有自己的任务队列, 空闲时从其他队列偷任务 (work stealing).
+// parallel_for 按线程数把区间切成固定的块, 块的划分只取决于区间和线程数,
+// 只要每个块写不同的输出, 结果对固定的线程数是确定的
+
+namespace zmath {
+
+class ThreadPool {
+public:
+    /**
+     * @param n 总线程数 (包括调用 parallel_for 的线程), 至少为 1
+     */
+    explicit ThreadPool(size_t n) : queues_(std::max<size_t>(n, 1)) {
+        for (size_t i = 1; i < queues_.size(); i++) {
+            workers_.emplace_back([this, i] { worker_loop(i); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_cv_.notify_all();
+        for (auto& t : workers_) {
+            t.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const {
+        return queues_.size();
+    }
+
+    /**
+     * @brief 并行执行 f(lo, hi), 各块合起来正好覆盖 [begin, end)
+     *
+     * @param grain 每块的最小长度, 区间不超过 grain 时直接在当前线程执行.
+     *              在工作线程内部嵌套调用时也直接串行执行
+     */
+    template <typename F>
+    void parallel_for(size_t begin, size_t end, size_t grain, F&& f) {
+        if (begin >= end) return;
+        const size_t n = end - begin;
+        grain = std::max<size_t>(grain, 1);
+        if (size() == 1 || n <= grain || in_worker()) {
+            f(begin, end);
+            return;
+        }
+
+        // 每个线程分到几块, 方便负载不均时偷任务
+        const size_t chunks = std::min((n + grain - 1) / grain, size() * 4);
+        using Fn = std::remove_reference_t<F>;
+        Job job;
+        job.ctx = const_cast<void*>(static_cast<const void*>(&f));
+        job.invoke = [](void* ctx, size_t lo, size_t hi) {
+            (*static_cast<Fn*>(ctx))(lo, hi);
+        };
+        job.remaining.store(chunks, std::memory_order_relaxed);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_ += chunks;
+        }
+        for (size_t c = 0; c < chunks; c++) {
+            const size_t lo = begin + n * c / chunks;
+            const size_t hi = begin + n * (c + 1) / chunks;
+            queues_[c % size()].push({ &job, lo, hi });
+        }
+        wake_cv_.notify_all();
+
+        // 调用线程也参与计算, 然后等待其余块完成
+        in_worker() = true;
+        Task task;
+        while (job.remaining.load(std::memory_order_acquire) != 0 && try_get(0, task)) {
+            run(task);
+        }
+        in_worker() = false;
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_cv_.wait(lock, [&] {
+            return job.remaining.load(std::memory_order_acquire) == 0;
+        });
+    }
+
+private:
+    struct Job {
+        void* ctx;
+        void (*invoke)(void* ctx, size_t lo, size_t hi);
+        std::atomic<size_t> remaining;
+    };
+
+    struct Task {
+        Job* job {nullptr};
+        size_t lo {0};
+        size_t hi {0};
+    };
+
+    // 加锁的环形队列. 所有者从尾部取 (LIFO), 其他线程从头部偷 (FIFO)
+    class WorkQueue {
+    public:
+        void push(const Task& t) {
+            std::lock_guard<std::mutex> lock(m_);
+            if (tail_ == buf_.size()) {
+                if (head_ > 0) {
+                    std::move(buf_.begin() + head_, buf_.begin() + tail_, buf_.begin());
+                    tail_ -= head_;
+                    head_ = 0;
+                } else {
+                    buf_.resize(std::max<size_t>(16, buf_.size() * 2));
+                }
+            }
+            buf_[tail_++] = t;
+        }
+
+        bool pop(Task& t) {
+            std::lock_guard<std::mutex> lock(m_);
+            if (head_ == tail_) return false;
+            t = buf_[--tail_];
+            if (head_ == tail_) head_ = tail_ = 0;
+            return true;
+        }
+
+        bool steal(Task& t) {
+            std::lock_guard<std::mutex> lock(m_);
+            if (head_ == tail_) return false;
+            t = buf_[head_++];
+            if (head_ == tail_) head_ = tail_ = 0;
+            return true;
+        }
+
+    private:
+        std::mutex m_;
+        std::vector<Task> buf_;
+        size_t head_ {0};
+        size_t tail_ {0};
+    };
+
+    static bool& in_worker() {
+        thread_local bool flag = false;
+        return flag;
+    }
+
+    bool try_get(size_t id, Task& t) {
+        if (queues_[id].pop(t)) return true;
+        for (size_t k = 1; k < queues_.size(); k++) {
+            if (queues_[(id + k) % queues_.size()].steal(t)) return true;
+        }
+        return false;
+    }
+
+    void run(const Task& t) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_--;
+        }
+        t.job->invoke(t.job->ctx, t.lo, t.hi);
+        if (t.job->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            // 加锁后再通知, 避免等待方错过唤醒
+            std::lock_guard<std::mutex> lock(mutex_);
+            done_cv_.notify_all();
+        }
+    }
+
+    void worker_loop(size_t id) {
+        in_worker() = true;
+        Task task;
+        for (;;) {
+            if (try_get(id, task)) {
+                run(task);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_cv_.wait(lock, [&] { return stop_ || pending_ > 0; });
+            if (stop_) return;
+        }
+    }
+
+    std::vector<WorkQueue> queues_;
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable wake_cv_;
+    std::condition_variable done_cv_;
+    size_t pending_ {0};
+    bool stop_ {false};
+};
+
+namespace detail {
+
+inline size_t default_num_threads() {
+    // 环境变量 ZMATH_NUM_THREADS 优先
+    if (const char* env = std::getenv("ZMATH_NUM_THREADS")) {
+        long n = std::atol(env);
+        if (n > 0) return static_cast<size_t>(n);
+    }
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+inline std::unique_ptr<ThreadPool>& global_pool() {
+    static std::unique_ptr<ThreadPool> pool = std::make_unique<ThreadPool>(default_num_threads());
+    return pool;
+}
+
+}
+
+/**
+ * @brief zmath 的全局线程池
+ */
+inline ThreadPool& thread_pool() {
+    return *detail::global_pool();
+}
+
+/**
+ * @brief 设置 zmath 使用的线程数, 不能在并行计算进行中调用
+ */
+inline void set_num_threads(size_t n) {
+    n = std::max<size_t>(n, 1);
+    auto& pool = detail::global_pool();
+    if (pool->size() == n) return;
+    pool.reset();
+    pool = std::make_unique<ThreadPool>(n);
+}
+
+inline size_t num_threads() {
+    return thread_pool().size();
+}
+
+template <typename F>
+void parallel_for(size_t begin, size_t end, size_t grain, F&& f) {
+    thread_pool().parallel_for(begin, end, grain, std::forward<F>(f));
+}
+
+}
@@ -1,5 +1,8 @@
 // 不知道那些自动化测试是啥, 自己写点测试的代�?
 #include <iostream>
+#include <cstdlib>
+// 统计 aligned_allocator 的分配次数, 见 test_workspace
+#define ZMATH_TRACK_ALLOCATIONS
 #include <zmath.h>
 
 using namespace zmath;
@@ -28,6 +31,80 @@ void test_fft() {
     }
 }
 
+void test_fft_plan() {
+    // 与直接按定义计算的 DFT 比较
+    for (size_t n : { 2, 4, 8, 64, 1024, 3, 12, 35, 360, 7 * 125, 11, 97, 1001 }) {
+        complex_array x(n), y(n);
+        for (size_t i = 0; i < n; i++) x[i] = complex(std::sin(i * 0.7), std::cos(i * 1.3));
+        for (size_t k = 0; k < n; k++)
+            for (size_t j = 0; j < n; j++)
+                y[k] += x[j] * std::polar(1.0, -2 * pi * double(j * k % n) / double(n));
+        complex_array z = x;
+        fft(z);
+        double err = 0.0;
+        for (size_t i = 0; i < n; i++) err = std::max(err, std::abs(z[i] - y[i]));
+        ifft(z);
+        double back = 0.0;
+        for (size_t i = 0; i < n; i++) back = std::max(back, std::abs(z[i] - x[i]));
+        fmt::print("fft n {} kind {} error {:.3e} roundtrip {:.3e} same plan {}\n", n, int(fft_plan(n)->kind()), err, back, fft_plan(n) == fft_plan(n));
+    }
+}
+
+void test_rfft() {
+    // 奇数长度退化为复数 FFT
+    for (size_t n : { 2, 4, 16, 256, 6, 30, 22, 1, 15, 77 }) {
+        std::vector<double> x(n);
+        complex_array z(n);
+        for (size_t i = 0; i < n; i++) z[i] = x[i] = std::sin(i * 0.37) + 0.1 * i;
+        fft(z);
+        auto spec = rfft(x);
+        double err = 0.0;
+        for (size_t k = 0; k <= n / 2; k++) err = std::max(err, std::abs(spec[k] - z[k]));
+        auto back = irfft(spec, n);
+        double back_err = 0.0;
+        for (size_t i = 0; i < n; i++) back_err = std::max(back_err, std::abs(back[i] - x[i]));
+        fmt::print("rfft n {} error {:.3e} roundtrip {:.3e}\n", n, err, back_err);
+    }
+
+    Polynomial a({ 2, -4, 0.5, -1 }), b({ -1, 0, 3 });
+    (a * b).print(); // -2 x^5 + 4 x^4 + 5.5 x^3 - 11 x^2 + 1.5 x - 3
+    (Polynomial(std::vector<double>{ 3 }) * Polynomial(std::vector<double>{ 2 })).print(); // 6
+    (a * Polynomial()).print(); // 0
+    fmt::print("good_fft_size {} {} {}\n", good_fft_size(1025), good_fft_size(11), good_fft_size(4096)); // 1029 12 4096
+    fmt::print("cheapest_fft_size {} {}\n", cheapest_fft_size(1025), cheapest_fft_size(33000)); // 1029 33075
+
+    // 次数较大时与朴素乘法比较
+    std::vector<double> c1(300), c2(200);
+    for (size_t i = 0; i < c1.size(); i++) c1[i] = std::cos(i * 0.3) + 2;
+    for (size_t i = 0; i < c2.size(); i++) c2[i] = std::sin(i * 0.2) + 2;
+    std::vector<double> c3(c1.size() + c2.size() - 1, 0.0);
+    for (size_t i = 0; i < c1.size(); i++)
+        for (size_t j = 0; j < c2.size(); j++) c3[i + j] += c1[i] * c2[j];
+    auto prod = (Polynomial(c1) * Polynomial(c2)).coef();
+    double err = 0.0;
+    for (size_t i = 0; i < c3.size(); i++) err = std::max(err, std::abs(prod[i] - c3[i]));
+    fmt::print("poly mul deg {} error {:.3e}\n", prod.size() - 1, err);
+}
+
+void test_poly_mul() {
+    // 三种算法互相比较, 包括长度不等的因子
+    double err = 0.0;
+    for (auto [na, nb] : { std::pair<size_t, size_t>{ 1, 1 }, { 2, 3 }, { 65, 64 }, { 300, 70 }, { 129, 1000 } }) {
+        std::vector<double> a(na), b(nb);
+        for (size_t i = 0; i < na; i++) a[i] = std::cos(i * 0.7);
+        for (size_t i = 0; i < nb; i++) b[i] = std::sin(i * 0.3) + 1;
+        auto naive = poly_mul(a, b, PolyMulAlgo::Naive);
+        for (auto algo : { PolyMulAlgo::Karatsuba, PolyMulAlgo::FFT, PolyMulAlgo::Auto }) {
+            auto c = poly_mul(a, b, algo);
+            for (size_t i = 0; i < c.size(); i++) err = std::max(err, std::abs(c[i] - naive[i]));
+        }
+    }
+    fmt::print("poly_mul max error {:.3e}\n", err);
+    fmt::print("select {} {} {}\n", int(poly_mul_select(3, 1000)), int(poly_mul_select(100, 100)), int(poly_mul_select(500, 500))); // 1 2 3
+    // (x - 1)(x + 1) 走朴素乘法, 结果精确
+    (Polynomial(std::vector<double>{ 1, -1 }) * Polynomial(std::vector<double>{ 1, 1 })).print();
+}
+
 void test_polynomial() {
     // 什么都没有的多项式, 默认�? 0
     std::vector<double> coef0 { };
@@ -152,6 +229,120 @@ void test_linalg() {
     vb.print();
 }
 
+void test_matrix() {
+    Matrix m({ { 4, 3, 2 }, { 2, 1, 3 }, { 3, 2, 1 } });
+    m.print();
+
+    // 行, 列, 子矩阵视图
+    m.get_n_row_vector(1).print();
+    m.get_n_col_vector(2).print();
+    auto b = m.block(1, 1, 2, 2);
+    b(0, 0) = 5;
+    Matrix(b).print();
+    b(0, 0) = 1;
+
+    m.T().print();
+    m.LU_decomp().print();
+    fmt::print("det {:.3f}\n", m.det()); // 3
+    m.inv().print();
+    m.LU_solve(Vector({ 9, 6, 6 })).print(); // ( 1, 1, 1 )
+}
+
+// 朴素三重循环, 作为 gemm 的参照
+Matrix naive_mul(const Matrix& a, const Matrix& b) {
+    Matrix c(a.get_row_size(), b.get_col_size());
+    for (size_t i = 0; i < a.get_row_size(); i++)
+        for (size_t j = 0; j < b.get_col_size(); j++)
+            for (size_t p = 0; p < a.get_col_size(); p++)
+                c(i, j) += a(i, p) * b(p, j);
+    return c;
+}
+
+Matrix random_matrix(size_t r, size_t c, unsigned seed = 1) {
+    Matrix m(r, c);
+    unsigned s = seed;
+    for (size_t i = 0; i < r; i++)
+        for (size_t j = 0; j < c; j++) {
+            s = s * 1664525u + 1013904223u;
+            m(i, j) = double(s >> 8) / double(1u << 23) - 1.0;
+        }
+    return m;
+}
+
+double max_abs_diff(const Matrix& a, const Matrix& b) {
+    double d = 0.0;
+    for (size_t i = 0; i < a.get_row_size(); i++)
+        for (size_t j = 0; j < a.get_col_size(); j++)
+            d = std::max(d, std::abs(a(i, j) - b(i, j)));
+    return d;
+}
+
+void test_gemm() {
+    Matrix a({ { 1, 2 }, { 3, 4 } });
+    Matrix b({ { 5, 6 }, { 7, 8 } });
+    (a * b).print(); // [ 19, 22; 43, 50 ]
+
+    // C = 2AB - C
+    Matrix c({ { 1, 1 }, { 1, 1 } });
+    gemm(2.0, a, b, -1.0, c);
+    c.print(); // [ 37, 43; 85, 99 ]
+
+    for (auto level : { SimdLevel::Scalar, SimdLevel::AVX2, SimdLevel::AVX512 }) {
+        auto used = set_gemm_simd_level(level);
+        double err = 0.0;
+        for (size_t n : { 1, 7, 33, 100, 301 }) {
+            auto x = random_matrix(n, n + 3, 1), y = random_matrix(n + 3, n + 5, 2);
+            err = std::max(err, max_abs_diff(x * y, naive_mul(x, y)));
+        }
+        fmt::print("gemm simd level {} max error {:.3e}\n", int(used), err);
+    }
+    set_gemm_simd_level(cpu_simd_level());
+}
+
+void test_thread_pool() {
+    // 不同线程数下结果一致, 固定线程数时结果确定
+    auto x = random_matrix(300, 300, 3), y = random_matrix(300, 300, 4);
+    for (size_t i = 0; i < 300; i++) x(i, i) += 300;
+    set_num_threads(1);
+    auto c1 = x * y;
+    auto lu1 = x.LU_decomp();
+    set_num_threads(4);
+    auto c4 = x * y;
+    auto lu4 = x.LU_decomp();
+    fmt::print("threads {} gemm diff {:.3e} lu diff {:.3e}\n", num_threads(), max_abs_diff(c1, c4), max_abs_diff(lu1, lu4));
+
+    std::vector<int> hit(1000, 0);
+    parallel_for(0, hit.size(), 10, [&](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; i++) hit[i]++;
+    });
+    fmt::print("parallel_for covers range once: {}\n", std::all_of(hit.begin(), hit.end(), [](int h) { return h == 1; }));
+}
+
+void test_lu() {
+    // 第一个主元为 0, 不选主元的 LU_decomp 会失败
+    Matrix a({ { 0, 2, 1 }, { 1, 1, 1 }, { 2, 1, 0 } });
+    auto lu = a.lu();
+    fmt::print("det {:.3f} singular {}\n", lu.det(), lu.is_singular()); // 3
+    lu.solve(Vector({ 3, 3, 3 })).print(); // ( 1, 1, 1 )
+    (a * lu.inverse()).print();
+    auto [perm, LU] = a.PLU_decomp();
+    fmt::print("perm {}\n", fmt::join(perm, " "));
+
+    // 多个右端项, 与分块大小无关
+    size_t n = 200;
+    auto m = random_matrix(n, n, 5), B = random_matrix(n, 7, 6);
+    for (size_t block : { 1, 16, 64, 256 }) {
+        LUFactorization f(m, block);
+        auto X = f.solve(B);
+        fmt::print("block {} residual {:.3e}\n", block, max_abs_diff(m * X, B));
+    }
+    Matrix I(n, n);
+    for (size_t i = 0; i < n; i++) I(i, i) = 1;
+    fmt::print("inv residual {:.3e}\n", max_abs_diff(m * m.inv(), I));
+    Matrix s({ { 1, 2 }, { 2, 4 } });
+    fmt::print("singular {} det {:.3f}\n", s.lu().is_singular(), s.det());
+}
+
 void test_vec2() {
     Vec2 v1(2.0, 2.0);
     Vec2 v2(1.0, -1.0);
@@ -161,9 +352,888 @@ void test_vec2() {
     v.print();
 }
 
+void test_fixed() {
+    constexpr Vec3 a(1, 2, 3), b(4, 5, 6);
+    static_assert(a.dot(b) == 32.0, "constexpr dot");
+    static_assert(Mat2{ { 1, 2 }, { 3, 4 } }.det() == -2.0, "constexpr det");
+    (a + 2.0 * b).print();  // ( 9, 12, 15 )
+    a.cross(b).print();     // ( -3, 6, -3 )
+    Vec3::forward().print(); // ( 0, 0, 1 )
+
+    constexpr Mat3 R { { 0, -1, 0 }, { 1, 0, 0 }, { 0, 0, 1 } };
+    (R * a).print(); // ( -2, 1, 3 )
+    (R * R.transpose()).print(); // I
+
+    // 2, 3, 4 阶的 A * inv(A) 与单位阵的误差, double 和 float
+    Mat2 A2 { { 4, 7 }, { 2, 6 } };
+    Mat3 A3 { { 2, -1, 0 }, { -1, 2, -1 }, { 0, -1, 2 } };
+    Mat4 A4 { { 4, 1, 0, 2 }, { 1, 3, 1, 0 }, { 0, 1, 5, 1 }, { 2, 0, 1, 6 } };
+    Mat4f A4f { { 4, 1, 0, 2 }, { 1, 3, 1, 0 }, { 0, 1, 5, 1 }, { 2, 0, 1, 6 } };
+    auto err = [](const auto& A) {
+        const auto E = A * A.inv() - std::decay_t<decltype(A)>::identity();
+        double e = 0.0;
+        for (size_t i = 0; i < A.rows(); i++) {
+            for (size_t j = 0; j < A.cols(); j++) {
+                e = std::max(e, double(std::abs(E(i, j))));
+            }
+        }
+        return e;
+    };
+    fmt::print("det {:.3f} {:.3f} {:.3f} {:.3f}\n", A2.det(), A3.det(), A4.det(), A4f.det()); // 10 4 235 235
+    fmt::print("inv error {:.3e} {:.3e} {:.3e} {:.3e}\n", err(A2), err(A3), err(A4), err(A4f));
+
+    // 非方阵乘法
+    Mat<double, 2, 3> P { { 1, 0, 2 }, { 0, 1, 1 } };
+    (P * R * P.transpose()).print(); // [ 4, 1; 3, 1 ]
+
+    // 很大或很小的分量: 默认按最大分量缩放, 与 std::hypot 一致; Fast 会上溢 / 下溢
+    const Vec3 big(1e200, 0, 0), tiny(1e-200, 0, 0);
+    fmt::print("norm {:.3e} {:.3e} {:.3e} {:.3e}, distance {:.3e}, normalize {:.3f}, angle {:.3f}\n", big.norm(),
+               Vec2(3e200, 4e200).norm(), tiny.norm(), Vec4(1e-300, 0, 1e-300, 0).norm(), big.distance(Vec3(0, 0, 0)),
+               tiny.normalize().x, big.angle(Vec3(1e200, 1e200, 0))); // 1e200 5e200 1e-200 1.414e-300, 1e200, 1, 0.785
+    fmt::print("fast norm {} {}, nan {}\n", big.norm(NormMode::Fast), tiny.norm(NormMode::Fast),
+               std::isnan(Vec3(0, NAN, 0).norm())); // inf 0, true
+}
+
+void test_vec3_batch() {
+    // 与逐个 Vec3 计算的结果比较, 1003 个点覆盖 SIMD 的尾部
+    const size_t n = 1003;
+    std::vector<Vec3> a(n), b(n);
+    for (size_t i = 0; i < n; i++) {
+        a[i] = Vec3(std::sin(i * 0.1), std::cos(i * 0.3) * 1e200, std::sin(i * 0.7));
+        b[i] = Vec3(std::cos(i * 0.2), std::sin(i * 0.5), 1.0);
+    }
+    const Vec3Batch ba(a), bb(b);
+    const auto dot = ba.dot(bb);
+    const auto nrm = ba.norm();
+    const auto fast = ba.norm(NormMode::Fast);
+    const auto ang = bb.angle(ba.normalize());
+    const auto cross = ba.cross(bb).to_vector();
+    const auto proj = bb.project(ba.normalize()).to_vector();
+    double e_dot = 0.0, e_norm = 0.0, e_ang = 0.0, e_cross = 0.0, e_proj = 0.0;
+    bool fast_overflow = false;
+    for (size_t i = 0; i < n; i++) {
+        const Vec3 u = a[i].normalize();
+        e_dot = std::max(e_dot, std::abs(dot[i] - a[i].dot(b[i])) / std::abs(a[i].y));
+        e_norm = std::max(e_norm, std::abs(nrm[i] / std::hypot(a[i].x, a[i].y, a[i].z) - 1));
+        e_ang = std::max(e_ang, std::abs(ang[i] - b[i].angle(u)));
+        e_cross = std::max(e_cross, (cross[i] - a[i].cross(b[i])).norm() / std::abs(a[i].y));
+        e_proj = std::max(e_proj, (proj[i] - b[i].project(u)).norm());
+        fast_overflow = fast_overflow || std::isinf(fast[i]);
+    }
+    fmt::print("vec3 batch dot {:.1e} norm {:.1e} angle {:.1e} cross {:.1e} project {:.1e}, fast norm overflows {}\n",
+               e_dot, e_norm, e_ang, e_cross, e_proj, fast_overflow); // fast 在 1e200 时上溢
+    Vec3Batch small(std::vector<Vec3>{ Vec3(3, 4, 0), Vec3(0, 0, 0) });
+    fmt::print("{:.3f}\n", fmt::join(small.norm(), ", ")); // 5, 0
+    // 5 个点同时经过 SIMD 核和标量尾部: 点乘会上溢的夹角, 含 inf 分量的范数
+    const Vec3Batch huge(std::vector<Vec3>(5, Vec3(1e200, 0, 0))), diag(std::vector<Vec3>(5, Vec3(1e200, 1e200, 0)));
+    const Vec3Batch inf(std::vector<Vec3>(5, Vec3(INFINITY, 1, 0)));
+    fmt::print("angle {:.6f}, inf norm {}\n", fmt::join(huge.angle(diag), ", "), fmt::join(inf.norm(), ", "));
+    // 0.785398 x5, inf x5
+}
+
+void test_transform() {
+    const Quat q = Quat::from_axis_angle(Vec3(0, 0, 2), pi / 2);
+    (q * Vec3(1, 0, 0)).print(); // ( 0, 1, 0 )
+    (q.to_matrix() * Vec3(1, 0, 0)).print();
+    const auto [axis, angle] = (q * q).to_axis_angle();
+    fmt::print("axis {} angle {:.3f}\n", axis.to_string(), angle); // z, pi
+    slerp(Quat(), q, 0.5).print(); // 绕 z 轴 45 度: ( 0.924, 0, 0, 0.383 )
+    fmt::print("from_matrix roundtrip {}\n", Quat::from_matrix(q.to_matrix()) == q);
+
+    // 成批变换与逐点变换的结果比较, AoS 和 SoA, 1003 个点覆盖 SIMD 的尾部
+    const Quat r = Quat::from_axis_angle(Vec3(1, 2, 3), 0.7);
+    const Mat4 M = affine(r, Vec3(1, -2, 0.5)) * scaling(Vec3(2, 2, 2));
+    const size_t n = 1003;
+    std::vector<Vec3> pts(n);
+    for (size_t i = 0; i < n; i++) pts[i] = Vec3(std::sin(i * 0.1), std::cos(i * 0.2), i * 0.01);
+    const auto aos = transform_points(M, pts);
+    Vec3Batch soa(pts);
+    transform_points(M, soa, soa);
+    const auto rot = transform_points(r, pts);
+    double e_aos = 0.0, e_soa = 0.0, e_rot = 0.0, e_inv = 0.0;
+    const Mat4 Mi = affine_inverse(M);
+    for (size_t i = 0; i < n; i++) {
+        const Vec3 p = transform_point(M, pts[i]);
+        e_aos = std::max(e_aos, (aos[i] - p).norm());
+        e_soa = std::max(e_soa, (soa[i] - p).norm());
+        e_rot = std::max(e_rot, (rot[i] - r * pts[i]).norm());
+        e_inv = std::max(e_inv, (transform_point(Mi, p) - pts[i]).norm());
+    }
+    fmt::print("transform_points aos {:.1e} soa {:.1e} quat {:.1e} inverse {:.1e}\n", e_aos, e_soa, e_rot, e_inv);
+
+    // float
+    const Quatf qf = Quatf::from_axis_angle(Vec3f(0, 0, 1), float(pi / 2));
+    transform_points(qf, std::vector<Vec3f>{ Vec3f(1, 0, 0) })[0].print(); // ( 0, 1, 0 )
+}
+
+void test_cholesky() {
+    auto rnd = [](size_t r, size_t c, uint64_t seed) {
+        Matrix M(r, c);
+        uint64_t x = seed;
+        for (size_t i = 0; i < r; i++) {
+            for (size_t j = 0; j < c; j++) {
+                x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+                M(i, j) = double(x >> 11) / double(1ULL << 53) - 0.5;
+            }
+        }
+        return M;
+    };
+    auto max_diff = [](const Matrix& A, const Matrix& B) {
+        double e = 0.0;
+        for (size_t i = 0; i < A.rows(); i++)
+            for (size_t j = 0; j < A.cols(); j++) e = std::max(e, std::abs(A(i, j) - B(i, j)));
+        return e;
+    };
+    auto residual = [](const Matrix& M, const Vector& x, const Vector& b) {
+        Vector r = M * x;
+        double e = 0.0;
+        for (size_t i = 0; i < r.size(); i++) e = std::max(e, std::abs(r(i) - b(i)));
+        return e;
+    };
+
+    // 协方差形式的对称正定矩阵, 大小跨过 64 的分块
+    const size_t n = 150;
+    Matrix X = rnd(n + 20, n, 1);
+    Matrix A = X.T() * X;
+    for (size_t i = 0; i < n; i++) A(i, i) += 0.1;
+    Matrix B = rnd(n, 3, 2);
+    CholeskyFactorization c = A.cholesky();
+    const Matrix& R = c.R();
+    Matrix Xc = c.solve(B), Xl = A.lu().solve(B);
+    fmt::print("cholesky n {}: pd {}, |R^T R - A| {:.1e}, vs lu {:.1e}, det ratio {:.6f}, log_det diff {:.1e}\n", n,
+               c.is_positive_definite(), max_diff(R.T() * R, A), max_diff(Xc, Xl), c.det() / A.det(),
+               std::abs(c.log_det() - std::log(A.det())));
+    Matrix I(n, n);
+    for (size_t i = 0; i < n; i++) I(i, i) = 1.0;
+    fmt::print("cholesky |L L^T - A| {:.1e}, |A A^-1 - I| {:.1e}\n", max_diff(c.L() * c.L().T(), A),
+               max_diff(A * c.inverse(), I));
+
+    // 秩 1 更新 / 降阶, 与重新分解比较
+    Matrix u = rnd(n, 1, 3);
+    Vector uv = u.get_n_col_vector(0);
+    CholeskyFactorization cu = c;
+    cu.update(uv);
+    CholeskyFactorization ref(A + u * u.T());
+    fmt::print("cholesky update diff {:.1e}", max_diff(cu.R(), ref.R()));
+    bool ok = cu.downdate(uv);
+    fmt::print(", downdate {} diff {:.1e}", ok, max_diff(cu.R(), R));
+    // A - 100 u u^T 不正定, 降阶失败且不修改分解
+    ok = cu.downdate(Vector(10.0 * uv));
+    fmt::print(", large downdate {} unchanged {:.1e}\n", ok, max_diff(cu.R(), R));
+
+    // solve 自动选择: 正定走 Cholesky, 对称不定或非对称退回 LU
+    Vector b = B.get_n_col_vector(0);
+    Matrix S = rnd(n, n, 4);
+    S = S + S.T();
+    Matrix N = rnd(n, n, 5);
+    fmt::print("solve residual spd {:.1e} symmetric {:.1e} general {:.1e}, indefinite is pd {}\n",
+               residual(A, A.solve(b), b), residual(S, S.solve(b), b), residual(N, N.solve(b), b),
+               S.cholesky().is_positive_definite());
+
+    // 对称拟定的鞍点矩阵 [[H, G^T], [G, -I]]: LDL^T 的负主元个数是负特征值个数
+    const size_t h = 100, g = 40;
+    Matrix K(h + g, h + g), G = rnd(g, h, 6);
+    Matrix H(A.block(0, 0, h, h));
+    for (size_t i = 0; i < h; i++)
+        for (size_t j = 0; j < h; j++) K(i, j) = H(i, j);
+    for (size_t i = 0; i < g; i++) {
+        for (size_t j = 0; j < h; j++) K(h + i, j) = K(j, h + i) = G(i, j);
+        K(h + i, h + i) = -1.0;
+    }
+    LDLTFactorization l = K.ldlt();
+    Vector kb = rnd(h + g, 1, 7).get_n_col_vector(0);
+    Vector d = l.D();
+    Matrix DU = l.U();
+    for (size_t i = 0; i < h + g; i++)
+        for (size_t j = 0; j < h + g; j++) DU(i, j) *= d(i);
+    fmt::print("ldlt saddle: singular {}, |U^T D U - K| {:.1e}, residual {:.1e}, negative pivots {}, det ratio {:.6f}\n",
+               l.is_singular(), max_diff(l.U().T() * DU, K), residual(K, l.solve(kb), kb), l.negative_pivots(),
+               l.det() / K.det());
+    Matrix uk(u.block(0, 0, h + g, 1));
+    LDLTFactorization lu2 = l;
+    lu2.update(uk.get_n_col_vector(0), -0.5);
+    LDLTFactorization lref(K - 0.5 * uk * uk.T());
+    fmt::print("ldlt rank-1 update diff {:.1e}\n", max_diff(lu2.LDLT(), lref.LDLT()));
+}
+
+void test_sparse() {
+    // 重复的三元组相加, 第 1 行为空
+    CooMatrix coo(4, 3);
+    coo.add(0, 0, 1);
+    coo.add(2, 1, 2);
+    coo.add(0, 2, 3);
+    coo.add(3, 0, 4);
+    coo.add(2, 1, 5);
+    const CsrMatrix A = coo.to_csr();
+    A.print(); // (0, 0) 1, (0, 2) 3, (2, 1) 7, (3, 0) 4
+    coo.to_csc().print();
+    A.to_dense().print();
+    const Vector x(std::vector<double>{ 1, 2, 3 });
+    (A * x).print(); // ( 10, 0, 14, 4 )
+    A.multiply_transpose(Vector(std::vector<double>{ 1, 1, 1, 1 })).print(); // ( 5, 7, 3 )
+    (CscMatrix(A) * x).print();
+    fmt::print("dense roundtrip nnz {}\n", CsrMatrix(A.to_dense()).nnz()); // 4
+    // 越界的下标在 Release 下也要报错
+    bool add_throws = false, triplet_throws = false;
+    try { coo.add(4, 0, 1.0); } catch (const std::out_of_range&) { add_throws = true; }
+    try { CsrMatrix::from_triplets(4, 3, { { 0, 3, 1.0 } }); } catch (const std::out_of_range&) { triplet_throws = true; }
+    fmt::print("out of range throws {} {}\n", add_throws, triplet_throws); // true true
+
+    // 足够大时并行: 与转置后的 CSR 和 CSC 比较
+    const size_t n = 20000;
+    CooMatrix big(n, n / 2);
+    for (size_t i = 0; i < n; i++) {
+        // 前几行的非零元特别多, 检查按非零元个数分块
+        const size_t cnt = i < 4 ? 5000 : 5;
+        for (size_t k = 0; k < cnt; k++) big.add(i, (i * 7 + k * 13) % (n / 2), std::sin(double(i + k)));
+    }
+    const CsrMatrix B = big.to_csr();
+    const CscMatrix Bc = big.to_csc();
+    std::vector<double> u(n), v(n / 2), y0(n / 2), y1(n / 2), z0(n), z1(n);
+    for (size_t i = 0; i < n; i++) u[i] = std::cos(double(i));
+    for (size_t j = 0; j < n / 2; j++) v[j] = std::sin(double(j));
+    B.multiply_transpose(u.data(), y0.data());
+    B.transpose().multiply(u.data(), y1.data());
+    Bc.multiply(v.data(), z0.data());
+    B.multiply(v.data(), z1.data());
+    // 缓冲区来自 Workspace, 第二次起不再分配
+    Workspace ws;
+    Bc.multiply(v.data(), z0.data(), 1.0, 0.0, ws);
+    const size_t before = allocation_count();
+    Bc.multiply(v.data(), z0.data(), 1.0, 0.0, ws);
+    B.multiply_transpose(u.data(), y0.data(), 1.0, 0.0, ws);
+    fmt::print("sparse A^T x allocations {}\n", allocation_count() - before); // 0
+    double e0 = 0.0, e1 = 0.0;
+    for (size_t j = 0; j < n / 2; j++) e0 = std::max(e0, std::abs(y0[j] - y1[j]));
+    for (size_t i = 0; i < n; i++) e1 = std::max(e1, std::abs(z0[i] - z1[i]));
+    fmt::print("sparse nnz {} spmv^T diff {:.1e} csc vs csr diff {:.1e}\n", B.nnz(), e0, e1);
+}
+
+void test_krylov() {
+    // 二维 Laplace 方程 (对称正定) 和加了对流项的非对称版本, 真解全为 1
+    const size_t m = 30, n = m * m;
+    auto grid = [&](double conv) {
+        CooMatrix coo(n, n);
+        for (size_t i = 0; i < m; i++) {
+            for (size_t j = 0; j < m; j++) {
+                const size_t r = i * m + j;
+                coo.add(r, r, 4.0);
+                if (i > 0) coo.add(r, r - m, -1.0);
+                if (i + 1 < m) coo.add(r, r + m, -1.0);
+                if (j > 0) coo.add(r, r - 1, -1.0 - conv);
+                if (j + 1 < m) coo.add(r, r + 1, -1.0 + conv);
+            }
+        }
+        return coo.to_csr();
+    };
+    const CsrMatrix A = grid(0.0), B = grid(0.4);
+    const Vector ones(std::vector<double>(n, 1.0));
+    const Vector b = A * ones, c = B * ones;
+    auto err = [&](const Vector& x) {
+        double e = 0.0;
+        for (size_t i = 0; i < n; i++) e = std::max(e, std::abs(x(i) - 1.0));
+        return e;
+    };
+
+    ConjugateGradient cg;
+    IterativeResult r0, r1, r2;
+    Vector x0 = cg.solve(A, b, IdentityPreconditioner(), &r0);
+    Vector x1 = cg.solve(A, b, JacobiPreconditioner(A), &r1);
+    Vector x2 = cg.solve(A, b, Ilu0Preconditioner(A), &r2);
+    fmt::print("cg: {} iters, jacobi {}, ilu0 {} (fewer); errors {:.1e} {:.1e} {:.1e}\n",
+               r0.iterations, r1.iterations, r2.iterations, err(x0), err(x1), err(x2));
+    fmt::print("cg history {} entries, first {:.3f}, last {:.1e}\n", r0.history.size(), r0.history.front(), r0.history.back());
+
+    BiCGSTAB bicg;
+    GMRES gmres(IterativeOptions { 1e-10, 2000, 20 });
+    IterativeResult r3, r4, r5;
+    Vector x3 = bicg.solve(B, c, Ilu0Preconditioner(B), &r3);
+    Vector x4 = gmres.solve(B, c, IdentityPreconditioner(), &r4);
+    Vector x5 = gmres.solve(B, c, Ilu0Preconditioner(B), &r5);
+    fmt::print("bicgstab+ilu0 {}, errors {:.1e}\n", r3.to_string(), err(x3));
+    fmt::print("gmres(20) {}, +ilu0 {}; errors {:.1e} {:.1e}\n", r4.iterations, r5.iterations, err(x4), err(x5));
+
+    // 稠密矩阵和函数对象作为算子, 以上一次的解为初始猜测再解一次, 应立即收敛
+    const Matrix D = B.to_dense();
+    const auto op = [&](const double* x, double* y) { B.multiply(x, y); };
+    Vector x6, x7;
+    IterativeResult r6 = gmres.solve(D, c, x6);
+    IterativeResult r7 = bicg.solve(op, c, x7, JacobiPreconditioner(B));
+    IterativeResult r8 = bicg.solve(op, c, x7);
+    fmt::print("dense gmres {}, lambda bicgstab {}, warm restart {}; errors {:.1e} {:.1e}\n",
+               r6.iterations, r7.iterations, r8.iterations, err(x6), err(x7));
+
+    // CSC 的散射用求解器自己的工作区, 第二次求解不再分配
+    const CscMatrix Bc(B);
+    const Ilu0Preconditioner ilu(B);
+    Vector x9(n);
+    IterativeResult r9 = bicg.solve(Bc, c, x9, ilu);
+    std::fill(x9.data(), x9.data() + n, 0.0);
+    const size_t before = allocation_count();
+    r9 = bicg.solve(Bc, c, x9, ilu);
+    fmt::print("csc bicgstab {} iters (csr {}), error {:.1e}, allocations {}\n",
+               r9.iterations, r3.iterations, err(x9), allocation_count() - before); // 0
+
+    // 对角元不在非零结构中或不是方阵时, ILU(0) 报错而不是越界读写
+    bool no_diag = false, not_square = false;
+    try { const Ilu0Preconditioner bad(CsrMatrix::from_triplets(3, 3, { { 0, 0, 1.0 }, { 1, 0, 1.0 }, { 2, 2, 1.0 } })); }
+    catch (const std::invalid_argument&) { no_diag = true; }
+    try { const Ilu0Preconditioner bad(CsrMatrix(3, 2)); } catch (const std::invalid_argument&) { not_square = true; }
+    fmt::print("ilu0 throws {} {}\n", no_diag, not_square); // true true
+}
+
+void test_workspace() {
+    const size_t n = 100;
+    Matrix A(n, n), B(n, 4);
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < n; j++) A(i, j) = std::sin(double(i * n + j));
+        for (size_t j = 0; j < 4; j++) B(i, j) = std::cos(double(i + j));
+        A(i, i) += 5.0;
+    }
+    const Vector b = B.get_n_col_vector(0);
+    std::vector<double> p(300), q(200), r(499), s(40), t(70), u(109);
+    for (size_t i = 0; i < p.size(); i++) p[i] = std::sin(double(i));
+    for (size_t i = 0; i < q.size(); i++) q[i] = std::cos(double(i));
+
+    Workspace ws;
+    Vector x;
+    Matrix X, Ainv, LU;
+    LUFactorization f;
+    double det = 0.0;
+    // 第一轮让工作区和输出增长到需要的大小, 之后的循环不应再有分配
+    auto step = [&] {
+        A.LU_solve_into(b, x, ws);
+        A.LU_solve_into(B, X, ws);
+        A.inv_into(Ainv, ws);
+        det = A.det(ws);
+        A.LU_decomp_into(LU);
+        f.factorize(A);
+        f.solve_into(B, X);
+        poly_mul(p.data(), p.size(), q.data(), q.size(), r.data(), ws);  // FFT
+        poly_mul(s.data(), s.size(), t.data(), t.size(), u.data(), ws, PolyMulAlgo::Karatsuba);
+        poly_mul(p.data(), p.size(), q.data(), q.size(), r.data()); // 不传 ws 时用调用线程的工作区
+    };
+    step();
+    const size_t before = allocation_count();
+    for (int it = 0; it < 10; it++) step();
+    const size_t allocs = allocation_count() - before;
+
+    auto max_diff = [](const Matrix& M, const Matrix& N) {
+        double e = 0.0;
+        for (size_t i = 0; i < M.rows(); i++)
+            for (size_t j = 0; j < M.cols(); j++) e = std::max(e, std::abs(M(i, j) - N(i, j)));
+        return e;
+    };
+    const Vector x0 = A.LU_solve(b);
+    double ex = 0.0;
+    for (size_t i = 0; i < n; i++) ex = std::max(ex, std::abs(x(i) - x0(i)));
+    const std::vector<double> r0 = poly_mul(p, q);
+    double ep = 0.0;
+    for (size_t i = 0; i < r.size(); i++) ep = std::max(ep, std::abs(r[i] - r0[i]));
+    fmt::print("workspace: counter active {}, {} allocations in 10 steady-state rounds, peak {} KB in {} block\n",
+               before > 0, allocs, ws.peak() / 1024, ws.capacity() == ws.peak() ? "one" : "several");
+    fmt::print("workspace diffs: solve {:.1e} inv {:.1e} det {:.1e} LU {:.1e} polymul {:.1e}\n", ex,
+               max_diff(Ainv, A.inv()), std::abs(det / A.det() - 1.0), max_diff(LU, A.LU_decomp()), ep);
+    // 工作线程的打包缓冲区也必须在第一轮之前就位, 否则这里的计数取决于调度
+    if (allocs != 0) {
+        fmt::print(stderr, "workspace: expected 0 steady-state allocations, got {}\n", allocs);
+        std::exit(1);
+    }
+}
+
+void test_triangular() {
+    // 150 不是分块大小的整数倍; 另一半三角和 Unit 时的对角线填成 100, 若被读到残差会很大
+    const size_t n = 150, m = 9;
+    const Matrix R = random_matrix(n, n, 11);
+    double worst = 0.0;
+    for (Side side : { Side::Left, Side::Right })
+        for (Uplo uplo : { Uplo::Lower, Uplo::Upper })
+            for (Trans trans : { Trans::No, Trans::Yes })
+                for (Diag diag : { Diag::NonUnit, Diag::Unit }) {
+                    Matrix A(n, n), op(n, n);
+                    for (size_t i = 0; i < n; i++)
+                        for (size_t j = 0; j < n; j++) {
+                            const bool in = uplo == Uplo::Lower ? j <= i : j >= i;
+                            double v = in ? 0.1 * R(i, j) : 0.0;  // 缩小非对角元, 随机的单位三角阵条件数极大
+                            if (i == j) v = diag == Diag::Unit ? 1.0 : R(i, i) + 2.0;
+                            A(i, j) = in && !(i == j && diag == Diag::Unit) ? v : 100.0;
+                            if (trans == Trans::Yes) op(j, i) = v; else op(i, j) = v;
+                        }
+                    const Matrix B = side == Side::Left ? random_matrix(n, m, 12) : random_matrix(m, n, 12);
+                    Matrix X = B;
+                    trsm(side, uplo, trans, diag, 0.5, A, X);
+                    const Matrix P = side == Side::Left ? Matrix(op * X) : Matrix(X * op);
+                    worst = std::max(worst, max_abs_diff(P, 0.5 * B));
+                }
+    fmt::print("trsm 16 cases worst residual {:.3e}\n", worst);
+
+    // 步长为 2 的向量视图: 只有偶数位置被改写
+    Matrix L = random_matrix(n, n, 13);
+    for (size_t i = 0; i < n; i++) L(i, i) += 4.0;
+    Vector buf(2 * n);
+    for (size_t i = 0; i < 2 * n; i++) buf(i) = double(i % 7);
+    const Vector b = buf;
+    trsv(Uplo::Upper, Trans::Yes, Diag::NonUnit, L.view(), VectorView(buf.data(), n, 2));
+    double ev = 0.0, eodd = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        double s = 0.0;
+        for (size_t r = 0; r <= i; r++) s += L(r, i) * buf(2 * r);
+        ev = std::max(ev, std::abs(s - b(2 * i)));
+        eodd = std::max(eodd, std::abs(buf(2 * i + 1) - b(2 * i + 1)));
+    }
+    fmt::print("trsv strided residual {:.3e} untouched {}\n", ev, eodd == 0.0);
+
+    for (size_t k : { size_t(1), size_t(63), size_t(130) }) {
+        Matrix M = random_matrix(k, k, 14), I(k, k);
+        for (size_t i = 0; i < k; i++) I(i, i) = 1;
+        fmt::print("inv {} residual {:.3e}\n", k, max_abs_diff(M * M.inv(), I));
+    }
+}
+
+void test_eigen() {
+    auto rnd = [](size_t r, size_t c, uint64_t seed) {
+        Matrix M(r, c);
+        uint64_t x = seed;
+        for (size_t i = 0; i < r; i++) {
+            for (size_t j = 0; j < c; j++) {
+                x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+                M(i, j) = double(x >> 11) / double(1ULL << 53) - 0.5;
+            }
+        }
+        return M;
+    };
+    // max |A V - V diag(w)| 和 max |V^T V - I|
+    auto check_eigh = [](const Matrix& A, const EighResult& r) {
+        const size_t n = A.rows();
+        Matrix AV = A * r.vectors, VtV = r.vectors.T() * r.vectors;
+        double e0 = 0.0, e1 = 0.0;
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = 0; j < n; j++) {
+                e0 = std::max(e0, std::abs(AV(i, j) - r.vectors(i, j) * r.values(j)));
+                e1 = std::max(e1, std::abs(VtV(i, j) - (i == j ? 1.0 : 0.0)));
+            }
+        }
+        bool sorted = true;
+        for (size_t j = 1; j < n; j++) sorted = sorted && r.values(j - 1) <= r.values(j);
+        return fmt::format("residual {:.1e} orthogonality {:.1e} sorted {}", e0, e1, sorted);
+    };
+    auto check_svd = [](const Matrix& A, const SVDResult& r) {
+        const size_t k = r.S.size();
+        Matrix US = r.U;
+        for (size_t i = 0; i < US.rows(); i++)
+            for (size_t j = 0; j < k; j++) US(i, j) *= r.S(j);
+        Matrix D = US * r.V.T() - A, UtU = r.U.T() * r.U, VtV = r.V.T() * r.V;
+        double e0 = 0.0, e1 = 0.0;
+        for (size_t i = 0; i < D.rows(); i++)
+            for (size_t j = 0; j < D.cols(); j++) e0 = std::max(e0, std::abs(D(i, j)));
+        for (size_t i = 0; i < k; i++) {
+            for (size_t j = 0; j < k; j++) {
+                e1 = std::max(e1, std::abs(UtU(i, j) - (i == j ? 1.0 : 0.0)));
+                e1 = std::max(e1, std::abs(VtV(i, j) - (i == j ? 1.0 : 0.0)));
+            }
+        }
+        bool sorted = true;
+        for (size_t j = 1; j < k; j++) sorted = sorted && r.S(j - 1) >= r.S(j) && r.S(j) >= 0.0;
+        return fmt::format("reconstruction {:.1e} orthogonality {:.1e} sorted {}", e0, e1, sorted);
+    };
+
+    // 3x3: 特征值 2, 2, 4
+    Matrix S3({ { 2, 0, 0 }, { 0, 3, 1 }, { 0, 1, 3 } });
+    EighResult r3 = S3.eigh();
+    fmt::print("eigh 3x3 values {:.6f} {:.6f} {:.6f}\n", r3.values(0), r3.values(1), r3.values(2)); // 2 2 4
+    // 随机对称矩阵, 大小跨过分块和分治的阈值
+    for (size_t n : { 1, 7, 40, 150 }) {
+        Matrix X = rnd(n, n, n);
+        Matrix A = X + X.T();
+        EighResult r = A.eigh();
+        Vector w = A.eigvalsh();
+        double dw = 0.0;
+        for (size_t i = 0; i < n; i++) dw = std::max(dw, std::abs(w(i) - r.values(i)));
+        fmt::print("eigh n {}: {}, eigvalsh diff {:.1e}\n", n, check_eigh(A, r), dw);
+    }
+    // I + u u^T: 特征值 1 重复 n - 1 次, 分治合并时几乎全部收缩
+    {
+        const size_t n = 120;
+        Matrix u = rnd(n, 1, 7);
+        Matrix A = u * u.T();
+        for (size_t i = 0; i < n; i++) A(i, i) += 1.0;
+        EighResult r = A.eigh();
+        fmt::print("eigh repeated: {}, min {:.6f} max - 1 - |u|^2 {:.1e}\n", check_eigh(A, r), r.values(0),
+                   r.values(n - 1) - 1.0 - (u.T() * u)(0, 0));
+    }
+
+    // 高矩阵, 宽矩阵, 秩为 5 的矩阵
+    Matrix T = rnd(90, 60, 11), W = rnd(45, 70, 12);
+    Matrix L = rnd(80, 5, 13) * rnd(5, 50, 14);
+    SVDResult st = T.svd(), sw = W.svd(), sl = L.svd();
+    fmt::print("svd 90x60: {}\n", check_svd(T, st));
+    fmt::print("svd 45x70: {}\n", check_svd(W, sw));
+    fmt::print("svd rank 5: {}, s(4) {:.3f} s(5) {:.1e}\n", check_svd(L, sl), sl.S(4), sl.S(5));
+    Vector sv = T.singular_values();
+    double ds = 0.0;
+    for (size_t i = 0; i < sv.size(); i++) ds = std::max(ds, std::abs(sv(i) - st.S(i)));
+    // 对称矩阵的奇异值是特征值的绝对值
+    EighResult es = (T.T() * T).eigh();
+    double de = 0.0;
+    for (size_t i = 0; i < 60; i++) de = std::max(de, std::abs(std::sqrt(std::max(es.values(59 - i), 0.0)) - st.S(i)));
+    fmt::print("singular_values diff {:.1e}, sqrt(eig(T^T T)) diff {:.1e}\n", ds, de);
+    fmt::print("converged {} {} {} {}\n", st.converged, sw.converged, sl.converged, es.converged); // true x4
+    // 大小跨过双对角分治阈值的矩阵, 以及奇异值 1 重复 n - 1 次的 I + u v^T (合并时几乎全部收缩)
+    {
+        Matrix B = rnd(200, 150, 16);
+        SVDResult sb = B.svd();
+        Vector wb = B.singular_values();
+        double db = 0.0;
+        for (size_t i = 0; i < wb.size(); i++) db = std::max(db, std::abs(wb(i) - sb.S(i)));
+        fmt::print("svd 200x150: {}, singular_values diff {:.1e}\n", check_svd(B, sb), db);
+        const size_t n = 120;
+        Matrix R = rnd(n, 1, 17) * rnd(1, n, 18);
+        for (size_t i = 0; i < n; i++) R(i, i) += 1.0;
+        SVDResult sr = R.svd();
+        fmt::print("svd repeated: {}, s(1) {:.6f} s(n-2) {:.6f}\n", check_svd(R, sr), sr.S(1), sr.S(n - 2)); // 1 1
+    }
+
+    // 随机化 SVD: 秩 5 的矩阵加很小的噪声, 前 5 个奇异值应与完整 SVD 一致
+    Matrix N = L + 1e-6 * rnd(80, 50, 15);
+    SVDResult sn = N.svd(), rs = randomized_svd(N, 5);
+    double dr = 0.0;
+    for (size_t i = 0; i < 5; i++) dr = std::max(dr, std::abs(sn.S(i) - rs.S(i)) / sn.S(i));
+    fmt::print("randomized svd top-5 relative diff {:.1e}, U {}x{}, V {}x{}\n", dr, rs.U.rows(), rs.U.cols(),
+               rs.V.rows(), rs.V.cols());
+}
+
+void test_int_polynomial() {
+    // NTT 与朴素乘法的结果必须完全一致
+    using M = ModInt998244353;
+    using M7 = ModInt<1000000007>; // 不是 NTT 素数, 走三素数 CRT
+    std::vector<M> a(300), b(500);
+    std::vector<M7> a7(300), b7(500);
+    std::vector<int64_t> ia(300), ib(500);
+    for (size_t i = 0; i < a.size(); i++) { a[i] = M(i * i + 7); a7[i] = M7(i * 12345 + 1); ia[i] = int64_t(i * 7919) - 1000000; }
+    for (size_t i = 0; i < b.size(); i++) { b[i] = M(3 * i + 1); b7[i] = M7(i * 777 + 5); ib[i] = int64_t(i * i) * (i % 2 ? -1 : 1); }
+    auto ok = [](auto& x, auto& y) {
+        using T = typename std::decay_t<decltype(x)>::value_type;
+        std::vector<T> naive(x.size() + y.size() - 1, T(0));
+        for (size_t i = 0; i < x.size(); i++)
+            for (size_t j = 0; j < y.size(); j++) naive[i + j] += x[i] * y[j];
+        return detail::exact_mul(x, y) == naive;
+    };
+    fmt::print("ntt mod p {}, crt mod 1e9+7 {}, crt int64 {}\n", ok(a, b), ok(a7, b7), ok(ia, ib)); // true true true
+    // 长度不是 2 的幂, 或超过素数支持的最大长度 (998244353 是 2^23)
+    bool not_pow2 = false, too_long = false;
+    try { ntt_plan<ntt_prime>(12); } catch (const std::invalid_argument&) { not_pow2 = true; }
+    try { ntt_plan<ntt_prime>(size_t(1) << 24); } catch (const std::length_error&) { too_long = true; }
+    fmt::print("ntt plan throws {} {}\n", not_pow2, too_long); // true true
+
+    // (1 + x)^20 的系数是二项式系数
+    auto p = IntPolynomial<int64_t>({ 1, 1 }) ^ 20;
+    fmt::print("C(20, 10) = {}\n", p.coef()[10]); // 184756
+    IntPolynomial<int64_t>({ 3, -2, 1 }).print();
+    (ModPolynomial<ntt_prime>({ M(1), M(1) }) ^ 3).derivative().print(); // 3 x^2 + 6 x + 3
+}
+
+void test_poly_eval() {
+    // 批量求值与逐点 Horner 比较, 点数覆盖 SIMD 的整组和余下的尾部
+    std::vector<double> c(37);
+    for (size_t i = 0; i < c.size(); i++) c[i] = std::cos(i * 0.9) / (i + 1);
+    Polynomial p(c);
+    std::vector<double> xs(1003);
+    for (size_t i = 0; i < xs.size(); i++) xs[i] = std::sin(i * 0.37);
+    auto ys = p.evaluate(xs);
+    double err = 0.0;
+    for (size_t i = 0; i < xs.size(); i++) err = std::max(err, std::abs(ys[i] - p(xs[i])));
+    fmt::print("horner max error {:.3e}\n", err);
+
+    // 子乘积树: 少量分布良好的点上与 Horner 一致
+    std::vector<double> q { 2, -3, 0, 1, 5, -1, 4, 0.5, 1, -2 };
+    std::vector<double> pts { -1, -0.5, 0, 0.5, 1, 1.5, -1.5, 0.25 };
+    auto y1 = Polynomial(q).evaluate(pts, PolyEvalMode::Horner);
+    poly_eval_thresholds().leaf = 2;
+    auto y2 = Polynomial(q).evaluate(pts, PolyEvalMode::SubproductTree);
+    poly_eval_thresholds().leaf = 64;
+    err = 0.0;
+    for (size_t i = 0; i < pts.size(); i++) err = std::max(err, std::abs(y1[i] - y2[i]));
+    fmt::print("subproduct tree max error {:.3e}\n", err);
+}
+
+void test_poly_division() {
+    // (x^2 - 1) / (x - 1) = x + 1
+    auto [q, r] = Polynomial(std::vector<double>{ 1, 0, -1 }).divmod(Polynomial(std::vector<double>{ 1, -1 }));
+    q.print();
+    r.print(); // 0
+
+    // 大规模时走 Newton 迭代, 检查 a = q b + r
+    std::vector<double> ca(700), cb(300);
+    for (size_t i = 0; i < ca.size(); i++) ca[i] = std::cos(i * 0.3);
+    for (size_t i = 0; i < cb.size(); i++) cb[i] = std::sin(i * 0.7) + (i == 0 ? 2 : 0);
+    Polynomial a(ca), b(cb);
+    auto [q2, r2] = a.divmod(b);
+    std::vector<double> la(ca.rbegin(), ca.rend()), lb(cb.rbegin(), cb.rend()), q3, r3;
+    detail::poly_divmod_naive(la, lb, q3, r3);
+    auto c2 = q2.coef(), d2 = r2.coef();
+    double err = 0.0;
+    for (size_t i = 0; i < q3.size(); i++) err = std::max(err, std::abs(c2[c2.size() - 1 - i] - q3[i]));
+    for (size_t i = 0; i < r3.size(); i++) err = std::max(err, std::abs(d2[d2.size() - 1 - i] - r3[i]));
+    fmt::print("divmod deg {} / {} newton vs long division {:.3e}\n", a.deg(), b.deg(), err);
+    // 条件数很差的除式: rev(b) 的逆级数增长很快, Newton 的商失去全部有效数字, 应退回长除法
+    {
+        std::vector<double> cp(600), cm(300);
+        for (size_t i = 0; i < cp.size(); i++) cp[i] = std::sin(i * 1.3 + 0.5);
+        for (size_t i = 0; i < cm.size(); i++) cm[i] = std::sin(i * i * 0.37 + 1.1);
+        auto [q4, r4] = Polynomial(cp).divmod(Polynomial(cm));
+        std::vector<double> lp(cp.rbegin(), cp.rend()), lm(cm.rbegin(), cm.rend()), q5, r5;
+        detail::poly_divmod_naive(lp, lm, q5, r5);
+        auto c4 = q4.coef();
+        double e4 = 0.0, s4 = 0.0;
+        for (size_t i = 0; i < q5.size(); i++) {
+            e4 = std::max(e4, std::abs(c4[c4.size() - 1 - i] - q5[i]));
+            s4 = std::max(s4, std::abs(q5[i]));
+        }
+        fmt::print("ill-conditioned divmod |q| {:.1e}, relative diff from long division {:.1e}\n", s4, e4 / s4);
+    }
+
+    // gcd((x-1)(x-2), (x-1)(x+3)) = x - 1
+    gcd(Polynomial(std::vector<double>{ 1, -3, 2 }), Polynomial(std::vector<double>{ 1, 2, -3 })).print();
+    // x^10 mod (x^2 + 1) = -1
+    Polynomial(std::vector<double>{ 1, 0 }).pow_mod(10, Polynomial(std::vector<double>{ 1, 0, 1 })).print();
+
+    // 模 p: half-GCD 与 Euclid 结果一致, 公因式是构造出来的 g
+    using M = ModInt998244353;
+    auto rnd = [s = uint64_t(1)](size_t n) mutable {
+        std::vector<M> c(n);
+        for (auto& v : c) { s = s * 6364136223846793005ull + 1442695040888963407ull; v = M(s >> 33); }
+        return ModPolynomial<ntt_prime>(c);
+    };
+    auto g = rnd(150).monic(), u = rnd(900), v = rnd(700);
+    auto big_a = g * u, big_b = g * v;
+    auto [mq, mr] = big_a.divmod(big_b);
+    fmt::print("mod divmod exact {}\n", mq * big_b + mr == big_a);
+    fmt::print("half-gcd == g {}\n", gcd(big_a, big_b) == g); // u, v 随机, 几乎一定互素
+    fmt::print("pow_mod {}\n", u.pow_mod(1000, g) == ((u % g) ^ 1000) % g);
+
+    // 除以 0 多项式
+    bool real_throws = false, mod_throws = false;
+    try { Polynomial(std::vector<double>{ 1, 2, 3 }).divmod(Polynomial()); } catch (const std::domain_error&) { real_throws = true; }
+    try { u / ModPolynomial<ntt_prime>(); } catch (const std::domain_error&) { mod_throws = true; }
+    fmt::print("divide by zero throws {} {}\n", real_throws, mod_throws); // true true
+}
+
+void test_poly_roots() {
+    // (x - 1)(x - 2)(x - 3) 和 x^2 + 1
+    auto r = Polynomial(std::vector<double>{ 1, -6, 11, -6 }).roots();
+    std::sort(r.begin(), r.end(), [](auto a, auto b) { return a.real() < b.real(); });
+    for (auto z : r) fmt::print("({:.6f}, {:.6f}) ", z.real(), z.imag());
+    fmt::print("\n");
+    for (auto z : Polynomial(std::vector<double>{ 1, 0, 1 }).roots()) fmt::print("({:.6f}, {:.6f}) ", z.real(), z.imag());
+    fmt::print("\n");
+    // 0 根: x^3 - x^2 = x^2 (x - 1)
+    for (auto z : Polynomial(std::vector<double>{ 1, -1, 0, 0 }).roots()) fmt::print("({:.6f}, {:.6f}) ", z.real(), z.imag());
+    fmt::print("\n");
+
+    // 次数 200 的多项式: 检查 |p(z)| 相对于 sum |a_i| |z|^i 的后向误差
+    std::vector<double> c(201);
+    for (size_t i = 0; i < c.size(); i++) c[i] = std::cos(i * 1.3) + (i == 0 ? 2 : 0);
+    Polynomial p(c);
+    double err = 0.0;
+    for (auto z : p.roots()) {
+        complex v = 0.0;
+        double b = 0.0;
+        for (double a : c) {
+            v = v * z + a;
+            b = b * std::abs(z) + std::abs(a);
+        }
+        err = std::max(err, std::abs(v) / b);
+    }
+    fmt::print("roots deg 200 backward error {:.3e}\n", err);
+
+    // 批量: 1000 个 4 次多项式, 与逐个求解的根的集合一致
+    const size_t count = 1000, nc = 5;
+    std::vector<double> coefs(count * nc);
+    for (size_t i = 0; i < coefs.size(); i++) coefs[i] = std::sin(i * 0.77) + (i % nc == 0 ? 1.5 : 0);
+    std::vector<complex> batch(count * (nc - 1));
+    poly_roots_batch(coefs.data(), count, nc, batch.data());
+    double diff = 0.0;
+    for (size_t i = 0; i < count; i++) {
+        std::vector<complex> single(nc - 1);
+        poly_roots(coefs.data() + i * nc, nc, single.data());
+        for (size_t k = 0; k < nc - 1; k++) {
+            double best = inf;
+            for (size_t j = 0; j < nc - 1; j++) best = std::min(best, std::abs(batch[i * (nc - 1) + k] - single[j]));
+            diff = std::max(diff, best);
+        }
+    }
+    fmt::print("batch vs single max diff {:.3e}\n", diff);
+}
+
+void test_poly_fit() {
+    // 无噪声的三次多项式, 拟合应该精确还原
+    std::vector<double> x(1000), y(1000);
+    Polynomial truth(std::vector<double>{ 0.5, -2, 3, 1 });
+    for (size_t i = 0; i < x.size(); i++) {
+        x[i] = -3 + 0.007 * i;
+        y[i] = truth(x[i]);
+    }
+    Polynomial::fit(x, y, 3).print(); // 0.5 x^3 - 2 x^2 + 3 x + 1
+
+    // 流式: 分块加入, 两个 fitter 合并, 与一次性拟合一致
+    PolynomialFitter f1(2, 1000.0, 10.0), f2(2, 1000.0, 10.0);
+    for (size_t i = 0; i < 500; i++) {
+        const double xi = 990.0 + 0.04 * i;
+        const double noise = 0.01 * std::sin(i * 12.9898);
+        const double yi = 3 * (xi - 1000) * (xi - 1000) + 2 + noise;
+        (i % 2 ? f1 : f2).add(xi, yi);
+    }
+    f1.merge(f2);
+    fmt::print("count {}, f(1000) = {:.4f}, f(1005) = {:.4f}, rss {:.3e}\n", f1.count(), f1(1000.0), f1(1005.0), f1.rss()); // 2, 77
+}
+
+void test_expr() {
+    Vector a(std::vector<double>{ 1, 2, 3 }), b(std::vector<double>{ 4, 5, 6 });
+    // 表达式可以保存下来再求值, 右值操作数按值保存
+    auto e = a - 2.5 * b + Vector(std::vector<double>{ 1, 1, 1 });
+    e.print(); // ( -8, -9.5, -11 )
+    Vector c = e;
+    c += 2.0 * a; // ( -6, -5.5, -5 )
+    c = c - a;    // 表达式中出现自己, 逐元素计算不受影响
+    c.print();    // ( -7, -7.5, -8 )
+    fmt::print("{}\n", (a + b).transpose() * b); // 5 * 4 + 7 * 5 + 9 * 6 = 109
+
+    Matrix A({ { 1, 2 }, { 3, 4 } }), B({ { 0, 1 }, { 1, 0 } });
+    Matrix C = A + 2.0 * B - A;
+    C.print(); // 2 * B
+    ((A - B) * B).print(); // [ 1, 1; 4, 2 ]
+}
+
+void test_transpose() {
+    // 大小不是块大小的整数倍, 检查边界
+    const size_t r = 70, c = 45;
+    Matrix A(r, c), B(r, 30);
+    for (size_t i = 0; i < r; i++) {
+        for (size_t j = 0; j < c; j++) A(i, j) = std::sin(double(i * c + j));
+        for (size_t j = 0; j < 30; j++) B(i, j) = std::cos(double(i + j));
+    }
+    Matrix At = A.T();
+    bool same = At.rows() == c && At.cols() == r;
+    for (size_t i = 0; i < r; i++)
+        for (size_t j = 0; j < c; j++) same = same && At(j, i) == A(i, j);
+
+    // 原地转置: 方阵和非方阵
+    Matrix S(100, 100);
+    for (size_t i = 0; i < 100; i++)
+        for (size_t j = 0; j < 100; j++) S(i, j) = double(i * 100 + j);
+    Matrix S0 = S;
+    S.transpose_in_place();
+    Matrix A2 = A;
+    A2.transpose_in_place();
+    bool in_place = A2.rows() == c;
+    for (size_t i = 0; i < 100; i++)
+        for (size_t j = 0; j < 100; j++) in_place = in_place && S(i, j) == S0(j, i);
+    for (size_t i = 0; i < c; i++)
+        for (size_t j = 0; j < r; j++) in_place = in_place && A2(i, j) == At(i, j);
+    fmt::print("transpose {}x{} {}, in place {}\n", r, c, same, in_place);
+
+    // A^T B 不形成 A^T, 与先转置再相乘比较; A^T x 同理
+    Matrix P = A.T() * B, Q = At * B;
+    Vector x(std::vector<double>(r, 1.0));
+    Vector y = A.T() * x, z = At * x;
+    double e0 = 0.0, e1 = 0.0;
+    for (size_t i = 0; i < c; i++) {
+        for (size_t j = 0; j < 30; j++) e0 = std::max(e0, std::abs(P(i, j) - Q(i, j)));
+        e1 = std::max(e1, std::abs(y(i) - z(i)));
+    }
+    fmt::print("A^T B diff {:.1e}, A^T x diff {:.1e}\n", e0, e1);
+    // 列数跨过几个 GEMV 列块, 行数不是 4 的倍数
+    {
+        Matrix W(203, 1100);
+        Vector v(203);
+        for (size_t i = 0; i < 203; i++) {
+            v(i) = std::cos(double(i));
+            for (size_t j = 0; j < 1100; j++) W(i, j) = std::sin(double(i * 1100 + j));
+        }
+        Vector w = W.T() * v;
+        double e2 = 0.0;
+        for (size_t j = 0; j < 1100; j++) {
+            double s = 0.0;
+            for (size_t i = 0; i < 203; i++) s += W(i, j) * v(i);
+            e2 = std::max(e2, std::abs(w(j) - s));
+        }
+        fmt::print("A^T x 203x1100 diff {:.1e}\n", e2);
+    }
+
+    // 自己出现在含转置的表达式中: 先求值再赋值, 结果是对称的
+    S = S + S.T();
+    S -= 0.5 * S.T();
+    fmt::print("S + S^T symmetric {}, S(1, 2) {}\n", S.is_symmetric(), S(1, 2)); // (102 + 201) / 2 = 151.5
+
+    // 向量转置不拷贝
+    Vector v(std::vector<double>{ 1, 2, 3 });
+    const double* p = v.data();
+    const bool view = v.transpose().data() == p;
+    RowVector w = std::move(v).transpose();
+    fmt::print("vector transpose shares storage {} {}\n", view, w.data() == p);
+}
+
+void test_vector_products() {
+    Vector u(std::vector<double>{ 1, 2, 3 });
+    RowVector v(std::vector<double>{ 4, 5 });
+    double d = u.transpose() * u;
+    fmt::print("{}\n", d); // 14
+
+    // 外积是矩阵表达式, 可以直接累加
+    Matrix G = u * v;
+    G.print(); // [ 4, 5; 8, 10; 12, 15 ]
+    G += (2.0 * u) * v;
+    G.print(); // [ 12, 15; 24, 30; 36, 45 ]
+
+    // rank-1 / rank-k 更新与逐个外积累加的结果相同
+    Matrix U({ { 1, 0 }, { 2, 1 }, { 0, 3 } }), V({ { 1, 1 }, { 2, -1 } });
+    Matrix H(3, 2), K(3, 2);
+    for (size_t p = 0; p < 2; p++) {
+        H += U.get_n_col_vector(p) * V.get_n_row_vector(p);
+    }
+    rank_k_update(1.0, U, V, K);
+    H.print();
+    K.print(); // [ 1, 1; 4, 1; 6, -3 ]
+    Matrix R(3, 2);
+    ger(2.0, U.col(1), V.row(1), R.view());
+    R.print(); // [ 0, 0; 4, -2; 12, -6 ]
+    ger(1.0, U.col(1), U.col(0).segment(0, 2), R.view()); // 不连续的 y
+    R.print(); // [ 0, 0; 5, 0; 15, 0 ]
+
+    // Gram 矩阵 X^T X
+    Matrix X({ { 1, 2 }, { 3, 4 }, { 5, 6 } });
+    gram(X).print(); // [ 35, 44; 44, 56 ]
+    (X * Vector(std::vector<double>{ 1, -1 })).print(); // ( -1, -1, -1 )
+}
+
 int main() {
     // test_fft();
     // test_polynomial();
     // test_linalg();
     test_vec2();
+    test_fixed();
+    test_vec3_batch();
+    test_transform();
+    test_matrix();
+    test_expr();
+    test_transpose();
+    test_vector_products();
+    test_gemm();
+    test_thread_pool();
+    test_lu();
+    test_workspace();
+    test_triangular();
+    test_eigen();
+    test_cholesky();
+    test_sparse();
+    test_krylov();
+    test_fft_plan();
+    test_rfft();
+    test_poly_mul();
+    test_int_polynomial();
+    test_poly_eval();
+    test_poly_division();
+    test_poly_roots();
+    test_poly_fit();
 }
\ No newline at end of file